@@ -33,13 +33,19 @@
 #include "Wallet.hpp"
 #include "account/Account.hpp"
 #include "account/AccountSettings.hpp"
+#include "bitcoin/HdChain.hpp"
 #include "bitcoin/Text.hpp"
 #include "bitcoin/WatcherBridge.hpp"
 #include "crypto/Crypto.hpp"
+#include "crypto/Random.hpp"
 #include "exchange/Exchange.hpp"
+#include "json/JsonFile.hpp"
 #include "util/Debug.hpp"
 #include "util/FileIO.hpp"
 #include "util/Mutex.hpp"
+#include "util/RecordLog.hpp"
+#include "util/SearchIndex.hpp"
+#include "util/TimeIndex.hpp"
 #include "util/Util.hpp"
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,8 +54,13 @@
 #include <string.h>
 #include <qrencode.h>
 #include <wallet/wallet.hpp>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace abcd {
 
@@ -59,13 +70,12 @@ namespace abcd {
 
 #define TX_MAX_AMOUNT_LENGTH                    100 // should be max length of a bit coin amount string
 #define TX_MAX_CATEGORY_LENGTH                  512
+#define TX_MAX_CURSOR_LENGTH                    128 // <timeCreation>:<ntxid>
 
 #define TX_INTERNAL_SUFFIX                      "-int.json" // the transaction was created by our direct action (i.e., send)
 #define TX_EXTERNAL_SUFFIX                      "-ext.json" // the transaction was created due to events in the block-chain (usually receives)
 
-#define ADDRESS_FILENAME_SEPARATOR              '-'
-#define ADDRESS_FILENAME_SUFFIX                 ".json"
-#define ADDRESS_FILENAME_MIN_LEN                8 // <id>-<public_addr>.json
+#define TX_LOG_WRITER_FILENAME                  "LogWriter"
 
 #define JSON_DETAILS_FIELD                      "meta"
 #define JSON_CREATION_DATE_FIELD                "creationDate"
@@ -145,108 +155,187 @@ typedef struct sABC_TxAddress
     tTxAddressStateInfo *pStateInfo;
 } tABC_TxAddress;
 
+static void     ABC_TxFreeTx(tABC_Tx *pTx);
+static void     ABC_TxFreeAddress(tABC_TxAddress *pAddress);
+
+/**
+ * One transaction's share of the wallet balance.
+ */
+struct TxBalance
+{
+    int64_t amount;
+    bool bPending;      // Not in a block yet, so the watcher could drop it
+};
+
+/**
+ * In-memory copy of a wallet's transaction files, as they appear on disk.
+ * Built once from the transaction directory and kept current by
+ * ABC_TxSaveTransaction, so reads don't have to scan and decrypt the
+ * whole directory. Protected by gCoreMutex, like the rest of this module.
+ */
+struct TxIndex
+{
+    ~TxIndex()
+    {
+        for (auto &i: txs)
+            ABC_TxFreeTx(i.second);
+    }
+
+    /** Transactions by ntxid. The index owns these. */
+    std::map<std::string, tABC_Tx *> txs;
+    /** (timeCreation, ntxid) pairs, in display order. */
+    TimeIndex byTime;
+    /** Searchable text for each transaction, by ntxid. */
+    SearchIndex search;
+
+    /**
+     * What each transaction the watcher knows about adds to the balance,
+     * by ntxid. Only valid if balanceLoaded is set.
+     */
+    std::map<std::string, TxBalance> balances;
+    /**
+     * (malleable txid, ntxid) pairs linking each transaction
+     * to the transactions that spend from it. The watcher can only value
+     * a transaction's inputs once it has seen the parent,
+     * so the spenders need re-counting when a parent shows up.
+     */
+    std::set<std::pair<std::string, std::string>> spenders;
+    /** The sum of the balances. */
+    int64_t balance = 0;
+    bool balanceLoaded = false;
+};
+
+// this holds the indexes for all loaded wallets, by wallet UUID
+static std::map<std::string, TxIndex> gTxIndexes;
+
+// this holds the transaction logs for all loaded wallets, by wallet UUID
+// (the entry is null if the wallet still uses one file per record)
+static std::map<std::string, std::unique_ptr<RecordLog>> gTxLogs;
+
+// this holds the address chains for all loaded wallets, by wallet UUID
+static std::map<std::string, std::unique_ptr<HdChain>> gTxChains;
+
+/**
+ * In-memory copy of a wallet's addresses, built once from the address
+ * directory and kept current by ABC_TxSaveAddress. This lets requests
+ * find a free address, an open request, or an address's owner without
+ * decrypting every address file. Protected by gCoreMutex.
+ */
+struct TxAddressIndex
+{
+    ~TxAddressIndex()
+    {
+        for (auto &i: addresses)
+            ABC_TxFreeAddress(i.second);
+    }
+
+    /** Addresses by sequence number. The index owns these. */
+    std::map<int32_t, tABC_TxAddress *> addresses;
+    /** Sequence numbers by public address. */
+    std::unordered_map<std::string, int32_t> seqs;
+    /** Unused addresses that can go out with the next request, lowest first. */
+    std::set<int32_t> recyclable;
+    /** The amount still owed on each open request, by sequence number. */
+    std::map<int32_t, int64_t> owed;
+};
+
+// this holds the address indexes for all loaded wallets, by wallet UUID
+static std::map<std::string, TxAddressIndex> gTxAddressIndexes;
+
 static tABC_CC  ABC_TxCreateNewAddress(tABC_WalletID self, tABC_TxDetails *pDetails, tABC_TxAddress **ppAddress, tABC_Error *pError);
-static tABC_CC  ABC_TxCreateNewAddressForN(tABC_WalletID self, int32_t N, tABC_Error *pError);
-static tABC_CC  ABC_GetAddressFilename(const char *szWalletUUID, const char *szRequestID, char **pszFilename, tABC_Error *pError);
-static tABC_CC  ABC_TxParseAddrFilename(const char *szFilename, char **pszID, char **pszPublicAddress, tABC_Error *pError);
+static tABC_CC  ABC_TxCreateNewAddresses(tABC_WalletID self, int32_t first, unsigned int count, tABC_Error *pError);
 static tABC_CC  ABC_TxSetAddressRecycle(tABC_WalletID self, const char *szAddress, bool bRecyclable, tABC_Error *pError);
-static tABC_CC  ABC_TxCheckForInternalEquivalent(const char *szFilename, bool *pbEquivalent, tABC_Error *pError);
+static tABC_CC  ABC_TxCheckForInternalEquivalent(tABC_WalletID self, const char *szFilename, bool *pbEquivalent, tABC_Error *pError);
 static tABC_CC  ABC_TxGetTxTypeAndBasename(const char *szFilename, tTxType *pType, char **pszBasename, tABC_Error *pError);
-static tABC_CC  ABC_TxLoadTransactionInfo(tABC_WalletID self, const char *szFilename, tABC_TxInfo **ppTransaction, tABC_Error *pError);
-static tABC_CC  ABC_TxLoadTxAndAppendToArray(tABC_WalletID self, int64_t startTime, int64_t endTime, const char *szFilename, tABC_TxInfo ***paTransactions, unsigned int *pCount, tABC_Error *pError);
+static tABC_CC  ABC_TxIndexLoad(tABC_WalletID self, TxIndex **ppIndex, tABC_Error *pError);
+static tABC_CC  ABC_TxIndexUpdate(tABC_WalletID self, const tABC_Tx *pTx, tABC_Error *pError);
+static std::list<std::string> ABC_TxSearchFields(const tABC_Tx *pTx);
+static tABC_CC  ABC_TxBalanceCount(tABC_WalletID self, TxIndex *pIndex, const tABC_Tx *pTx, tABC_Error *pError);
+static void     ABC_TxBalanceRecount(tABC_WalletID self, const std::set<std::string> &ids);
+static void     ABC_TxBalanceUpdate(tABC_WalletID self, const char *szID);
+static void     ABC_TxBalanceReset(TxIndex *pIndex);
+static tABC_CC  ABC_TxStoreLog(tABC_WalletID self, RecordLog **ppLog, tABC_Error *pError);
+static tABC_CC  ABC_TxStoreWriter(tABC_WalletID self, std::string &writer, tABC_Error *pError);
+static bool     ABC_TxStoreUseLog(RecordLog *pLog, const char *szFilename);
+static tABC_CC  ABC_TxStoreExists(tABC_WalletID self, const char *szFilename, bool *pbExists, tABC_Error *pError);
+static tABC_CC  ABC_TxStoreList(tABC_WalletID self, const char *szDir, tABC_FileIOList **ppFileList, tABC_Error *pError);
+static tABC_CC  ABC_TxStoreJob(tABC_WalletID self, const char *szFilename, tABC_U08Buf MK, DecryptJob &job, tABC_Error *pError);
+static tABC_CC  ABC_TxStoreLoad(tABC_WalletID self, const char *szFilename, tABC_U08Buf MK, json_t **ppJSON_Data, tABC_Error *pError);
+static tABC_CC  ABC_TxStoreSave(tABC_WalletID self, json_t *pJSON_Data, tABC_U08Buf MK, const char *szFilename, tABC_Error *pError);
+static tABC_CC  ABC_TxStoreDelete(tABC_WalletID self, const char *szFilename, tABC_Error *pError);
+static tABC_CC  ABC_TxDupTx(tABC_Tx **ppNewTx, const tABC_Tx *pOldTx, tABC_Error *pError);
+static tABC_CC  ABC_TxCreateTxInfo(tABC_WalletID self, const tABC_Tx *pTx, tABC_TxInfo **ppTransaction, tABC_Error *pError);
 static tABC_CC  ABC_TxGetAddressOwed(tABC_TxAddress *pAddr, int64_t *pSatoshiBalance, tABC_Error *pError);
 static tABC_CC  ABC_TxBuildFromLabel(tABC_WalletID self, char **pszLabel, tABC_Error *pError);
 static void     ABC_TxFreeRequest(tABC_RequestInfo *pRequest);
 static tABC_CC  ABC_TxCreateTxFilename(tABC_WalletID self, char **pszFilename, const char *szTxID, bool bInternal, tABC_Error *pError);
 static tABC_CC  ABC_TxLoadTransaction(tABC_WalletID self, const char *szFilename, tABC_Tx **ppTx, tABC_Error *pError);
+static tABC_CC  ABC_TxDecodeTransaction(json_t *pJSON_Root, tABC_Tx **ppTx, tABC_Error *pError);
 static tABC_CC  ABC_TxDecodeTxState(json_t *pJSON_Obj, tTxStateInfo **ppInfo, tABC_Error *pError);
 static tABC_CC  ABC_TxDecodeTxDetails(json_t *pJSON_Obj, tABC_TxDetails **ppDetails, tABC_Error *pError);
-static void     ABC_TxFreeTx(tABC_Tx *pTx);
-static tABC_CC  ABC_TxCreateTxDir(const char *szWalletUUID, tABC_Error *pError);
+static tABC_CC  ABC_TxCreateTxDir(tABC_WalletID self, tABC_Error *pError);
 static tABC_CC  ABC_TxSaveTransaction(tABC_WalletID self, const tABC_Tx *pTx, tABC_Error *pError);
 static tABC_CC  ABC_TxEncodeTxState(json_t *pJSON_Obj, tTxStateInfo *pInfo, tABC_Error *pError);
 static tABC_CC  ABC_TxEncodeTxDetails(json_t *pJSON_Obj, tABC_TxDetails *pDetails, tABC_Error *pError);
-static int      ABC_TxInfoPtrCompare (const void * a, const void * b);
 static tABC_CC  ABC_TxLoadAddress(tABC_WalletID self, const char *szAddressID, tABC_TxAddress **ppAddress, tABC_Error *pError);
 static tABC_CC  ABC_TxLoadAddressFile(tABC_WalletID self, const char *szFilename, tABC_TxAddress **ppAddress, tABC_Error *pError);
+static tABC_CC  ABC_TxDecodeAddress(json_t *pJSON_Root, tABC_TxAddress **ppAddress, tABC_Error *pError);
 static tABC_CC  ABC_TxDecodeAddressStateInfo(json_t *pJSON_Obj, tTxAddressStateInfo **ppState, tABC_Error *pError);
 static tABC_CC  ABC_TxSaveAddress(tABC_WalletID self, const tABC_TxAddress *pAddress, tABC_Error *pError);
 static tABC_CC  ABC_TxEncodeAddressStateInfo(json_t *pJSON_Obj, tTxAddressStateInfo *pInfo, tABC_Error *pError);
 static tABC_CC  ABC_TxCreateAddressFilename(tABC_WalletID self, char **pszFilename, const tABC_TxAddress *pAddress, tABC_Error *pError);
-static tABC_CC  ABC_TxCreateAddressDir(const char *szWalletUUID, tABC_Error *pError);
-static void     ABC_TxFreeAddress(tABC_TxAddress *pAddress);
+static tABC_CC  ABC_TxCreateAddressDir(tABC_WalletID self, tABC_Error *pError);
 static void     ABC_TxFreeAddressStateInfo(tTxAddressStateInfo *pInfo);
 static void     ABC_TxFreeAddresses(tABC_TxAddress **aAddresses, unsigned int count);
-static tABC_CC  ABC_TxGetAddresses(tABC_WalletID self, tABC_TxAddress ***paAddresses, unsigned int *pCount, tABC_Error *pError);
-static int      ABC_TxAddrPtrCompare(const void * a, const void * b);
-static tABC_CC  ABC_TxLoadAddressAndAppendToArray(tABC_WalletID self, const char *szFilename, tABC_TxAddress ***paAddresses, unsigned int *pCount, tABC_Error *pError);
+static tABC_CC  ABC_TxDupAddress(tABC_TxAddress **ppNewAddress, const tABC_TxAddress *pOldAddress, tABC_Error *pError);
+static tABC_CC  ABC_TxAddressIndexLoad(tABC_WalletID self, TxAddressIndex **ppIndex, tABC_Error *pError);
+static void     ABC_TxAddressIndexAdd(TxAddressIndex &index, tABC_TxAddress *pAddress);
 //static void     ABC_TxPrintAddresses(tABC_TxAddress **aAddresses, unsigned int count);
 static tABC_CC  ABC_TxAddressAddTx(tABC_TxAddress *pAddress, tABC_Tx *pTx, tABC_Error *pError);
 static tABC_CC  ABC_TxTransactionExists(tABC_WalletID self, const char *szID, tABC_Tx **pTx, tABC_Error *pError);
-static void     ABC_TxStrTable(const char *needle, int *table);
-static int      ABC_TxStrStr(const char *haystack, const char *needle, tABC_Error *pError);
 static int      ABC_TxCopyOuputs(tABC_Tx *pTx, tABC_TxOutput **aOutputs, int countOutputs, tABC_Error *pError);
 static tABC_CC  ABC_TxTransferPopulate(tABC_TxSendInfo *pInfo, tABC_Tx *pTx, tABC_Tx *pReceiveTx, tABC_Error *pError);
 static tABC_CC  ABC_TxWalletOwnsAddress(tABC_WalletID self, const char *szAddress, bool *bFound, tABC_Error *pError);
-static tABC_CC  ABC_TxGetPrivAddresses(tABC_WalletID self, tABC_U08Buf seed, char ***paAddresses, unsigned int *pCount, tABC_Error *pError);
+static tABC_CC  ABC_TxGetChain(tABC_WalletID self, HdChain **ppChain, tABC_Error *pError);
+static tABC_CC  ABC_TxGetPrivAddresses(tABC_WalletID self, char ***paAddresses, unsigned int *pCount, tABC_Error *pError);
+static tABC_CC  ABC_TxReceiveOne(tABC_WalletID self, const tABC_TxIncoming *pIncoming, bool *pbNew, tABC_Error *pError);
 static tABC_CC  ABC_TxTrashAddresses(tABC_WalletID self, bool bAdd, tABC_Tx *pTx, tABC_TxOutput **paAddresses, unsigned int addressCount, tABC_Error *pError);
 static tABC_CC  ABC_TxCalcCurrency(tABC_WalletID self, int64_t amountSatoshi, double *pCurrency, tABC_Error *pError);
 
 /**
- * Calculates a public address for the HD wallet main external chain.
- * @param pszPubAddress set to the newly-generated address, or set to NULL if
- * there is a math error. If that happens, add 1 to N and try again.
- * @param PrivateSeed any amount of random data to seed the generator
- * @param N the index of the key to generate
+ * Gets the wallet's address chain, deriving it from the seed on first use.
+ *
+ * @param ppChain           Location to store the chain
+ *                          (owned by the cache, and only valid while holding gCoreMutex)
+ * @param pError            A pointer to the location to store the error if there is one
  */
-static tABC_CC
-ABC_BridgeGetBitcoinPubAddress(char **pszPubAddress,
-                                       tABC_U08Buf PrivateSeed,
-                                       int32_t N,
-                                       tABC_Error *pError)
+static
+tABC_CC ABC_TxGetChain(tABC_WalletID self,
+                       HdChain **ppChain,
+                       tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
 
-    libbitcoin::data_chunk seed(PrivateSeed.p, PrivateSeed.end);
-    libwallet::hd_private_key m(seed);
-    libwallet::hd_private_key m0 = m.generate_private_key(0);
-    libwallet::hd_private_key m00 = m0.generate_private_key(0);
-    libwallet::hd_private_key m00n = m00.generate_private_key(N);
-    if (m00n.valid())
-    {
-        std::string out = m00n.address().encoded();
-        ABC_STRDUP(*pszPubAddress, out.c_str());
-    }
-    else
-    {
-        *pszPubAddress = nullptr;
-    }
-
-exit:
-    return cc;
-}
-
-static tABC_CC
-ABC_BridgeGetBitcoinPrivAddress(char **pszPrivAddress,
-                                        tABC_U08Buf PrivateSeed,
-                                        int32_t N,
-                                        tABC_Error *pError)
-{
-    tABC_CC cc = ABC_CC_Ok;
+    AutoU08Buf Seed;
 
-    libbitcoin::data_chunk seed(PrivateSeed.p, PrivateSeed.end);
-    libwallet::hd_private_key m(seed);
-    libwallet::hd_private_key m0 = m.generate_private_key(0);
-    libwallet::hd_private_key m00 = m0.generate_private_key(0);
-    libwallet::hd_private_key m00n = m00.generate_private_key(N);
-    if (m00n.valid())
-    {
-        std::string out = bc::encode_hex(m00n.private_key());
-        ABC_STRDUP(*pszPrivAddress, out.c_str());
-    }
-    else
     {
-        *pszPrivAddress = nullptr;
+        auto row = gTxChains.find(self.szUUID);
+        if (row == gTxChains.end())
+        {
+            ABC_CHECK_RET(ABC_WalletGetBitcoinPrivateSeedDisk(self, &Seed, pError));
+            // Keep exceptions such as std::bad_alloc out of the C API:
+            try
+            {
+                std::unique_ptr<HdChain> chain(new HdChain(U08Buf(Seed)));
+                row = gTxChains.emplace(self.szUUID, std::move(chain)).first;
+            }
+            catch (const std::exception &)
+            {
+                ABC_RET_ERROR(ABC_CC_Error, "Cannot set up the wallet's address chain");
+            }
+        }
+        *ppChain = row->second.get();
     }
 
 exit:
@@ -322,8 +411,6 @@ tABC_CC ABC_TxSend(tABC_TxSendInfo  *pInfo,
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
 
-    char *szPrivSeed = NULL;
-    tABC_U08Buf privSeed = ABC_BUF_NULL; // Do not free
     tABC_UnsignedTx *pUtx = NULL;
     AutoStringArray addresses;
     AutoStringArray keys;
@@ -351,12 +438,9 @@ tABC_CC ABC_TxSend(tABC_TxSendInfo  *pInfo,
         ABC_BridgeTxMake(pInfo, addresses.data, addresses.size,
                          pChangeAddr->szPubAddress, pUtx, pError));
 
-    // Fetch Private Seed
-    ABC_CHECK_RET(
-        ABC_WalletGetBitcoinPrivateSeed(pInfo->wallet, &privSeed, pError));
     // Fetch the private addresses
     ABC_CHECK_RET(
-        ABC_TxGetPrivAddresses(pInfo->wallet, privSeed,
+        ABC_TxGetPrivAddresses(pInfo->wallet,
                                &keys.data, &keys.size,
                                pError));
     // Sign and send transaction
@@ -370,7 +454,6 @@ tABC_CC ABC_TxSend(tABC_TxSendInfo  *pInfo,
     // return the new tx id
     ABC_STRDUP(*pszTxID, pUtx->szTxId);
 exit:
-    ABC_FREE(szPrivSeed);
     ABC_TxFreeAddress(pChangeAddr);
     ABC_TxSendInfoFree(pInfo);
     ABC_TxFreeOutputs(pUtx->aOutputs, pUtx->countOutputs);
@@ -529,19 +612,14 @@ tABC_CC ABC_TxWalletOwnsAddress(tABC_WalletID self,
                                 tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    AutoStringArray addresses;
+    AutoCoreLock lock(gCoreMutex);
+
+    TxAddressIndex *pIndex = NULL;
 
-    ABC_CHECK_RET(
-        ABC_TxGetPubAddresses(self, &addresses.data, &addresses.size, pError));
     *bFound = false;
-    for (unsigned i = 0; i < addresses.size; ++i)
-    {
-        if (strncmp(szAddress, addresses.data[i], strlen(szAddress)) == 0)
-        {
-            *bFound = true;
-            break;
-        }
-    }
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
+    *bFound = 0 < pIndex->seqs.count(szAddress);
+
 exit:
     return cc;
 }
@@ -559,21 +637,22 @@ tABC_CC ABC_TxGetPubAddresses(tABC_WalletID self,
                               tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    tABC_TxAddress **aAddresses = NULL;
-    char **sAddresses;
+    AutoCoreLock lock(gCoreMutex);
+    TxAddressIndex *pIndex = NULL;
+    char **sAddresses = NULL;
     unsigned int countAddresses = 0;
-    ABC_CHECK_RET(
-        ABC_TxGetAddresses(self, &aAddresses, &countAddresses, pError));
-    ABC_ARRAY_NEW(sAddresses, countAddresses, char*);
-    for (unsigned i = 0; i < countAddresses; i++)
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
+    ABC_ARRAY_NEW(sAddresses, pIndex->addresses.size(), char*);
+    for (const auto &i: pIndex->addresses)
     {
-        const char *s = aAddresses[i]->szPubAddress;
-        ABC_STRDUP(sAddresses[i], s);
+        ABC_STRDUP(sAddresses[countAddresses], i.second->szPubAddress);
+        ++countAddresses;
     }
     *pCount = countAddresses;
     *paAddresses = sAddresses;
+    sAddresses = NULL;
 exit:
-    ABC_TxFreeAddresses(aAddresses, countAddresses);
+    ABC_UtilFreeStringArray(sAddresses, countAddresses);
     return cc;
 }
 
@@ -586,30 +665,32 @@ exit:
  */
 static
 tABC_CC ABC_TxGetPrivAddresses(tABC_WalletID self,
-                               tABC_U08Buf seed,
                                char ***paAddresses,
                                unsigned int *pCount,
                                tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    tABC_TxAddress **aAddresses = NULL;
-    char **sAddresses;
+    AutoCoreLock lock(gCoreMutex);
+    TxAddressIndex *pIndex = NULL;
+    char **sAddresses = NULL;
     unsigned int countAddresses = 0;
-    ABC_CHECK_RET(
-        ABC_TxGetAddresses(self, &aAddresses, &countAddresses, pError));
-    ABC_ARRAY_NEW(sAddresses, countAddresses, char*);
-    for (unsigned i = 0; i < countAddresses; i++)
+    HdChain *pChain = NULL;
+    ABC_CHECK_RET(ABC_TxGetChain(self, &pChain, pError));
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
+    ABC_ARRAY_NEW(sAddresses, pIndex->addresses.size(), char*);
+    for (const auto &i: pIndex->addresses)
     {
-        ABC_CHECK_RET(
-            ABC_BridgeGetBitcoinPrivAddress(&sAddresses[i],
-                                            seed,
-                                            aAddresses[i]->seq,
-                                            pError));
+        std::string key;
+        ABC_CHECK_ASSERT(pChain->privateKey(key, i.first),
+            ABC_CC_Error, "Cannot derive private key");
+        ABC_STRDUP(sAddresses[countAddresses], key.c_str());
+        ++countAddresses;
     }
     *pCount = countAddresses;
     *paAddresses = sAddresses;
+    sAddresses = NULL;
 exit:
-    ABC_TxFreeAddresses(aAddresses, countAddresses);
+    ABC_UtilFreeStringArray(sAddresses, countAddresses);
     return cc;
 }
 
@@ -618,23 +699,16 @@ tABC_CC ABC_TxWatchAddresses(tABC_WalletID self,
 {
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
-    char *szPubAddress          = NULL;
-    tABC_TxAddress **aAddresses = NULL;
-    unsigned int countAddresses = 0;
+    TxAddressIndex *pIndex = NULL;
 
-    ABC_CHECK_RET(
-        ABC_TxGetAddresses(self, &aAddresses, &countAddresses, pError));
-    for (unsigned i = 0; i < countAddresses; i++)
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
+    for (const auto &i: pIndex->addresses)
     {
-        const tABC_TxAddress *a = aAddresses[i];
         ABC_CHECK_RET(
             ABC_BridgeWatchAddr(self.szUUID,
-                                a->szPubAddress, pError));
+                                i.second->szPubAddress, pError));
     }
 exit:
-    ABC_TxFreeAddresses(aAddresses, countAddresses);
-    ABC_FREE_STR(szPubAddress);
-
     return cc;
 }
 
@@ -697,12 +771,27 @@ void ABC_TxFreeDetails(tABC_TxDetails *pDetails)
 }
 
 tABC_CC
-ABC_TxBlockHeightUpdate(uint64_t height,
+ABC_TxBlockHeightUpdate(tABC_WalletID self,
+                        uint64_t height,
                         tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
                         void *pData,
                         tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
+
+    // The watcher has no way to tell us when it drops a transaction,
+    // so re-check the unconfirmed ones whenever a block comes in:
+    {
+        AutoCoreLock lock(gCoreMutex);
+        std::set<std::string> pending;
+        auto row = gTxIndexes.find(self.szUUID);
+        if (row != gTxIndexes.end())
+            for (const auto &i: row->second.balances)
+                if (i.second.bPending)
+                    pending.insert(i.first);
+        ABC_TxBalanceRecount(self, pending);
+    }
+
     if (fAsyncBitCoinEventCallback)
     {
         tABC_AsyncBitCoinInfo info;
@@ -717,38 +806,113 @@ exit:
 }
 
 /**
- * Handles creating or updating when we receive a transaction
+ * Handles creating or updating a batch of transactions from the watcher.
+ *
+ * Log-backed wallets write everything out as a single group commit,
+ * and the GUI gets one event at the end rather than one per transaction.
  */
-tABC_CC ABC_TxReceiveTransaction(tABC_WalletID self,
-                                 uint64_t amountSatoshi, uint64_t feeSatoshi,
-                                 tABC_TxOutput **paInAddresses, unsigned int inAddressCount,
-                                 tABC_TxOutput **paOutAddresses, unsigned int outAddressCount,
-                                 const char *szTxId, const char *szMalTxId,
-                                 tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
-                                 void *pData,
-                                 tABC_Error *pError)
+tABC_CC ABC_TxReceiveTransactions(tABC_WalletID self,
+                                  const tABC_TxIncoming *aTxs,
+                                  unsigned int count,
+                                  tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
+                                  void *pData,
+                                  tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
+
+    RecordLog *pLog = NULL;
+    const char *szLastTxId = NULL;
+    const char *szLastNewTxId = NULL;
+
+    if (!count)
+        goto exit;
+
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+    if (pLog)
+        pLog->begin();
+
+    // One bad transaction shouldn't hold up the rest:
+    for (unsigned i = 0; i < count; ++i)
+    {
+        tABC_Error error;
+        bool bNew = false;
+        if (ABC_CC_Ok == ABC_TxReceiveOne(self, &aTxs[i], &bNew, &error))
+        {
+            szLastTxId = aTxs[i].szTxId;
+            if (bNew)
+                szLastNewTxId = aTxs[i].szTxId;
+        }
+        else
+        {
+            ABC_DebugLog("Cannot receive %s: %s\n", aTxs[i].szTxId, error.szDescription);
+        }
+    }
+
+    if (pLog)
+        ABC_CHECK_NEW(pLog->commit(), pError);
+
+    if (fAsyncBitCoinEventCallback && szLastTxId)
+    {
+        tABC_AsyncBitCoinInfo info;
+        info.pData = pData;
+        if (szLastNewTxId)
+        {
+            info.eventType = ABC_AsyncEventType_IncomingBitCoin;
+            ABC_STRDUP(info.szTxID, szLastNewTxId);
+            ABC_STRDUP(info.szDescription, "Received funds");
+        }
+        else
+        {
+            info.eventType = ABC_AsyncEventType_DataSyncUpdate;
+            ABC_STRDUP(info.szTxID, szLastTxId);
+            ABC_STRDUP(info.szDescription, "Updated balance");
+        }
+        ABC_STRDUP(info.szWalletUUID, self.szUUID);
+        fAsyncBitCoinEventCallback(&info);
+        ABC_FREE_STR(info.szTxID);
+        ABC_FREE_STR(info.szWalletUUID);
+        ABC_FREE_STR(info.szDescription);
+    }
+
+exit:
+    return cc;
+}
+
+/**
+ * Handles creating or updating when we receive a transaction
+ *
+ * @param pIncoming     The transaction from the watcher
+ * @param pbNew         Set to true if the wallet didn't have this transaction
+ * @param pError        A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxReceiveOne(tABC_WalletID self,
+                         const tABC_TxIncoming *pIncoming,
+                         bool *pbNew,
+                         tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
     tABC_Tx *pTx = NULL;
     double Currency = 0.0;
 
     // Does the transaction already exist?
-    ABC_TxTransactionExists(self, szTxId, &pTx, pError);
+    ABC_TxTransactionExists(self, pIncoming->szTxId, &pTx, pError);
+    *pbNew = pTx == NULL;
     if (pTx == NULL)
     {
-        ABC_CHECK_RET(ABC_TxCalcCurrency(self, amountSatoshi, &Currency, pError));
+        ABC_CHECK_RET(ABC_TxCalcCurrency(self, pIncoming->amountSatoshi, &Currency, pError));
 
         // create a transaction
         ABC_NEW(pTx, tABC_Tx);
         ABC_NEW(pTx->pStateInfo, tTxStateInfo);
         ABC_NEW(pTx->pDetails, tABC_TxDetails);
 
-        ABC_STRDUP(pTx->pStateInfo->szMalleableTxId, szMalTxId);
+        ABC_STRDUP(pTx->pStateInfo->szMalleableTxId, pIncoming->szMalTxId);
         pTx->pStateInfo->timeCreation = time(NULL);
-        pTx->pDetails->amountSatoshi = amountSatoshi;
+        pTx->pDetails->amountSatoshi = pIncoming->amountSatoshi;
         pTx->pDetails->amountCurrency = Currency;
-        pTx->pDetails->amountFeesMinersSatoshi = feeSatoshi;
+        pTx->pDetails->amountFeesMinersSatoshi = pIncoming->feeSatoshi;
 
         ABC_STRDUP(pTx->pDetails->szName, "");
         ABC_STRDUP(pTx->pDetails->szCategory, "");
@@ -759,29 +923,31 @@ tABC_CC ABC_TxReceiveTransaction(tABC_WalletID self,
         pTx->pStateInfo->bInternal = false;
 
         // store transaction id
-        ABC_STRDUP(pTx->szID, szTxId);
+        ABC_STRDUP(pTx->szID, pIncoming->szTxId);
         // store the input addresses
-        pTx->countOutputs = inAddressCount + outAddressCount;
+        pTx->countOutputs = pIncoming->inputCount + pIncoming->outputCount;
         ABC_ARRAY_NEW(pTx->aOutputs, pTx->countOutputs, tABC_TxOutput*);
-        for (unsigned i = 0; i < inAddressCount; ++i)
+        for (unsigned i = 0; i < pIncoming->inputCount; ++i)
         {
-            ABC_DebugLog("Saving Input address: %s\n", paInAddresses[i]->szAddress);
+            const tABC_TxOutput *pInput = pIncoming->aInputs[i];
+            ABC_DebugLog("Saving Input address: %s\n", pInput->szAddress);
 
             ABC_NEW(pTx->aOutputs[i], tABC_TxOutput);
-            ABC_STRDUP(pTx->aOutputs[i]->szAddress, paInAddresses[i]->szAddress);
-            ABC_STRDUP(pTx->aOutputs[i]->szTxId, paInAddresses[i]->szTxId);
-            pTx->aOutputs[i]->input = paInAddresses[i]->input;
-            pTx->aOutputs[i]->value = paInAddresses[i]->value;
+            ABC_STRDUP(pTx->aOutputs[i]->szAddress, pInput->szAddress);
+            ABC_STRDUP(pTx->aOutputs[i]->szTxId, pInput->szTxId);
+            pTx->aOutputs[i]->input = pInput->input;
+            pTx->aOutputs[i]->value = pInput->value;
         }
-        for (unsigned i = 0; i < outAddressCount; ++i)
+        for (unsigned i = 0; i < pIncoming->outputCount; ++i)
         {
-            ABC_DebugLog("Saving Output address: %s\n", paOutAddresses[i]->szAddress);
-            int newi = i + inAddressCount;
+            const tABC_TxOutput *pOutput = pIncoming->aOutputs[i];
+            ABC_DebugLog("Saving Output address: %s\n", pOutput->szAddress);
+            int newi = i + pIncoming->inputCount;
             ABC_NEW(pTx->aOutputs[newi], tABC_TxOutput);
-            ABC_STRDUP(pTx->aOutputs[newi]->szAddress, paOutAddresses[i]->szAddress);
-            ABC_STRDUP(pTx->aOutputs[newi]->szTxId, paOutAddresses[i]->szTxId);
-            pTx->aOutputs[newi]->input = paOutAddresses[i]->input;
-            pTx->aOutputs[newi]->value = paOutAddresses[i]->value;
+            ABC_STRDUP(pTx->aOutputs[newi]->szAddress, pOutput->szAddress);
+            ABC_STRDUP(pTx->aOutputs[newi]->szTxId, pOutput->szTxId);
+            pTx->aOutputs[newi]->input = pOutput->input;
+            pTx->aOutputs[newi]->value = pOutput->value;
         }
 
         // save the transaction
@@ -789,46 +955,19 @@ tABC_CC ABC_TxReceiveTransaction(tABC_WalletID self,
             ABC_TxSaveTransaction(self, pTx, pError));
 
         // add the transaction to the address
-        ABC_CHECK_RET(ABC_TxTrashAddresses(self, true,
-                        pTx, paOutAddresses, outAddressCount, pError));
-
-        // Mark the wallet cache as dirty in case the Tx wasn't included in the current balance
-        ABC_CHECK_RET(ABC_WalletDirtyCache(self, pError));
-
-        if (fAsyncBitCoinEventCallback)
-        {
-            tABC_AsyncBitCoinInfo info;
-            info.pData = pData;
-            info.eventType = ABC_AsyncEventType_IncomingBitCoin;
-            ABC_STRDUP(info.szTxID, pTx->szID);
-            ABC_STRDUP(info.szWalletUUID, self.szUUID);
-            ABC_STRDUP(info.szDescription, "Received funds");
-            fAsyncBitCoinEventCallback(&info);
-            ABC_FREE_STR(info.szTxID);
-            ABC_FREE_STR(info.szDescription);
-        }
+        ABC_CHECK_RET(ABC_TxTrashAddresses(self, true, pTx,
+                        pIncoming->aOutputs, pIncoming->outputCount,
+                        pError));
     }
     else
     {
-        ABC_DebugLog("We already have %s\n", szTxId);
-        ABC_CHECK_RET(ABC_TxTrashAddresses(self, false,
-                        pTx, paOutAddresses, outAddressCount, pError));
+        ABC_DebugLog("We already have %s\n", pIncoming->szTxId);
+        ABC_CHECK_RET(ABC_TxTrashAddresses(self, false, pTx,
+                        pIncoming->aOutputs, pIncoming->outputCount,
+                        pError));
 
-        // Mark the wallet cache as dirty in case the Tx wasn't included in the current balance
-        ABC_CHECK_RET(ABC_WalletDirtyCache(self, pError));
-
-        if (fAsyncBitCoinEventCallback)
-        {
-            tABC_AsyncBitCoinInfo info;
-            info.pData = pData;
-            info.eventType = ABC_AsyncEventType_DataSyncUpdate;
-            ABC_STRDUP(info.szTxID, pTx->szID);
-            ABC_STRDUP(info.szWalletUUID, self.szUUID);
-            ABC_STRDUP(info.szDescription, "Updated balance");
-            fAsyncBitCoinEventCallback(&info);
-            ABC_FREE_STR(info.szTxID);
-            ABC_FREE_STR(info.szDescription);
-        }
+        // The watcher may not have known about this one when it was saved
+        ABC_TxBalanceUpdate(self, pTx->szID);
     }
 exit:
     ABC_TxFreeTx(pTx);
@@ -853,66 +992,56 @@ tABC_CC ABC_TxTrashAddresses(tABC_WalletID self,
                              tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
+    TxAddressIndex *pIndex = NULL;
     tABC_TxAddress *pAddress = NULL;
 
-    unsigned int localCount = 0;
-    tABC_TxAddress **pInternalAddress = NULL;
-    std::unordered_map<std::string, sABC_TxAddress*> addrMap;
-
-    // Create a more efficient structure to query
-    ABC_CHECK_RET(ABC_TxGetAddresses(self, &pInternalAddress, &localCount, pError));
-    for (unsigned i = 0; i < localCount; ++i)
-    {
-        std::string addr(pInternalAddress[i]->szPubAddress);
-        addrMap[addr] = pInternalAddress[i];
-    }
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
 
     for (unsigned i = 0; i < addressCount; ++i)
     {
-        std::string addr(paAddresses[i]->szAddress);
-        if (addrMap.find(addr) == addrMap.end())
+        auto row = pIndex->seqs.find(paAddresses[i]->szAddress);
+        if (row == pIndex->seqs.end())
             continue;
 
-        pAddress = addrMap[addr];
-        if (pAddress)
+        // work on a copy, since saving replaces the indexed version
+        ABC_CHECK_RET(ABC_TxDupAddress(&pAddress, pIndex->addresses[row->second], pError));
+        pAddress->pStateInfo->bRecycleable = false;
+        if (bAdd)
         {
-            pAddress->pStateInfo->bRecycleable = false;
-            if (bAdd)
-            {
-                ABC_CHECK_RET(ABC_TxAddressAddTx(pAddress, pTx, pError));
-            }
-            ABC_CHECK_RET(ABC_TxSaveAddress(self,
-                    pAddress, pError));
-            int changed = 0;
-            if (ABC_STRLEN(pTx->pDetails->szName) == 0
-                    && ABC_STRLEN(pAddress->pDetails->szName) > 0)
-            {
-                ABC_STRDUP(pTx->pDetails->szName, pAddress->pDetails->szName);
-                ++changed;
-            }
-            if (ABC_STRLEN(pTx->pDetails->szNotes) == 0
-                    && ABC_STRLEN(pAddress->pDetails->szNotes) > 0)
-            {
-                ABC_STRDUP(pTx->pDetails->szNotes, pAddress->pDetails->szNotes);
-                ++changed;
-            }
-            if (ABC_STRLEN(pTx->pDetails->szCategory) == 0
-                    && ABC_STRLEN(pAddress->pDetails->szCategory))
-            {
-                ABC_STRDUP(pTx->pDetails->szCategory, pAddress->pDetails->szCategory);
-                ++changed;
-            }
-            if (changed)
-            {
-                ABC_CHECK_RET(
-                    ABC_TxSaveTransaction(self, pTx, pError));
-            }
+            ABC_CHECK_RET(ABC_TxAddressAddTx(pAddress, pTx, pError));
+        }
+        ABC_CHECK_RET(ABC_TxSaveAddress(self,
+                pAddress, pError));
+        int changed = 0;
+        if (ABC_STRLEN(pTx->pDetails->szName) == 0
+                && ABC_STRLEN(pAddress->pDetails->szName) > 0)
+        {
+            ABC_STRDUP(pTx->pDetails->szName, pAddress->pDetails->szName);
+            ++changed;
         }
+        if (ABC_STRLEN(pTx->pDetails->szNotes) == 0
+                && ABC_STRLEN(pAddress->pDetails->szNotes) > 0)
+        {
+            ABC_STRDUP(pTx->pDetails->szNotes, pAddress->pDetails->szNotes);
+            ++changed;
+        }
+        if (ABC_STRLEN(pTx->pDetails->szCategory) == 0
+                && ABC_STRLEN(pAddress->pDetails->szCategory))
+        {
+            ABC_STRDUP(pTx->pDetails->szCategory, pAddress->pDetails->szCategory);
+            ++changed;
+        }
+        if (changed)
+        {
+            ABC_CHECK_RET(
+                ABC_TxSaveTransaction(self, pTx, pError));
+        }
+        ABC_TxFreeAddress(pAddress);
         pAddress = NULL;
     }
 
 exit:
-    ABC_TxFreeAddresses(pInternalAddress, localCount);
+    ABC_TxFreeAddress(pAddress);
 
     return cc;
 }
@@ -1025,67 +1154,46 @@ tABC_CC ABC_TxCreateNewAddress(tABC_WalletID self,
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
 
-    tABC_TxAddress **aAddresses = NULL;
-    unsigned int countAddresses = 0;
+    TxAddressIndex *pIndex = NULL;
+    HdChain *pChain = NULL;
     tABC_TxAddress *pAddress = NULL;
     int64_t N = -1;
     unsigned recyclable = 0;
 
-    // first look for an existing address that we can re-use
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
+    ABC_CHECK_RET(ABC_TxGetChain(self, &pChain, pError));
 
-    // load addresses
-    ABC_CHECK_RET(ABC_TxGetAddresses(self, &aAddresses, &countAddresses, pError));
+    // the index keeps the addresses in sequence order
+    if (!pIndex->addresses.empty())
+        N = pIndex->addresses.rbegin()->first;
 
-    // search through all of the addresses, get the highest N and check for one with the recycleable bit set
-    for (unsigned i = 0; i < countAddresses; i++)
+    // take the lowest recyclable address that still matches the seed
+    recyclable = pIndex->recyclable.size();
+    for (auto seq: pIndex->recyclable)
     {
-        // if this is the highest seq number
-        if (aAddresses[i]->seq > N)
-        {
-            N = aAddresses[i]->seq;
-        }
+        const tABC_TxAddress *pCandidate = pIndex->addresses[seq];
+        std::string regenAddress;
+        pChain->pubAddress(regenAddress, seq);
 
-        // if we don't have an address yet and this one is available
-        ABC_CHECK_NULL(aAddresses[i]->pStateInfo);
-        if (aAddresses[i]->pStateInfo->bRecycleable == true
-                && aAddresses[i]->pStateInfo->countActivities == 0)
+        if (regenAddress == pCandidate->szPubAddress)
         {
-            recyclable++;
-            if (pAddress == NULL)
-            {
-                char *szRegenAddress = NULL;
-                AutoU08Buf Seed;
-                ABC_CHECK_RET(ABC_WalletGetBitcoinPrivateSeedDisk(self, &Seed, pError));
-                ABC_CHECK_RET(ABC_BridgeGetBitcoinPubAddress(&szRegenAddress, Seed, aAddresses[i]->seq, pError));
-
-                if (strncmp(aAddresses[i]->szPubAddress, szRegenAddress, strlen(aAddresses[i]->szPubAddress)) == 0)
-                {
-                    // set it to NULL so we don't free it as part of the array
-                    // free, we will be sending this back to the caller
-                    pAddress = aAddresses[i];
-                    aAddresses[i] = NULL;
-                    recyclable--;
-                }
-                else
-                {
-                    ABC_DebugLog("********************************\n");
-                    ABC_DebugLog("Address Corrupt\nInitially: %s, Now: %s\nSeq: %d",
-                                    aAddresses[i]->szPubAddress,
-                                    szRegenAddress,
-                                    aAddresses[i]->seq);
-                    ABC_DebugLog("********************************\n");
-                }
-                ABC_FREE_STR(szRegenAddress);
-            }
+            // copy it, since we will be sending this back to the caller
+            ABC_CHECK_RET(ABC_TxDupAddress(&pAddress, pCandidate, pError));
+            recyclable--;
+            break;
         }
+
+        ABC_DebugLog("********************************\n");
+        ABC_DebugLog("Address Corrupt\nInitially: %s, Now: %s\nSeq: %d",
+                        pCandidate->szPubAddress,
+                        regenAddress.c_str(),
+                        seq);
+        ABC_DebugLog("********************************\n");
     }
-    // Create a new address at N
+    // Create new addresses after N
     if (recyclable <= MIN_RECYCLABLE)
     {
-        for (unsigned i = 0; i < MIN_RECYCLABLE - recyclable; ++i)
-        {
-            ABC_CHECK_RET(ABC_TxCreateNewAddressForN(self, N + i, pError));
-        }
+        ABC_CHECK_RET(ABC_TxCreateNewAddresses(self, N + 1, MIN_RECYCLABLE - recyclable, pError));
     }
 
     // Does the caller want a result?
@@ -1115,61 +1223,68 @@ tABC_CC ABC_TxCreateNewAddress(tABC_WalletID self,
         pAddress = NULL;
     }
 exit:
-    ABC_TxFreeAddresses(aAddresses, countAddresses);
     ABC_TxFreeAddress(pAddress);
 
     return cc;
 }
 
+/**
+ * Creates and saves a run of new addresses.
+ * The public addresses are all derived up front, in parallel.
+ *
+ * @param first         The sequence number of the first new address
+ * @param count         The number of addresses to create
+ * @param pError        A pointer to the location to store the error if there is one
+ */
 static
-tABC_CC ABC_TxCreateNewAddressForN(tABC_WalletID self, int32_t N, tABC_Error *pError)
+tABC_CC ABC_TxCreateNewAddresses(tABC_WalletID self, int32_t first, unsigned int count, tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
     tABC_TxAddress *pAddress = NULL;
-    AutoU08Buf Seed;
-
-    // Now we know the latest N, create a new address
-    ABC_NEW(pAddress, tABC_TxAddress);
+    HdChain *pChain = NULL;
+    std::vector<std::string> pubAddresses;
 
-    // get the private seed so we can generate the public address
-    ABC_CHECK_RET(ABC_WalletGetBitcoinPrivateSeedDisk(self, &Seed, pError));
+    // generate the public addresses
+    ABC_CHECK_RET(ABC_TxGetChain(self, &pChain, pError));
+    pubAddresses = pChain->pubAddresses(first, count);
 
-    // generate the public address
-    pAddress->szPubAddress = NULL;
-    pAddress->seq = N;
-    do
+    for (unsigned i = 0; i < count; ++i)
     {
-        // move to the next sequence number
-        pAddress->seq++;
+        // skip over invalid sequence numbers
+        if (pubAddresses[i].empty())
+            continue;
 
-        // Get the public address for our sequence (it can return NULL, if it is invalid)
-        ABC_CHECK_RET(ABC_BridgeGetBitcoinPubAddress(&(pAddress->szPubAddress), Seed, pAddress->seq, pError));
-    } while (pAddress->szPubAddress == NULL);
+        ABC_NEW(pAddress, tABC_TxAddress);
+        pAddress->seq = first + i;
+        ABC_STRDUP(pAddress->szPubAddress, pubAddresses[i].c_str());
 
-    // set the final ID
-    ABC_STR_NEW(pAddress->szID, TX_MAX_ADDR_ID_LENGTH);
-    sprintf(pAddress->szID, "%u", pAddress->seq);
+        // set the final ID
+        ABC_STR_NEW(pAddress->szID, TX_MAX_ADDR_ID_LENGTH);
+        sprintf(pAddress->szID, "%u", pAddress->seq);
 
-    ABC_NEW(pAddress->pStateInfo, tTxAddressStateInfo);
-    pAddress->pStateInfo->bRecycleable = true;
-    pAddress->pStateInfo->countActivities = 0;
-    pAddress->pStateInfo->aActivities = NULL;
-    pAddress->pStateInfo->timeCreation = time(NULL);
-
-    ABC_NEW(pAddress->pDetails, tABC_TxDetails);
-    ABC_STRDUP(pAddress->pDetails->szName, "");
-    ABC_STRDUP(pAddress->pDetails->szCategory, "");
-    ABC_STRDUP(pAddress->pDetails->szNotes, "");
-    pAddress->pDetails->attributes = 0x0;
-    pAddress->pDetails->bizId = 0;
-    pAddress->pDetails->amountSatoshi = 0;
-    pAddress->pDetails->amountCurrency = 0;
-    pAddress->pDetails->amountFeesAirbitzSatoshi = 0;
-    pAddress->pDetails->amountFeesMinersSatoshi = 0;
-
-    // Save the new Address
-    ABC_CHECK_RET(ABC_TxSaveAddress(self, pAddress, pError));
+        ABC_NEW(pAddress->pStateInfo, tTxAddressStateInfo);
+        pAddress->pStateInfo->bRecycleable = true;
+        pAddress->pStateInfo->countActivities = 0;
+        pAddress->pStateInfo->aActivities = NULL;
+        pAddress->pStateInfo->timeCreation = time(NULL);
+
+        ABC_NEW(pAddress->pDetails, tABC_TxDetails);
+        ABC_STRDUP(pAddress->pDetails->szName, "");
+        ABC_STRDUP(pAddress->pDetails->szCategory, "");
+        ABC_STRDUP(pAddress->pDetails->szNotes, "");
+        pAddress->pDetails->attributes = 0x0;
+        pAddress->pDetails->bizId = 0;
+        pAddress->pDetails->amountSatoshi = 0;
+        pAddress->pDetails->amountCurrency = 0;
+        pAddress->pDetails->amountFeesAirbitzSatoshi = 0;
+        pAddress->pDetails->amountFeesMinersSatoshi = 0;
+
+        // Save the new Address
+        ABC_CHECK_RET(ABC_TxSaveAddress(self, pAddress, pError));
+        ABC_TxFreeAddress(pAddress);
+        pAddress = NULL;
+    }
 exit:
     ABC_TxFreeAddress(pAddress);
 
@@ -1193,24 +1308,11 @@ tABC_CC ABC_TxModifyReceiveRequest(tABC_WalletID self,
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
 
-    char *szFile = NULL;
-    char *szAddrDir = NULL;
-    char *szFilename = NULL;
     tABC_TxAddress *pAddress = NULL;
     tABC_TxDetails *pNewDetails = NULL;
 
-    // get the filename for this request (note: interally requests are addresses)
-    ABC_CHECK_RET(ABC_GetAddressFilename(self.szUUID, szRequestID, &szFile, pError));
-
-    // get the directory name
-    ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, self.szUUID, pError));
-
-    // create the full filename
-    ABC_STR_NEW(szFilename, ABC_FILEIO_MAX_PATH_LENGTH + 1);
-    sprintf(szFilename, "%s/%s", szAddrDir, szFile);
-
-    // load the request address
-    ABC_CHECK_RET(ABC_TxLoadAddressFile(self, szFilename, &pAddress, pError));
+    // load the request address (note: interally requests are addresses)
+    ABC_CHECK_RET(ABC_TxLoadAddress(self, szRequestID, &pAddress, pError));
 
     // copy the new details
     ABC_CHECK_RET(ABC_TxDupDetails(&pNewDetails, pDetails, pError));
@@ -1226,9 +1328,6 @@ tABC_CC ABC_TxModifyReceiveRequest(tABC_WalletID self,
     ABC_CHECK_RET(ABC_TxSaveAddress(self, pAddress, pError));
 
 exit:
-    ABC_FREE_STR(szFile);
-    ABC_FREE_STR(szAddrDir);
-    ABC_FREE_STR(szFilename);
     ABC_TxFreeAddress(pAddress);
     ABC_TxFreeDetails(pNewDetails);
 
@@ -1236,217 +1335,69 @@ exit:
 }
 
 /**
- * Gets the filename for a given address based upon the address id
+ * Finalizes a previously created receive request.
+ * This is done by setting the recycle bit to false so that the address is not used again.
  *
- * @param szWalletUUID  UUID of the wallet associated with this address
- * @param szAddressID   ID of this address
- * @param pszFilename   Address to store pointer to filename
+ * @param szRequestID   ID of this request
  * @param pError        A pointer to the location to store the error if there is one
  */
-static
-tABC_CC ABC_GetAddressFilename(const char *szWalletUUID,
-                               const char *szAddressID,
-                               char **pszFilename,
-                               tABC_Error *pError)
+tABC_CC ABC_TxFinalizeReceiveRequest(tABC_WalletID self,
+                                     const char *szRequestID,
+                                     tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    AutoFileLock lock(gFileMutex); // We are iterating over the filesystem
-
-    char *szAddrDir = NULL;
-    tABC_FileIOList *pFileList = NULL;
-    bool bExists = false;
-    char *szID = NULL;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
-    ABC_CHECK_NULL(szWalletUUID);
-    ABC_CHECK_ASSERT(strlen(szWalletUUID) > 0, ABC_CC_Error, "No wallet UUID provided");
-    ABC_CHECK_NULL(szAddressID);
-    ABC_CHECK_ASSERT(strlen(szAddressID) > 0, ABC_CC_Error, "No address UUID provided");
-    ABC_CHECK_NULL(pszFilename);
-    *pszFilename = NULL;
+    // set the recycle bool to false (not that the request is actually an address internally)
+    ABC_CHECK_RET(ABC_TxSetAddressRecycle(self, szRequestID, false, pError));
 
-    // get the directory name
-    ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, szWalletUUID, pError));
+exit:
 
-    // Make sure there is an addresses directory
-    ABC_CHECK_RET(ABC_FileIOFileExists(szAddrDir, &bExists, pError));
-    ABC_CHECK_ASSERT(bExists == true, ABC_CC_Error, "No existing requests/addresses");
+    return cc;
+}
 
-    // get all the files in the address directory
-    ABC_FileIOCreateFileList(&pFileList, szAddrDir, NULL);
-    for (int i = 0; i < pFileList->nCount; i++)
-    {
-        // if this file is a normal file
-        if (pFileList->apFiles[i]->type == ABC_FileIOFileType_Regular)
-        {
-            // parse the elements from the filename
-            ABC_FREE_STR(szID);
-            ABC_CHECK_RET(ABC_TxParseAddrFilename(pFileList->apFiles[i]->szName, &szID, NULL, pError));
+/**
+ * Cancels a previously created receive request.
+ * This is done by setting the recycle bit to true so that the address can be used again.
+ *
+ * @param szRequestID   ID of this request
+ * @param pError        A pointer to the location to store the error if there is one
+ */
+tABC_CC ABC_TxCancelReceiveRequest(tABC_WalletID self,
+                                   const char *szRequestID,
+                                   tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
-            // if the id matches
-            if (strcmp(szID, szAddressID) == 0)
-            {
-                // copy over the filename
-                ABC_STRDUP(*pszFilename, pFileList->apFiles[i]->szName);
-                break;
-            }
-        }
-    }
+    // set the recycle bool to true (not that the request is actually an address internally)
+    ABC_CHECK_RET(ABC_TxSetAddressRecycle(self, szRequestID, true, pError));
 
 exit:
-    ABC_FREE_STR(szAddrDir);
-    ABC_FREE_STR(szID);
-    ABC_FileIOFreeFileList(pFileList);
 
     return cc;
 }
 
 /**
- * Parses out the id and public address from an address filename
+ * Sets the recycle status on an address as specified
  *
- * @param szFilename        Filename to parse
- * @param pszID             Location to store allocated id (caller must free) - optional
- * @param pszPublicAddress  Location to store allocated public address(caller must free) - optional
- * @param pError            A pointer to the location to store the error if there is one
+ * @param szAddress     ID of the address
+ * @param pError        A pointer to the location to store the error if there is one
  */
 static
-tABC_CC ABC_TxParseAddrFilename(const char *szFilename,
-                                char **pszID,
-                                char **pszPublicAddress,
+tABC_CC ABC_TxSetAddressRecycle(tABC_WalletID self,
+                                const char *szAddress,
+                                bool bRecyclable,
                                 tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
-
-    // if the filename is long enough
-    if (strlen(szFilename) >= ADDRESS_FILENAME_MIN_LEN)
-    {
-        int suffixPos = (int) strlen(szFilename) - (int) strlen(ADDRESS_FILENAME_SUFFIX);
-        char *szSuffix = (char *) &(szFilename[suffixPos]);
+    AutoCoreLock lock(gCoreMutex);
 
-        // if the filename ends with the right suffix
-        if (strcmp(ADDRESS_FILENAME_SUFFIX, szSuffix) == 0)
-        {
-            int nPosSeparator = 0;
-
-            // go through all the characters up to the separator
-            for (size_t i = 0; i < strlen(szFilename); i++)
-            {
-                // check for id separator
-                if (szFilename[i] == ADDRESS_FILENAME_SEPARATOR)
-                {
-                    // found it
-                    nPosSeparator = i;
-                    break;
-                }
-
-                // if no separator, then better be a digit
-                if (isdigit(szFilename[i]) == 0)
-                {
-                    // Ran into a non-digit! - no good
-                    break;
-                }
-            }
-
-            // if we found a legal separator position
-            if (nPosSeparator > 0)
-            {
-                if (pszID != NULL)
-                {
-                    ABC_STR_NEW(*pszID, nPosSeparator + 1);
-                    strncpy(*pszID, szFilename, nPosSeparator);
-                }
-
-                if (pszPublicAddress != NULL)
-                {
-                    ABC_STRDUP(*pszPublicAddress, &(szFilename[nPosSeparator + 1]))
-                    (*pszPublicAddress)[strlen(*pszPublicAddress) - strlen(ADDRESS_FILENAME_SUFFIX)] = '\0';
-                }
-            }
-        }
-    }
-
-exit:
-
-    return cc;
-}
-
-/**
- * Finalizes a previously created receive request.
- * This is done by setting the recycle bit to false so that the address is not used again.
- *
- * @param szRequestID   ID of this request
- * @param pError        A pointer to the location to store the error if there is one
- */
-tABC_CC ABC_TxFinalizeReceiveRequest(tABC_WalletID self,
-                                     const char *szRequestID,
-                                     tABC_Error *pError)
-{
-    tABC_CC cc = ABC_CC_Ok;
-    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
-
-    // set the recycle bool to false (not that the request is actually an address internally)
-    ABC_CHECK_RET(ABC_TxSetAddressRecycle(self, szRequestID, false, pError));
-
-exit:
-
-    return cc;
-}
-
-/**
- * Cancels a previously created receive request.
- * This is done by setting the recycle bit to true so that the address can be used again.
- *
- * @param szRequestID   ID of this request
- * @param pError        A pointer to the location to store the error if there is one
- */
-tABC_CC ABC_TxCancelReceiveRequest(tABC_WalletID self,
-                                   const char *szRequestID,
-                                   tABC_Error *pError)
-{
-    tABC_CC cc = ABC_CC_Ok;
-    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
-
-    // set the recycle bool to true (not that the request is actually an address internally)
-    ABC_CHECK_RET(ABC_TxSetAddressRecycle(self, szRequestID, true, pError));
-
-exit:
-
-    return cc;
-}
-
-/**
- * Sets the recycle status on an address as specified
- *
- * @param szAddress     ID of the address
- * @param pError        A pointer to the location to store the error if there is one
- */
-static
-tABC_CC ABC_TxSetAddressRecycle(tABC_WalletID self,
-                                const char *szAddress,
-                                bool bRecyclable,
-                                tABC_Error *pError)
-{
-    tABC_CC cc = ABC_CC_Ok;
-    AutoCoreLock lock(gCoreMutex);
-
-    char *szFile = NULL;
-    char *szAddrDir = NULL;
-    char *szFilename = NULL;
-    tABC_TxAddress *pAddress = NULL;
-    tABC_TxDetails *pNewDetails = NULL;
-
-    // get the filename for this address
-    ABC_CHECK_RET(ABC_GetAddressFilename(self.szUUID, szAddress, &szFile, pError));
-
-    // get the directory name
-    ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, self.szUUID, pError));
-
-    // create the full filename
-    ABC_STR_NEW(szFilename, ABC_FILEIO_MAX_PATH_LENGTH + 1);
-    sprintf(szFilename, "%s/%s", szAddrDir, szFile);
+    tABC_TxAddress *pAddress = NULL;
+    tABC_TxDetails *pNewDetails = NULL;
 
     // load the request address
-    ABC_CHECK_RET(ABC_TxLoadAddressFile(self, szFilename, &pAddress, pError));
+    ABC_CHECK_RET(ABC_TxLoadAddress(self, szAddress, &pAddress, pError));
     ABC_CHECK_NULL(pAddress->pStateInfo);
 
     // if it isn't already set as required
@@ -1461,9 +1412,6 @@ tABC_CC ABC_TxSetAddressRecycle(tABC_WalletID self,
     }
 
 exit:
-    ABC_FREE_STR(szFile);
-    ABC_FREE_STR(szAddrDir);
-    ABC_FREE_STR(szFilename);
     ABC_TxFreeAddress(pAddress);
     ABC_TxFreeDetails(pNewDetails);
 
@@ -1562,42 +1510,20 @@ tABC_CC ABC_TxGetTransaction(tABC_WalletID self,
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
 
-    char *szFilename = NULL;
-    tABC_Tx *pTx = NULL;
-    tABC_TxInfo *pTransaction = NULL;
-    bool bExists = false;
+    TxIndex *pIndex = NULL;
 
     *ppTransaction = NULL;
 
-    // find the filename of the existing transaction
-
-    // first try the internal
-    ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, true, pError));
-    ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-
-    // if the internal doesn't exist
-    if (bExists == false)
+    // find the transaction in the index
+    ABC_CHECK_RET(ABC_TxIndexLoad(self, &pIndex, pError));
     {
-        // try the external
-        ABC_FREE_STR(szFilename);
-        ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, false, pError));
-        ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-    }
-
-    ABC_CHECK_ASSERT(bExists == true, ABC_CC_NoTransaction, "Transaction does not exist");
+        auto i = pIndex->txs.find(szID);
+        ABC_CHECK_ASSERT(i != pIndex->txs.end(), ABC_CC_NoTransaction, "Transaction does not exist");
 
-    // load the existing transaction
-    ABC_CHECK_RET(ABC_TxLoadTransactionInfo(self, szFilename, &pTransaction, pError));
-
-    // assign final result
-    *ppTransaction = pTransaction;
-    pTransaction = NULL;
+        ABC_CHECK_RET(ABC_TxCreateTxInfo(self, i->second, ppTransaction, pError));
+    }
 
 exit:
-    ABC_FREE_STR(szFilename);
-    ABC_TxFreeTx(pTx);
-    ABC_TxFreeTransaction(pTransaction);
-
     return cc;
 }
 
@@ -1619,90 +1545,174 @@ tABC_CC ABC_TxGetTransactions(tABC_WalletID self,
 {
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
-    AutoFileLock fileLock(gFileMutex); // We are iterating over the filesystem
 
-    char *szTxDir = NULL;
-    tABC_FileIOList *pFileList = NULL;
-    char *szFilename = NULL;
+    TxIndex *pIndex = NULL;
     tABC_TxInfo **aTransactions = NULL;
     unsigned int count = 0;
-    bool bExists = false;
 
     *paTransactions = NULL;
     *pCount = 0;
 
-    // get the directory name
-    ABC_CHECK_RET(ABC_WalletGetTxDirName(&szTxDir, self.szUUID, pError));
+    ABC_CHECK_RET(ABC_TxIndexLoad(self, &pIndex, pError));
+    {
+        // the index is already sorted by creation date
+        TimeRange range(pIndex->byTime.begin(), pIndex->byTime.end());
+        if (endTime != ABC_GET_TX_ALL_TIMES)
+            range = timeIndexRange(pIndex->byTime, startTime, endTime);
+        auto begin = range.first;
+        auto end = range.second;
+
+        unsigned int total = std::distance(begin, end);
+        if (total > 0)
+        {
+            ABC_ARRAY_NEW(aTransactions, total, tABC_TxInfo*);
+            for (auto i = begin; i != end; ++i)
+            {
+                ABC_CHECK_RET(ABC_TxCreateTxInfo(self, pIndex->txs[i->second],
+                                                 &aTransactions[count], pError));
+                count++;
+            }
+        }
+    }
+
+    // store final results
+    *paTransactions = aTransactions;
+    aTransactions = NULL;
+    *pCount = count;
+    count = 0;
+
+exit:
+    if (count > 0)
+        ABC_TxFreeTransactions(aTransactions, count);
+    else
+        ABC_FREE(aTransactions);
+
+    return cc;
+}
+
+/**
+ * Gets one page of the transactions associated with the given wallet,
+ * starting just past the given cursor. Only the transactions that end up
+ * on the page are copied out of the index.
+ *
+ * The cursor is an opaque string holding the position of the last
+ * transaction looked at, so paging stays stable as new transactions arrive.
+ *
+ * @param startTime         Return transactions after this time
+ * @param endTime           Return transactions before this time
+ * @param szCursor          Cursor from the previous page, or NULL to start over
+ * @param limit             Maximum number of transactions to return
+ * @param bNewestFirst      True to walk from the newest transaction backwards
+ * @param paTransactions    Pointer to store array of transactions info pointers
+ * @param pCount            Pointer to store number of transactions
+ * @param pszNextCursor     Pointer to store the next cursor, or NULL at the end
+ *                          (caller must free)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+tABC_CC ABC_TxGetTransactionsPage(tABC_WalletID self,
+                                  int64_t startTime,
+                                  int64_t endTime,
+                                  const char *szCursor,
+                                  unsigned int limit,
+                                  bool bNewestFirst,
+                                  tABC_TxInfo ***paTransactions,
+                                  unsigned int *pCount,
+                                  char **pszNextCursor,
+                                  tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
+
+    TxIndex *pIndex = NULL;
+    tABC_TxInfo **aTransactions = NULL;
+    unsigned int count = 0;
+    TimeKey cursor;
+    TimeKey last;
+    char *szEnd = NULL;
+    long long cursorTime = 0;
+
+    *paTransactions = NULL;
+    *pCount = 0;
+    *pszNextCursor = NULL;
 
-    // if there is a transaction directory
-    ABC_CHECK_RET(ABC_FileIOFileExists(szTxDir, &bExists, pError));
+    ABC_CHECK_ASSERT(limit > 0, ABC_CC_Error, "No page size provided");
 
-    if (bExists == true)
+    // decode the cursor, which looks like <timeCreation>:<ntxid>
+    if (szCursor && *szCursor)
     {
-        ABC_STR_NEW(szFilename, ABC_FILEIO_MAX_PATH_LENGTH + 1);
+        const char *szID = strchr(szCursor, ':');
+        ABC_CHECK_ASSERT(szID, ABC_CC_Error, "Invalid transaction cursor");
+        cursorTime = strtoll(szCursor, &szEnd, 10);
+        ABC_CHECK_ASSERT(szEnd != szCursor && szEnd == szID,
+            ABC_CC_Error, "Invalid transaction cursor");
+        cursor = TimeKey(cursorTime, std::string(szID + 1));
+    }
 
-        // get all the files in the transaction directory
-        ABC_FileIOCreateFileList(&pFileList, szTxDir, NULL);
-        for (int i = 0; i < pFileList->nCount; i++)
-        {
-            // if this file is a normal file
-            if (pFileList->apFiles[i]->type == ABC_FileIOFileType_Regular)
-            {
-                // create the filename for this transaction
-                sprintf(szFilename, "%s/%s", szTxDir, pFileList->apFiles[i]->szName);
+    ABC_CHECK_RET(ABC_TxIndexLoad(self, &pIndex, pError));
+    {
+        const auto &byTime = pIndex->byTime;
 
-                // get the transaction type
-                tTxType type = TxType_None;
-                ABC_CHECK_RET(ABC_TxGetTxTypeAndBasename(szFilename, &type, NULL, pError));
+        // narrow the index down to the requested time range
+        TimeRange range(byTime.begin(), byTime.end());
+        if (endTime != ABC_GET_TX_ALL_TIMES)
+            range = timeIndexRange(byTime, startTime, endTime);
 
-                // if this is a transaction file (based upon name)
-                if (type != TxType_None)
-                {
-                    bool bHasInternalEquivalent = false;
+        // then skip everything up to and including the cursor
+        if (szCursor && *szCursor)
+            range = timeIndexAfter(byTime, range, cursor, bNewestFirst);
+        auto begin = range.first;
+        auto end = range.second;
 
-                    // if this is an external transaction
-                    if (type == TxType_External)
-                    {
-                        // check if it has an internal equivalent and, if so, delete the external
-                        ABC_CHECK_RET(ABC_TxCheckForInternalEquivalent(szFilename, &bHasInternalEquivalent, pError));
-                    }
+        ABC_ARRAY_NEW(aTransactions, limit, tABC_TxInfo*);
 
-                    // if this doesn't not have an internal equivalent (or is an internal itself)
-                    if (bHasInternalEquivalent == false)
-                    {
-                        // add this transaction to the array
-
-                        ABC_CHECK_RET(ABC_TxLoadTxAndAppendToArray(self,
-                                                                   startTime,
-                                                                   endTime,
-                                                                   szFilename,
-                                                                   &aTransactions,
-                                                                   &count,
-                                                                   pError));
-                    }
-                }
+        // fill the page, dropping anything the watcher doesn't know about
+        while (count < limit && begin != end)
+        {
+            unsigned int first = count;
+            while (count < limit && begin != end)
+            {
+                auto i = bNewestFirst ? std::prev(end) : begin;
+                if (bNewestFirst)
+                    end = i;
+                else
+                    begin = std::next(i);
+                last = *i;
+
+                ABC_CHECK_RET(ABC_TxCreateTxInfo(self, pIndex->txs[i->second],
+                                                 &aTransactions[count], pError));
+                count++;
             }
+
+            // the filter compacts the survivors to the front of the batch
+            unsigned int added = count - first;
+            ABC_CHECK_RET(ABC_BridgeFilterTransactions(self.szUUID,
+                aTransactions + first, &added, pError));
+            count = first + added;
         }
-    }
 
-    // if we have more than one, then let's sort them
-    if (count > 1)
-    {
-        // sort the transactions by creation date using qsort
-        qsort(aTransactions, count, sizeof(tABC_TxInfo *), ABC_TxInfoPtrCompare);
+        // more transactions remain, so hand out a cursor
+        if (begin != end)
+        {
+            ABC_STR_NEW(*pszNextCursor, TX_MAX_CURSOR_LENGTH + 1);
+            snprintf(*pszNextCursor, TX_MAX_CURSOR_LENGTH + 1, "%lld:%s",
+                     (long long)last.first, last.second.c_str());
+        }
     }
 
     // store final results
-    *paTransactions = aTransactions;
-    aTransactions = NULL;
+    if (count > 0)
+    {
+        *paTransactions = aTransactions;
+        aTransactions = NULL;
+    }
     *pCount = count;
     count = 0;
 
 exit:
-    ABC_FREE_STR(szTxDir);
-    ABC_FREE_STR(szFilename);
-    ABC_FileIOFreeFileList(pFileList);
-    ABC_TxFreeTransactions(aTransactions, count);
+    if (count > 0)
+        ABC_TxFreeTransactions(aTransactions, count);
+    else
+        ABC_FREE(aTransactions);
 
     return cc;
 }
@@ -1722,73 +1732,49 @@ tABC_CC ABC_TxSearchTransactions(tABC_WalletID self,
                                  tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
+
+    TxIndex *pIndex = NULL;
     tABC_TxInfo **aTransactions = NULL;
-    tABC_TxInfo **aSearchTransactions = NULL;
-    unsigned int i;
     unsigned int count = 0;
-    unsigned int matchCount = 0;
-    char satoshi[15];
-    char currency[15];
+    std::vector<std::pair<int64_t, std::string>> matches;
 
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
     ABC_CHECK_NULL(paTransactions);
     *paTransactions = NULL;
     ABC_CHECK_NULL(pCount);
     *pCount = 0;
+    ABC_CHECK_NULL(szQuery);
 
-    ABC_TxGetTransactions(self, ABC_GET_TX_ALL_TIMES, ABC_GET_TX_ALL_TIMES,
-                          &aTransactions, &count, pError);
-    ABC_ARRAY_NEW(aSearchTransactions, count, tABC_TxInfo*);
-    for (i = 0; i < count; i++) {
-        memset(satoshi, '\0', 15);
-        memset(currency, '\0', 15);
-        tABC_TxInfo *pInfo = aTransactions[i];
-        snprintf(satoshi, 15, "%ld", pInfo->pDetails->amountSatoshi);
-        snprintf(currency, 15, "%f", pInfo->pDetails->amountCurrency);
-        if (ABC_TxStrStr(satoshi, szQuery, pError))
-        {
-            aSearchTransactions[matchCount] = pInfo;
-            matchCount++;
-            continue;
-        }
-        if (ABC_TxStrStr(currency, szQuery, pError))
-        {
-            aSearchTransactions[matchCount] = pInfo;
-            matchCount++;
-            continue;
-        }
-        if (ABC_TxStrStr(pInfo->pDetails->szName, szQuery, pError))
-        {
-            aSearchTransactions[matchCount] = pInfo;
-            matchCount++;
-            continue;
-        }
-        else if (ABC_TxStrStr(pInfo->pDetails->szCategory, szQuery, pError))
-        {
-            aSearchTransactions[matchCount] = pInfo;
-            matchCount++;
-            continue;
-        }
-        else if (ABC_TxStrStr(pInfo->pDetails->szNotes, szQuery, pError))
+    // only the matching transactions ever leave the index
+    ABC_CHECK_RET(ABC_TxIndexLoad(self, &pIndex, pError));
+    for (const auto &id: pIndex->search.search(szQuery))
+        matches.push_back(std::make_pair(pIndex->txs[id]->pStateInfo->timeCreation, id));
+    std::sort(matches.begin(), matches.end());
+
+    if (matches.size() > 0)
+    {
+        ABC_ARRAY_NEW(aTransactions, matches.size(), tABC_TxInfo*);
+        for (const auto &match: matches)
         {
-            aSearchTransactions[matchCount] = pInfo;
-            matchCount++;
-            continue;
-        } else {
-            ABC_TxFreeTransaction(pInfo);
+            ABC_CHECK_RET(ABC_TxCreateTxInfo(self, pIndex->txs[match.second],
+                                             &aTransactions[count], pError));
+            count++;
         }
-        aTransactions[i] = NULL;
-    }
-    if (matchCount > 0)
-    {
-        ABC_ARRAY_RESIZE(aSearchTransactions, matchCount, tABC_TxInfo*);
     }
 
-    *paTransactions = aSearchTransactions;
-    *pCount = matchCount;
+    // store final results
+    *paTransactions = aTransactions;
     aTransactions = NULL;
+    *pCount = count;
+    count = 0;
+
 exit:
-    ABC_FREE(aTransactions);
+    if (count > 0)
+        ABC_TxFreeTransactions(aTransactions, count);
+    else
+        ABC_FREE(aTransactions);
+
     return cc;
 }
 
@@ -1801,7 +1787,8 @@ exit:
  * @param pError        A pointer to the location to store the error if there is one
  */
 static
-tABC_CC ABC_TxCheckForInternalEquivalent(const char *szFilename,
+tABC_CC ABC_TxCheckForInternalEquivalent(tABC_WalletID self,
+                                         const char *szFilename,
                                          bool *pbEquivalent,
                                          tABC_Error *pError)
 {
@@ -1828,13 +1815,13 @@ tABC_CC ABC_TxCheckForInternalEquivalent(const char *szFilename,
 
         // check if this internal version of the file exists
         bool bExists = false;
-        ABC_CHECK_RET(ABC_FileIOFileExists(szFilenameInt, &bExists, pError));
+        ABC_CHECK_RET(ABC_TxStoreExists(self, szFilenameInt, &bExists, pError));
 
         // if the internal version exists
         if (bExists)
         {
             // delete the external version (this one)
-            ABC_CHECK_RET(ABC_FileIODeleteFile(szFilename, pError));
+            ABC_CHECK_RET(ABC_TxStoreDelete(self, szFilename, pError));
 
             *pbEquivalent = true;
         }
@@ -1936,114 +1923,906 @@ exit:
 }
 
 /**
- * Load the specified transaction info.
+ * Gets the transaction index for a wallet, building it from the
+ * transaction directory if this is the first time it is needed.
  *
- * @param szFilename        Filename of the transaction
- * @param ppTransaction     Location to store allocated transaction
- *                          (caller must free)
+ * @param ppIndex           Location to store the index
+ *                          (owned by the cache, do not free)
  * @param pError            A pointer to the location to store the error if there is one
  */
 static
-tABC_CC ABC_TxLoadTransactionInfo(tABC_WalletID self,
-                                  const char *szFilename,
-                                  tABC_TxInfo **ppTransaction,
-                                  tABC_Error *pError)
+tABC_CC ABC_TxIndexLoad(tABC_WalletID self,
+                        TxIndex **ppIndex,
+                        tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
+    AutoFileLock fileLock(gFileMutex); // We are iterating over the filesystem
 
+    tABC_U08Buf MK = ABC_BUF_NULL; // Do not free
+    char *szTxDir = NULL;
+    tABC_FileIOList *pFileList = NULL;
+    char *szFilename = NULL;
     tABC_Tx *pTx = NULL;
-    tABC_TxInfo *pTransaction = NULL;
+    TxIndex *pIndex = NULL;
+    std::vector<DecryptJob> jobs;
 
-    *ppTransaction = NULL;
+    // is the index already loaded?
+    auto row = gTxIndexes.find(self.szUUID);
+    if (row != gTxIndexes.end())
+    {
+        *ppIndex = &row->second;
+        goto exit;
+    }
 
-    // load the transaction
-    ABC_CHECK_RET(ABC_TxLoadTransaction(self, szFilename, &pTx, pError));
-    ABC_CHECK_NULL(pTx->pDetails);
-    ABC_CHECK_NULL(pTx->pStateInfo);
+    pIndex = &gTxIndexes[self.szUUID];
 
-    // steal the data and assign it to our new struct
-    ABC_NEW(pTransaction, tABC_TxInfo);
-    pTransaction->szID = pTx->szID;
-    pTx->szID = NULL;
-    pTransaction->szMalleableTxId = pTx->pStateInfo->szMalleableTxId;
-    pTx->pStateInfo->szMalleableTxId = NULL;
-    pTransaction->timeCreation = pTx->pStateInfo->timeCreation;
-    pTransaction->pDetails = pTx->pDetails;
-    pTx->pDetails = NULL;
-    pTransaction->countOutputs = pTx->countOutputs;
-    pTx->countOutputs = 0;
-    pTransaction->aOutputs = pTx->aOutputs;
-    pTx->aOutputs = NULL;
+    // get the master key we will need to decode the transactions
+    ABC_CHECK_RET(ABC_WalletGetMK(self, &MK, pError));
 
-    // assign final result
-    *ppTransaction = pTransaction;
-    pTransaction = NULL;
+    // get the directory name
+    ABC_CHECK_RET(ABC_WalletGetTxDirName(&szTxDir, self.szUUID, pError));
+
+    // get all the stored transactions
+    ABC_CHECK_RET(ABC_TxStoreList(self, szTxDir, &pFileList, pError));
+
+    if (pFileList->nCount > 0)
+    {
+        ABC_STR_NEW(szFilename, ABC_FILEIO_MAX_PATH_LENGTH + 1);
+
+        for (int i = 0; i < pFileList->nCount; i++)
+        {
+            // if this file is a normal file
+            if (pFileList->apFiles[i]->type == ABC_FileIOFileType_Regular)
+            {
+                // create the filename for this transaction
+                sprintf(szFilename, "%s/%s", szTxDir, pFileList->apFiles[i]->szName);
+
+                // get the transaction type
+                tTxType type = TxType_None;
+                ABC_CHECK_RET(ABC_TxGetTxTypeAndBasename(szFilename, &type, NULL, pError));
+
+                // if this is a transaction file (based upon name)
+                if (type != TxType_None)
+                {
+                    bool bHasInternalEquivalent = false;
+
+                    // if this is an external transaction
+                    if (type == TxType_External)
+                    {
+                        // check if it has an internal equivalent and, if so, delete the external
+                        ABC_CHECK_RET(ABC_TxCheckForInternalEquivalent(self, szFilename, &bHasInternalEquivalent, pError));
+                    }
+
+                    // if this doesn't not have an internal equivalent (or is an internal itself)
+                    if (bHasInternalEquivalent == false)
+                    {
+                        jobs.emplace_back();
+                        ABC_CHECK_RET(ABC_TxStoreJob(self, szFilename, MK, jobs.back(), pError));
+                    }
+                }
+            }
+        }
+    }
+
+    // decrypt everything at once, then add it to the index
+    ABC_CHECK_RET(ABC_CryptoDecryptJSONBatch(jobs, pError));
+    for (auto &job: jobs)
+    {
+        ABC_CHECK_RET(ABC_TxDecodeTransaction(job.result, &pTx, pError));
+        pIndex->byTime.insert(std::make_pair(pTx->pStateInfo->timeCreation, std::string(pTx->szID)));
+        pIndex->search.insert(pTx->szID, ABC_TxSearchFields(pTx));
+        pIndex->txs[pTx->szID] = pTx;
+        pTx = NULL;
+    }
+
+    *ppIndex = pIndex;
+    pIndex = NULL;
 
 exit:
+    // don't leave a half-built index behind
+    if (pIndex)
+        gTxIndexes.erase(self.szUUID);
+    ABC_FREE_STR(szTxDir);
+    ABC_FREE_STR(szFilename);
+    ABC_FileIOFreeFileList(pFileList);
     ABC_TxFreeTx(pTx);
-    ABC_TxFreeTransaction(pTransaction);
+    for (auto &job: jobs)
+        if (job.result) json_decref(job.result);
 
     return cc;
 }
 
 /**
- * Loads the given transaction info and adds it to the end of the array
+ * Updates a wallet's transaction index after a transaction has been saved.
+ * If the index hasn't been loaded yet, this does nothing,
+ * since the next load will pick up the file anyhow.
  *
- * @param szFilename        Filename of transaction
- * @param paTransactions    Pointer to array into which the transaction will be added
- * @param pCount            Pointer to store number of transactions (will be updated)
+ * @param pTx               The transaction that was just written
  * @param pError            A pointer to the location to store the error if there is one
  */
 static
-tABC_CC ABC_TxLoadTxAndAppendToArray(tABC_WalletID self,
-                                     int64_t startTime,
-                                     int64_t endTime,
-                                     const char *szFilename,
-                                     tABC_TxInfo ***paTransactions,
-                                     unsigned int *pCount,
-                                     tABC_Error *pError)
+tABC_CC ABC_TxIndexUpdate(tABC_WalletID self,
+                          const tABC_Tx *pTx,
+                          tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+    AutoCoreLock lock(gCoreMutex);
 
-    tABC_TxInfo *pTransaction = NULL;
-    tABC_TxInfo **aTransactions = NULL;
-    unsigned int count = 0;
+    tABC_Tx *pNewTx = NULL;
 
-    // hold on to current values
-    count = *pCount;
-    aTransactions = *paTransactions;
+    auto row = gTxIndexes.find(self.szUUID);
+    if (row != gTxIndexes.end())
+    {
+        TxIndex &index = row->second;
+        ABC_CHECK_RET(ABC_TxDupTx(&pNewTx, pTx, pError));
+
+        // replace any older version of this transaction
+        auto old = index.txs.find(pNewTx->szID);
+        if (old != index.txs.end())
+        {
+            index.byTime.erase(std::make_pair(old->second->pStateInfo->timeCreation, old->first));
+            ABC_TxFreeTx(old->second);
+            index.txs.erase(old);
+        }
 
-    // load it into the info transaction structure
-    ABC_CHECK_RET(ABC_TxLoadTransactionInfo(self, szFilename, &pTransaction, pError));
+        index.byTime.insert(std::make_pair(pNewTx->pStateInfo->timeCreation, std::string(pNewTx->szID)));
+        index.search.insert(pNewTx->szID, ABC_TxSearchFields(pNewTx));
+        index.txs[pNewTx->szID] = pNewTx;
+        pNewTx = NULL;
+
+        ABC_TxBalanceUpdate(self, pTx->szID);
+    }
+
+exit:
+    ABC_TxFreeTx(pNewTx);
 
-    if ((endTime == ABC_GET_TX_ALL_TIMES) ||
-        (pTransaction->timeCreation >= startTime &&
-         pTransaction->timeCreation < endTime))
+    return cc;
+}
+
+/**
+ * Re-counts one transaction's contribution to the cached balance,
+ * based on what the watcher currently knows about it.
+ *
+ * @param pIndex            The index holding the balance
+ * @param pTx               The transaction to count
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxBalanceCount(tABC_WalletID self,
+                           TxIndex *pIndex,
+                           const tABC_Tx *pTx,
+                           tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    tABC_TxOutput **aInputs = NULL;
+    tABC_TxOutput **aOutputs = NULL;
+    unsigned int inCount = 0;
+    unsigned int outCount = 0;
+    int64_t amount = 0;
+    int64_t fees = 0;
+    bool bFound = false;
+    unsigned int height = 0;
+    const char *szMalTxId = pTx->pStateInfo->szMalleableTxId;
+
+    // back out the old amount
+    auto old = pIndex->balances.find(pTx->szID);
+    if (old != pIndex->balances.end())
     {
-        // create space for new entry
-        if (aTransactions == NULL)
+        pIndex->balance -= old->second.amount;
+        pIndex->balances.erase(old);
+    }
+
+    // transactions the watcher doesn't have don't count
+    if (!szMalTxId)
+        goto exit;
+    ABC_CHECK_RET(ABC_BridgeTxFind(self.szUUID, szMalTxId, &bFound, &height, pError));
+    if (!bFound)
+        goto exit;
+
+    ABC_CHECK_RET(ABC_BridgeTxDetailsSplit(self.szUUID, szMalTxId,
+                                           &aInputs, &inCount,
+                                           &aOutputs, &outCount,
+                                           &amount, &fees, pError));
+    for (unsigned i = 0; i < inCount; ++i)
+    {
+        if (aInputs[i]->szTxId)
+            pIndex->spenders.insert(std::make_pair(std::string(aInputs[i]->szTxId), std::string(pTx->szID)));
+    }
+
+    pIndex->balances[pTx->szID] = TxBalance{amount, 0 == height};
+    pIndex->balance += amount;
+
+exit:
+    ABC_TxFreeOutputs(aInputs, inCount);
+    ABC_TxFreeOutputs(aOutputs, outCount);
+
+    return cc;
+}
+
+/**
+ * Re-counts a group of transactions in an already-built balance.
+ * This never fails; if something goes wrong,
+ * the balance is simply rebuilt from scratch the next time it is needed.
+ */
+static
+void ABC_TxBalanceRecount(tABC_WalletID self,
+                          const std::set<std::string> &ids)
+{
+    AutoCoreLock lock(gCoreMutex);
+    tABC_Error error;
+
+    auto row = gTxIndexes.find(self.szUUID);
+    if (row == gTxIndexes.end() || !row->second.balanceLoaded)
+        return;
+    TxIndex &index = row->second;
+
+    for (const auto &id: ids)
+    {
+        auto tx = index.txs.find(id);
+        if (tx != index.txs.end() &&
+            ABC_CC_Ok != ABC_TxBalanceCount(self, &index, tx->second, &error))
         {
-            ABC_ARRAY_NEW(aTransactions, 1, tABC_TxInfo*);
-            count = 1;
+            ABC_TxBalanceReset(&index);
+            return;
         }
-        else
+    }
+}
+
+/**
+ * Applies a change in one transaction to the cached balance.
+ * Transactions spending from it get re-counted too,
+ * since their amounts depend on the outputs they spend.
+ */
+static
+void ABC_TxBalanceUpdate(tABC_WalletID self,
+                         const char *szID)
+{
+    AutoCoreLock lock(gCoreMutex);
+
+    auto row = gTxIndexes.find(self.szUUID);
+    if (row == gTxIndexes.end() || !row->second.balanceLoaded)
+        return;
+    TxIndex &index = row->second;
+
+    auto tx = index.txs.find(szID);
+    if (tx == index.txs.end())
+        return;
+
+    std::set<std::string> ids;
+    ids.insert(szID);
+    const char *szMalTxId = tx->second->pStateInfo->szMalleableTxId;
+    if (szMalTxId)
+    {
+        const std::string parent(szMalTxId);
+        for (auto i = index.spenders.lower_bound(std::make_pair(parent, std::string()));
+             i != index.spenders.end() && i->first == parent; ++i)
+            ids.insert(i->second);
+    }
+
+    ABC_TxBalanceRecount(self, ids);
+}
+
+/**
+ * Throws away a wallet's cached balance, so the next
+ * ABC_TxGetBalance will count every transaction again.
+ */
+static
+void ABC_TxBalanceReset(TxIndex *pIndex)
+{
+    pIndex->balances.clear();
+    pIndex->spenders.clear();
+    pIndex->balance = 0;
+    pIndex->balanceLoaded = false;
+}
+
+/**
+ * Gets the wallet balance, counting only the transactions
+ * the watcher knows about.
+ *
+ * The first call counts every transaction in the wallet.
+ * After that, the balance is kept up to date as transactions are saved,
+ * received, or confirmed, so this is cheap to call after every event.
+ *
+ * @param pBalance          The location to store the balance, in satoshis
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+tABC_CC ABC_TxGetBalance(tABC_WalletID self,
+                         int64_t *pBalance,
+                         tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
+
+    TxIndex *pIndex = NULL;
+
+    ABC_CHECK_RET(ABC_TxIndexLoad(self, &pIndex, pError));
+    if (!pIndex->balanceLoaded)
+    {
+        ABC_TxBalanceReset(pIndex);
+        for (const auto &i: pIndex->txs)
+            ABC_CHECK_RET(ABC_TxBalanceCount(self, pIndex, i.second, pError));
+        pIndex->balanceLoaded = true;
+    }
+
+    *pBalance = pIndex->balance;
+
+exit:
+    return cc;
+}
+
+/**
+ * Lists the text a transaction can be found by in ABC_TxSearchTransactions.
+ */
+static
+std::list<std::string> ABC_TxSearchFields(const tABC_Tx *pTx)
+{
+    std::list<std::string> fields;
+    const tABC_TxDetails *pDetails = pTx->pDetails;
+    if (pDetails)
+    {
+        char szAmount[64];
+        snprintf(szAmount, sizeof(szAmount), "%ld", (long)pDetails->amountSatoshi);
+        fields.push_back(szAmount);
+        snprintf(szAmount, sizeof(szAmount), "%f", pDetails->amountCurrency);
+        fields.push_back(szAmount);
+
+        if (pDetails->szName)
+            fields.push_back(pDetails->szName);
+        if (pDetails->szCategory)
+            fields.push_back(pDetails->szCategory);
+        if (pDetails->szNotes)
+            fields.push_back(pDetails->szNotes);
+    }
+    return fields;
+}
+
+/**
+ * Clears all the transaction and address indexes, logs, and address chains,
+ * forcing them to be re-read from disk.
+ */
+void ABC_TxClearCache()
+{
+    AutoCoreLock lock(gCoreMutex);
+
+    gTxIndexes.clear();
+    gTxAddressIndexes.clear();
+    gTxLogs.clear();
+    gTxChains.clear();
+}
+
+/**
+ * Closes the active segment of a wallet's transaction log, if it is loaded,
+ * so files already committed to the sync repo never change again.
+ */
+void ABC_TxSealLog(tABC_WalletID self)
+{
+    AutoCoreLock lock(gCoreMutex);
+
+    auto row = gTxLogs.find(self.szUUID);
+    if (row != gTxLogs.end() && row->second)
+        row->second->seal();
+}
+
+/**
+ * Maps a transaction or address filename to its key in the transaction log.
+ * The key is the path relative to the wallet's sync directory,
+ * such as "Transactions/<name>".
+ */
+static
+std::string ABC_TxStoreKey(const std::string &path)
+{
+    auto slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0)
+        slash = path.rfind('/', slash - 1);
+    return std::string::npos == slash ? path : path.substr(slash + 1);
+}
+
+/**
+ * Finds the transaction log for a wallet, loading it if needed.
+ *
+ * @param ppLog             Location to store the log, or NULL if the wallet
+ *                          still keeps one file per record
+ *                          (owned by the cache, do not free)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxStoreLog(tABC_WalletID self,
+                       RecordLog **ppLog,
+                       tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
+
+    char *szLogDir = NULL;
+    bool bExists = false;
+    std::string writer;
+
+    auto row = gTxLogs.find(self.szUUID);
+    *ppLog = NULL;
+
+    if (row == gTxLogs.end())
+    {
+        std::unique_ptr<RecordLog> log;
+
+        // the log directory only exists once the wallet has been migrated
+        ABC_CHECK_RET(ABC_WalletGetLogDirName(&szLogDir, self.szUUID, pError));
+        ABC_CHECK_RET(ABC_FileIOFileExists(szLogDir, &bExists, pError));
+        if (bExists)
         {
-            count++;
-            ABC_ARRAY_RESIZE(aTransactions, count, tABC_TxInfo*);
+            ABC_CHECK_RET(ABC_TxStoreWriter(self, writer, pError));
+            log.reset(new RecordLog(szLogDir, writer));
+            ABC_CHECK_NEW(log->load(), pError);
         }
 
-        // add it to the array
-        aTransactions[count - 1] = pTransaction;
-        pTransaction = NULL;
+        row = gTxLogs.emplace(self.szUUID, std::move(log)).first;
+    }
 
-        // assign the values to the caller
-        *paTransactions = aTransactions;
-        *pCount = count;
+    *ppLog = row->second.get();
+
+exit:
+    ABC_FREE_STR(szLogDir);
+
+    return cc;
+}
+
+/**
+ * Gets this device's name for writing to a wallet's transaction log,
+ * creating one if needed. The name lives outside the sync directory,
+ * since every device needs its own.
+ */
+static
+tABC_CC ABC_TxStoreWriter(tABC_WalletID self,
+                          std::string &writer,
+                          tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    char *szWalletDir = NULL;
+    std::string filename;
+    DataChunk data;
+    bool bExists = false;
+
+    ABC_CHECK_RET(ABC_WalletGetDirName(&szWalletDir, self.szUUID, pError));
+    filename = std::string(szWalletDir) + "/" + TX_LOG_WRITER_FILENAME;
+
+    writer.clear();
+    ABC_CHECK_RET(ABC_FileIOFileExists(filename.c_str(), &bExists, pError));
+    if (bExists)
+    {
+        ABC_CHECK_NEW(fileLoad(data, filename), pError);
+        writer = toString(data);
+    }
+
+    if (writer.empty())
+    {
+        ABC_CHECK_NEW(randomUuid(writer), pError);
+        ABC_CHECK_NEW(fileSave(writer, filename), pError);
+    }
+
+exit:
+    ABC_FREE_STR(szWalletDir);
+
+    return cc;
+}
+
+/**
+ * Decides whether the transaction log holds the current version of a
+ * transaction or address. Once the log has seen a record, written or
+ * erased, it always wins. Loose files only fill in records the log has
+ * never seen, since file times say nothing useful about their contents:
+ * a git checkout stamps every file with the time of the checkout.
+ *
+ * @param pLog              The wallet's log, or NULL if it has none
+ */
+static
+bool ABC_TxStoreUseLog(RecordLog *pLog, const char *szFilename)
+{
+    return pLog && pLog->stamp(ABC_TxStoreKey(szFilename));
+}
+
+/**
+ * Checks if a transaction or address has been stored.
+ */
+static
+tABC_CC ABC_TxStoreExists(tABC_WalletID self,
+                          const char *szFilename,
+                          bool *pbExists,
+                          tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    RecordLog *pLog = NULL;
+    DataChunk data;
 
+    *pbExists = false;
+
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+    if (ABC_TxStoreUseLog(pLog, szFilename))
+        *pbExists = pLog->get(data, ABC_TxStoreKey(szFilename));
+    else
+        ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, pbExists, pError));
+
+exit:
+    return cc;
+}
+
+/**
+ * Lists the transactions or addresses stored under the given directory.
+ * When the wallet uses the transaction log, this also includes any
+ * loose files, since devices without log support still write those.
+ *
+ * @param ppFileList        Location to store the list
+ *                          (caller must free with ABC_FileIOFreeFileList)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxStoreList(tABC_WalletID self,
+                        const char *szDir,
+                        tABC_FileIOList **ppFileList,
+                        tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
+    AutoFileLock fileLock(gFileMutex); // We are iterating over the filesystem
+
+    RecordLog *pLog = NULL;
+    tABC_FileIOList *pFileList = NULL;
+    std::set<std::string> names;
+    bool bExists = false;
+
+    *ppFileList = NULL;
+
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+
+    ABC_CHECK_RET(ABC_FileIOFileExists(szDir, &bExists, pError));
+    if (bExists)
+    {
+        ABC_CHECK_RET(ABC_FileIOCreateFileList(&pFileList, szDir, pError));
+        for (int i = 0; i < pFileList->nCount; i++)
+            names.insert(pFileList->apFiles[i]->szName);
+    }
+    else
+    {
+        ABC_NEW(pFileList, tABC_FileIOList);
+    }
+
+    if (pLog)
+    {
+        std::string prefix = ABC_TxStoreKey(std::string(szDir) + "/");
+        for (const auto &key: pLog->keys(prefix))
+        {
+            std::string name = key.substr(prefix.size());
+            if (name.find('/') != std::string::npos || names.count(name))
+                continue;
+
+            if (pFileList->nCount)
+            {
+                ABC_ARRAY_RESIZE(pFileList->apFiles, pFileList->nCount + 1, tABC_FileIOFileInfo*);
+            }
+            else
+            {
+                ABC_ARRAY_NEW(pFileList->apFiles, 1, tABC_FileIOFileInfo*);
+            }
+
+            pFileList->apFiles[pFileList->nCount] = NULL;
+            ABC_NEW(pFileList->apFiles[pFileList->nCount], tABC_FileIOFileInfo);
+            ABC_STRDUP(pFileList->apFiles[pFileList->nCount]->szName, name.c_str());
+            pFileList->apFiles[pFileList->nCount]->type = ABC_FileIOFileType_Regular;
+            pFileList->nCount++;
+        }
+    }
+
+    *ppFileList = pFileList;
+    pFileList = NULL;
+
+exit:
+    ABC_FileIOFreeFileList(pFileList);
+
+    return cc;
+}
+
+/**
+ * Sets up a decryption job for a stored transaction or address,
+ * so several can be decrypted at once with ABC_CryptoDecryptJSONBatch.
+ */
+static
+tABC_CC ABC_TxStoreJob(tABC_WalletID self,
+                       const char *szFilename,
+                       tABC_U08Buf MK,
+                       DecryptJob &job,
+                       tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    RecordLog *pLog = NULL;
+    DataChunk data;
+
+    job.filename = szFilename;
+    job.encrypted.clear();
+    job.key = MK;
+    job.result = NULL;
+
+    // log records hold the same encrypted json a file would
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+    if (ABC_TxStoreUseLog(pLog, szFilename) &&
+        pLog->get(data, ABC_TxStoreKey(szFilename)))
+        job.encrypted = toString(data);
+
+exit:
+    return cc;
+}
+
+/**
+ * Loads and decrypts a stored transaction or address.
+ *
+ * @param ppJSON_Data       Location to store the decrypted json object
+ *                          (caller must json_decref)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxStoreLoad(tABC_WalletID self,
+                        const char *szFilename,
+                        tABC_U08Buf MK,
+                        json_t **ppJSON_Data,
+                        tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    std::vector<DecryptJob> jobs(1);
+
+    *ppJSON_Data = NULL;
+
+    ABC_CHECK_RET(ABC_TxStoreJob(self, szFilename, MK, jobs[0], pError));
+    ABC_CHECK_RET(ABC_CryptoDecryptJSONBatch(jobs, pError));
+    *ppJSON_Data = jobs[0].result;
+
+exit:
+    return cc;
+}
+
+/**
+ * Encrypts and stores a transaction or address,
+ * either to its own file or to the wallet's transaction log.
+ */
+static
+tABC_CC ABC_TxStoreSave(tABC_WalletID self,
+                        json_t *pJSON_Data,
+                        tABC_U08Buf MK,
+                        const char *szFilename,
+                        tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    RecordLog *pLog = NULL;
+    std::string data;
+    std::string encrypted;
+    json_t *pJSON_Enc = NULL;
+
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+    if (pLog)
+    {
+        ABC_CHECK_NEW(JsonFile(json_incref(pJSON_Data)).encode(data), pError);
+        // Match ABC_CryptoEncryptJSONFileObject, which null-terminates:
+        data.push_back(0);
+        // Only this version reads logs, so they can use the compact format:
+        ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(toU08Buf(data), MK, ABC_CryptoType_AES256_GCM, &pJSON_Enc, pError));
+        ABC_CHECK_NEW(JsonFile(json_incref(pJSON_Enc)).encode(encrypted), pError);
+        ABC_CHECK_NEW(pLog->set(ABC_TxStoreKey(szFilename), encrypted), pError);
+    }
+    else
+    {
+        ABC_CHECK_RET(ABC_CryptoEncryptJSONFileObject(pJSON_Data, MK, ABC_CryptoType_AES256, szFilename, pError));
+    }
+
+exit:
+    if (pJSON_Enc) json_decref(pJSON_Enc);
+
+    return cc;
+}
+
+/**
+ * Removes a stored transaction or address.
+ */
+static
+tABC_CC ABC_TxStoreDelete(tABC_WalletID self,
+                          const char *szFilename,
+                          tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    RecordLog *pLog = NULL;
+    bool bExists = false;
+
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+    if (pLog)
+    {
+        ABC_CHECK_NEW(pLog->erase(ABC_TxStoreKey(szFilename)), pError);
+    }
+
+    ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
+    if (bExists)
+    {
+        ABC_CHECK_RET(ABC_FileIODeleteFile(szFilename, pError));
+    }
+
+exit:
+    return cc;
+}
+
+/**
+ * Moves a wallet's transactions and addresses out of their individual
+ * files and into a single append-only log, which is much faster to load.
+ * The log is built off to the side and renamed into place,
+ * so this can safely be re-run if it gets interrupted.
+ *
+ * Devices without log support will not see records written to the log,
+ * so this should only be done once all of a user's devices are upgraded.
+ */
+tABC_CC ABC_TxMigrateToLog(tABC_WalletID self,
+                           tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
+    AutoFileLock fileLock(gFileMutex);
+
+    char *szLogDir = NULL;
+    char *szTxDir = NULL;
+    char *szAddrDir = NULL;
+    tABC_FileIOList *pFileList = NULL;
+    std::map<std::string, DataChunk> records;
+    std::string tempDir;
+    std::string writer;
+    bool bExists = false;
+
+    ABC_CHECK_RET(ABC_WalletGetLogDirName(&szLogDir, self.szUUID, pError));
+    ABC_CHECK_RET(ABC_WalletGetTxDirName(&szTxDir, self.szUUID, pError));
+    ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, self.szUUID, pError));
+
+    ABC_CHECK_RET(ABC_FileIOFileExists(szLogDir, &bExists, pError));
+    if (!bExists)
+    {
+        const char *aszDirs[] = {szTxDir, szAddrDir};
+
+        // gather up the existing files, which are already encrypted
+        for (auto szDir: aszDirs)
+        {
+            ABC_CHECK_RET(ABC_FileIOFileExists(szDir, &bExists, pError));
+            if (!bExists)
+                continue;
+
+            ABC_FileIOFreeFileList(pFileList);
+            pFileList = NULL;
+            ABC_CHECK_RET(ABC_FileIOCreateFileList(&pFileList, szDir, pError));
+            for (int i = 0; i < pFileList->nCount; i++)
+            {
+                if (pFileList->apFiles[i]->type == ABC_FileIOFileType_Regular)
+                {
+                    std::string filename = std::string(szDir) + "/" + pFileList->apFiles[i]->szName;
+                    ABC_CHECK_NEW(fileLoad(records[ABC_TxStoreKey(filename)], filename), pError);
+                }
+            }
+        }
+
+        // write the log to a temporary location
+        tempDir = std::string(szLogDir) + ".tmp";
+        ABC_CHECK_RET(ABC_FileIODeleteRecursive(tempDir.c_str(), pError));
+        ABC_CHECK_RET(ABC_TxStoreWriter(self, writer, pError));
+        {
+            RecordLog log(tempDir, writer);
+            ABC_CHECK_NEW(log.load(), pError);
+            ABC_CHECK_NEW(log.set(records), pError);
+        }
+
+        // put it in place
+        ABC_CHECK_SYS(!rename(tempDir.c_str(), szLogDir), "rename");
+    }
+
+    // the log has everything now, so the old files can go
+    ABC_CHECK_RET(ABC_FileIODeleteRecursive(szTxDir, pError));
+    ABC_CHECK_RET(ABC_FileIODeleteRecursive(szAddrDir, pError));
+
+    // start using the log
+    gTxLogs.erase(self.szUUID);
+    gTxIndexes.erase(self.szUUID);
+    gTxAddressIndexes.erase(self.szUUID);
+
+exit:
+    ABC_FREE_STR(szLogDir);
+    ABC_FREE_STR(szTxDir);
+    ABC_FREE_STR(szAddrDir);
+    ABC_FileIOFreeFileList(pFileList);
+
+    return cc;
+}
+
+/**
+ * Makes a copy of the on-disk portion of a transaction
+ * (the outputs come from the watcher, so they are not copied).
+ *
+ * @param ppNewTx           Location to store the allocated copy
+ *                          (caller must free)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxDupTx(tABC_Tx **ppNewTx,
+                    const tABC_Tx *pOldTx,
+                    tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    tABC_Tx *pTx = NULL;
+
+    ABC_CHECK_NULL(pOldTx->pStateInfo);
+    ABC_CHECK_NULL(pOldTx->pDetails);
+
+    ABC_NEW(pTx, tABC_Tx);
+    ABC_STRDUP(pTx->szID, pOldTx->szID);
+    ABC_CHECK_RET(ABC_TxDupDetails(&pTx->pDetails, pOldTx->pDetails, pError));
+    ABC_NEW(pTx->pStateInfo, tTxStateInfo);
+    pTx->pStateInfo->timeCreation = pOldTx->pStateInfo->timeCreation;
+    pTx->pStateInfo->bInternal = pOldTx->pStateInfo->bInternal;
+    if (pOldTx->pStateInfo->szMalleableTxId)
+    {
+        ABC_STRDUP(pTx->pStateInfo->szMalleableTxId, pOldTx->pStateInfo->szMalleableTxId);
     }
 
+    // assign final result
+    *ppNewTx = pTx;
+    pTx = NULL;
+
+exit:
+    ABC_TxFreeTx(pTx);
+
+    return cc;
+}
+
+/**
+ * Creates a transaction info structure from an indexed transaction,
+ * filling in the amounts and outputs from the watcher.
+ *
+ * @param pTx               The indexed transaction
+ * @param ppTransaction     Location to store allocated transaction
+ *                          (caller must free)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxCreateTxInfo(tABC_WalletID self,
+                           const tABC_Tx *pTx,
+                           tABC_TxInfo **ppTransaction,
+                           tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    tABC_TxInfo *pTransaction = NULL;
+
+    *ppTransaction = NULL;
+
+    ABC_CHECK_NULL(pTx->pDetails);
+    ABC_CHECK_NULL(pTx->pStateInfo);
+
+    ABC_NEW(pTransaction, tABC_TxInfo);
+    ABC_STRDUP(pTransaction->szID, pTx->szID);
+    if (pTx->pStateInfo->szMalleableTxId)
+    {
+        ABC_STRDUP(pTransaction->szMalleableTxId, pTx->pStateInfo->szMalleableTxId);
+    }
+    pTransaction->timeCreation = pTx->pStateInfo->timeCreation;
+    ABC_CHECK_RET(ABC_TxDupDetails(&pTransaction->pDetails, pTx->pDetails, pError));
+
+    // get advanced details
+    ABC_CHECK_RET(
+        ABC_BridgeTxDetails(self.szUUID, pTransaction->szMalleableTxId,
+                            &(pTransaction->aOutputs), &(pTransaction->countOutputs),
+                            &(pTransaction->pDetails->amountSatoshi),
+                            &(pTransaction->pDetails->amountFeesMinersSatoshi),
+                            pError));
+
+    // assign final result
+    *ppTransaction = pTransaction;
+    pTransaction = NULL;
+
 exit:
     ABC_TxFreeTransaction(pTransaction);
 
@@ -2060,6 +2839,7 @@ void ABC_TxFreeTransaction(tABC_TxInfo *pTransaction)
     if (pTransaction)
     {
         ABC_FREE_STR(pTransaction->szID);
+        ABC_FREE_STR(pTransaction->szMalleableTxId);
         ABC_TxFreeOutputs(pTransaction->aOutputs, pTransaction->countOutputs);
         ABC_TxFreeDetails(pTransaction->pDetails);
         ABC_CLEAR_FREE(pTransaction, sizeof(tABC_TxInfo));
@@ -2096,36 +2876,16 @@ void ABC_TxFreeTransactions(tABC_TxInfo **aTransactions,
 tABC_CC ABC_TxSetTransactionDetails(tABC_WalletID self,
                                     const char *szID,
                                     tABC_TxDetails *pDetails,
-                                    tABC_Error *pError)
-{
-    tABC_CC cc = ABC_CC_Ok;
-    AutoCoreLock lock(gCoreMutex);
-
-    char *szFilename = NULL;
-    tABC_Tx *pTx = NULL;
-    bool bExists = false;
-
-    // find the filename of the existing transaction
-
-    // first try the internal
-    ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, true, pError));
-    ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-
-    // if the internal doesn't exist
-    if (bExists == false)
-    {
-        // try the external
-        ABC_FREE_STR(szFilename);
-        ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, false, pError));
-        ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-    }
+                                    tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    AutoCoreLock lock(gCoreMutex);
 
-    ABC_CHECK_ASSERT(bExists == true, ABC_CC_NoTransaction, "Transaction does not exist");
+    tABC_Tx *pTx = NULL;
 
     // load the existing transaction
-    ABC_CHECK_RET(ABC_TxLoadTransaction(self, szFilename, &pTx, pError));
-    ABC_CHECK_NULL(pTx->pDetails);
-    ABC_CHECK_NULL(pTx->pStateInfo);
+    ABC_CHECK_RET(ABC_TxTransactionExists(self, szID, &pTx, pError));
+    ABC_CHECK_ASSERT(pTx != NULL, ABC_CC_NoTransaction, "Transaction does not exist");
 
     // modify the details
     pTx->pDetails->amountSatoshi = pDetails->amountSatoshi;
@@ -2145,7 +2905,6 @@ tABC_CC ABC_TxSetTransactionDetails(tABC_WalletID self,
     ABC_CHECK_RET(ABC_TxSaveTransaction(self, pTx, pError));
 
 exit:
-    ABC_FREE_STR(szFilename);
     ABC_TxFreeTx(pTx);
 
     return cc;
@@ -2167,32 +2926,12 @@ tABC_CC ABC_TxGetTransactionDetails(tABC_WalletID self,
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
 
-    char *szFilename = NULL;
     tABC_Tx *pTx = NULL;
     tABC_TxDetails *pDetails = NULL;
-    bool bExists = false;
-
-    // find the filename of the existing transaction
-
-    // first try the internal
-    ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, true, pError));
-    ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-
-    // if the internal doesn't exist
-    if (bExists == false)
-    {
-        // try the external
-        ABC_FREE_STR(szFilename);
-        ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, false, pError));
-        ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-    }
-
-    ABC_CHECK_ASSERT(bExists == true, ABC_CC_NoTransaction, "Transaction does not exist");
 
     // load the existing transaction
-    ABC_CHECK_RET(ABC_TxLoadTransaction(self, szFilename, &pTx, pError));
-    ABC_CHECK_NULL(pTx->pDetails);
-    ABC_CHECK_NULL(pTx->pStateInfo);
+    ABC_CHECK_RET(ABC_TxTransactionExists(self, szID, &pTx, pError));
+    ABC_CHECK_ASSERT(pTx != NULL, ABC_CC_NoTransaction, "Transaction does not exist");
 
     // duplicate the details
     ABC_CHECK_RET(ABC_TxDupDetails(&pDetails, pTx->pDetails, pError));
@@ -2203,7 +2942,6 @@ tABC_CC ABC_TxGetTransactionDetails(tABC_WalletID self,
 
 
 exit:
-    ABC_FREE_STR(szFilename);
     ABC_TxFreeTx(pTx);
     ABC_TxFreeDetails(pDetails);
 
@@ -2253,80 +2991,32 @@ tABC_CC ABC_TxGetPendingRequests(tABC_WalletID self,
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
 
-    tABC_TxAddress **aAddresses = NULL;
-    unsigned int count = 0;
+    TxAddressIndex *pIndex = NULL;
     tABC_RequestInfo **aRequests = NULL;
     unsigned int countPending = 0;
-    tABC_RequestInfo *pRequest = NULL;
 
     *paRequests = NULL;
     *pCount = 0;
 
-    // start by retrieving all address for this wallet
-    ABC_CHECK_RET(ABC_TxGetAddresses(self, &aAddresses, &count, pError));
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
 
-    // if there are any addresses
-    if (count > 0)
+    // the index already knows which requests still have money owed
+    if (!pIndex->owed.empty())
     {
-        // print out the addresses - debug
-        //ABC_TxPrintAddresses(aAddresses, count);
-
-        // walk through all the addresses looking for those with outstanding balances
-        for (unsigned i = 0; i < count; i++)
+        ABC_ARRAY_NEW(aRequests, pIndex->owed.size(), tABC_RequestInfo*);
+        for (const auto &owed: pIndex->owed)
         {
-            tABC_TxAddress *pAddr = aAddresses[i];
-            ABC_CHECK_NULL(pAddr);
-            tABC_TxDetails  *pDetails = pAddr->pDetails;
-
-            // if this address has user details associated with it (i.e., was created by the user)
-            if (pDetails)
-            {
-                tTxAddressStateInfo *pState = pAddr->pStateInfo;
-                ABC_CHECK_NULL(pState);
-
-                // if this is not a recyclable address (i.e., it was specifically used for a transaction)
-                if (pState->bRecycleable == false)
-                {
-                    // if this address was used for a request of funds (i.e., not a send)
-                    int64_t requestSatoshi = pDetails->amountSatoshi;
-                    if (requestSatoshi >= 0)
-                    {
-                        // get the outstanding balanace on this request/address
-                        int64_t owedSatoshi = 0;
-                        ABC_CHECK_RET(ABC_TxGetAddressOwed(pAddr, &owedSatoshi, pError));
-
-                        // if money is still owed
-                        if (owedSatoshi > 0)
-                        {
-                            // create this request
-                            ABC_NEW(pRequest, tABC_RequestInfo);
-                            ABC_STRDUP(pRequest->szID, pAddr->szID);
-                            pRequest->timeCreation = pState->timeCreation;
-                            pRequest->owedSatoshi = owedSatoshi;
-                            pRequest->amountSatoshi = pDetails->amountSatoshi - owedSatoshi;
-                            pRequest->pDetails = pDetails; // steal the info as is
-                            pDetails = NULL;
-                            pAddr->pDetails = NULL; // we are taking this for our own so later we don't want to free it
-
-                            // increase the array size
-                            if (countPending > 0)
-                            {
-                                countPending++;
-                                ABC_ARRAY_RESIZE(aRequests, countPending, tABC_RequestInfo*);
-                            }
-                            else
-                            {
-                                ABC_ARRAY_NEW(aRequests, 1, tABC_RequestInfo*);
-                                countPending = 1;
-                            }
-
-                            // add it to the array
-                            aRequests[countPending - 1] = pRequest;
-                            pRequest = NULL;
-                        }
-                    }
-                }
-            }
+            const tABC_TxAddress *pAddr = pIndex->addresses[owed.first];
+
+            // create this request
+            tABC_RequestInfo *pRequest = NULL;
+            ABC_NEW(pRequest, tABC_RequestInfo);
+            aRequests[countPending++] = pRequest;
+            ABC_STRDUP(pRequest->szID, pAddr->szID);
+            pRequest->timeCreation = pAddr->pStateInfo->timeCreation;
+            pRequest->owedSatoshi = owed.second;
+            pRequest->amountSatoshi = pAddr->pDetails->amountSatoshi - owed.second;
+            ABC_CHECK_RET(ABC_TxDupDetails(&pRequest->pDetails, pAddr->pDetails, pError));
         }
     }
 
@@ -2337,9 +3027,7 @@ tABC_CC ABC_TxGetPendingRequests(tABC_WalletID self,
     countPending = 0;
 
 exit:
-    ABC_TxFreeAddresses(aAddresses, count);
     ABC_TxFreeRequests(aRequests, countPending);
-    ABC_TxFreeRequest(pRequest);
 
     return cc;
 }
@@ -2566,7 +3254,9 @@ exit:
 }
 
 /**
- * Loads a transaction from disk
+ * Loads a transaction from disk.
+ * This only decodes the file contents; the amounts and outputs
+ * come from the watcher when the transaction is handed out.
  *
  * @param ppTx  Pointer to location to hold allocated transaction
  *              (it is the callers responsiblity to free this transaction)
@@ -2582,9 +3272,7 @@ tABC_CC ABC_TxLoadTransaction(tABC_WalletID self,
 
     tABC_U08Buf MK = ABC_BUF_NULL; // Do not free
     json_t *pJSON_Root = NULL;
-    tABC_Tx *pTx = NULL;
     bool bExists = false;
-    json_t *jsonVal = NULL;
 
     *ppTx = NULL;
 
@@ -2593,13 +3281,36 @@ tABC_CC ABC_TxLoadTransaction(tABC_WalletID self,
     ABC_CHECK_RET(ABC_WalletGetMK(self, &MK, pError));
 
     // make sure the transaction exists
-    ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
+    ABC_CHECK_RET(ABC_TxStoreExists(self, szFilename, &bExists, pError));
     ABC_CHECK_ASSERT(bExists == true, ABC_CC_NoTransaction, "Transaction does not exist");
 
     // load the json object (load file, decrypt it, create json object
-    ABC_CHECK_RET(ABC_CryptoDecryptJSONFileObject(szFilename, MK, &pJSON_Root, pError));
+    ABC_CHECK_RET(ABC_TxStoreLoad(self, szFilename, MK, &pJSON_Root, pError));
+    ABC_CHECK_RET(ABC_TxDecodeTransaction(pJSON_Root, ppTx, pError));
+
+exit:
+    if (pJSON_Root) json_decref(pJSON_Root);
+
+    return cc;
+}
+
+/**
+ * Decodes a transaction from its decrypted json.
+ *
+ * @param ppTx  Pointer to location to hold allocated transaction
+ *              (it is the callers responsiblity to free this transaction)
+ */
+static
+tABC_CC ABC_TxDecodeTransaction(json_t *pJSON_Root,
+                                tABC_Tx **ppTx,
+                                tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    tABC_Tx *pTx = NULL;
+    json_t *jsonVal = NULL;
 
-    // start decoding
+    *ppTx = NULL;
 
     ABC_NEW(pTx, tABC_Tx);
 
@@ -2614,19 +3325,11 @@ tABC_CC ABC_TxLoadTransaction(tABC_WalletID self,
     // get the details object
     ABC_CHECK_RET(ABC_TxDecodeTxDetails(pJSON_Root, &(pTx->pDetails), pError));
 
-    // get advanced details
-    ABC_CHECK_RET(
-        ABC_BridgeTxDetails(self.szUUID, pTx->pStateInfo->szMalleableTxId,
-                            &(pTx->aOutputs), &(pTx->countOutputs),
-                            &(pTx->pDetails->amountSatoshi),
-                            &(pTx->pDetails->amountFeesMinersSatoshi),
-                            pError));
     // assign final result
     *ppTx = pTx;
     pTx = NULL;
 
 exit:
-    if (pJSON_Root) json_decref(pJSON_Root);
     ABC_TxFreeTx(pTx);
 
     return cc;
@@ -2787,6 +3490,10 @@ void ABC_TxFreeTx(tABC_Tx *pTx)
     {
         ABC_FREE_STR(pTx->szID);
         ABC_TxFreeDetails(pTx->pDetails);
+        if (pTx->pStateInfo)
+        {
+            ABC_FREE_STR(pTx->pStateInfo->szMalleableTxId);
+        }
         ABC_CLEAR_FREE(pTx->pStateInfo, sizeof(tTxStateInfo));
         ABC_TxFreeOutputs(pTx->aOutputs, pTx->countOutputs);
         ABC_CLEAR_FREE(pTx, sizeof(tABC_Tx));
@@ -2797,14 +3504,20 @@ void ABC_TxFreeTx(tABC_Tx *pTx)
  * Creates the transaction directory if needed
  */
 static
-tABC_CC ABC_TxCreateTxDir(const char *szWalletUUID, tABC_Error *pError)
+tABC_CC ABC_TxCreateTxDir(tABC_WalletID self, tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
 
     char *szTxDir = NULL;
+    RecordLog *pLog = NULL;
+
+    // wallets using the transaction log don't need the directory
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+    if (pLog)
+        goto exit;
 
     // get the transaction directory
-    ABC_CHECK_RET(ABC_WalletGetTxDirName(&szTxDir, szWalletUUID, pError));
+    ABC_CHECK_RET(ABC_WalletGetTxDirName(&szTxDir, self.szUUID, pError));
 
     // if transaction dir doesn't exist, create it
     ABC_CHECK_NEW(fileEnsureDir(szTxDir), pError);
@@ -2893,15 +3606,17 @@ tABC_CC ABC_TxSaveTransaction(tABC_WalletID self,
     ABC_CHECK_ASSERT(e == 0, ABC_CC_JSONError, "Could not encode JSON value");
 
     // create the transaction directory if needed
-    ABC_CHECK_RET(ABC_TxCreateTxDir(self.szUUID, pError));
+    ABC_CHECK_RET(ABC_TxCreateTxDir(self, pError));
 
     // get the filename for this transaction
     ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, pTx->szID, pTx->pStateInfo->bInternal, pError));
 
     // save out the transaction object to a file encrypted with the master key
-    ABC_CHECK_RET(ABC_CryptoEncryptJSONFileObject(pJSON_Root, MK, ABC_CryptoType_AES256, szFilename, pError));
+    ABC_CHECK_RET(ABC_TxStoreSave(self, pJSON_Root, MK, szFilename, pError));
+
+    // keep the in-memory index in step with the file
+    ABC_CHECK_RET(ABC_TxIndexUpdate(self, pTx, pError));
 
-    ABC_CHECK_RET(ABC_WalletDirtyCache(self, pError));
 exit:
     ABC_FREE_STR(szFilename);
     ABC_CLEAR_FREE(ppJSON_Output, sizeof(json_t *) * pTx->countOutputs);
@@ -3021,37 +3736,6 @@ exit:
     return cc;
 }
 
-/**
- * This function is used to support sorting an array of tTxInfo pointers via qsort.
- * qsort has the following documentation for the required function:
- *
- * Pointer to a function that compares two elements.
- * This function is called repeatedly by qsort to compare two elements. It shall follow the following prototype:
- *
- * int compar (const void* p1, const void* p2);
- *
- * Taking two pointers as arguments (both converted to const void*). The function defines the order of the elements by returning (in a stable and transitive manner):
- * return value	meaning
- * <0	The element pointed by p1 goes before the element pointed by p2
- * 0	The element pointed by p1 is equivalent to the element pointed by p2
- * >0	The element pointed by p1 goes after the element pointed by p2
- *
- */
-static
-int ABC_TxInfoPtrCompare (const void * a, const void * b)
-{
-    tABC_TxInfo **ppInfoA = (tABC_TxInfo **)a;
-    tABC_TxInfo *pInfoA = (tABC_TxInfo *)*ppInfoA;
-    tABC_TxInfo **ppInfoB = (tABC_TxInfo **)b;
-    tABC_TxInfo *pInfoB = (tABC_TxInfo *)*ppInfoB;
-
-    if (pInfoA->timeCreation < pInfoB->timeCreation) return -1;
-    if (pInfoA->timeCreation == pInfoB->timeCreation) return 0;
-    if (pInfoA->timeCreation > pInfoB->timeCreation) return 1;
-
-    return 0;
-}
-
 /**
  * Sets the recycle status on an address as specified
  *
@@ -3068,28 +3752,24 @@ tABC_CC ABC_TxLoadAddress(tABC_WalletID self,
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
 
-    char *szFile = NULL;
-    char *szAddrDir = NULL;
-    char *szFilename = NULL;
+    TxAddressIndex *pIndex = NULL;
+    char *szEnd = NULL;
+    long seq = 0;
 
-    // get the filename for this address
-    ABC_CHECK_RET(ABC_GetAddressFilename(self.szUUID, szAddressID, &szFile, pError));
+    *ppAddress = NULL;
 
-    // get the directory name
-    ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, self.szUUID, pError));
+    ABC_CHECK_NULL(szAddressID);
+    ABC_CHECK_ASSERT(strlen(szAddressID) > 0, ABC_CC_Error, "No address UUID provided");
 
-    // create the full filename
-    ABC_STR_NEW(szFilename, ABC_FILEIO_MAX_PATH_LENGTH + 1);
-    sprintf(szFilename, "%s/%s", szAddrDir, szFile);
+    // the id is just the sequence number
+    seq = strtol(szAddressID, &szEnd, 10);
+    ABC_CHECK_RET(ABC_TxAddressIndexLoad(self, &pIndex, pError));
+    ABC_CHECK_ASSERT(*szEnd == '\0' && pIndex->addresses.count(seq),
+        ABC_CC_NoRequest, "Request address does not exist");
 
-    // load the request address
-    ABC_CHECK_RET(ABC_TxLoadAddressFile(self, szFilename, ppAddress, pError));
+    ABC_CHECK_RET(ABC_TxDupAddress(ppAddress, pIndex->addresses[seq], pError));
 
 exit:
-    ABC_FREE_STR(szFile);
-    ABC_FREE_STR(szAddrDir);
-    ABC_FREE_STR(szFilename);
-
     return cc;
 }
 
@@ -3110,9 +3790,7 @@ tABC_CC ABC_TxLoadAddressFile(tABC_WalletID self,
 
     tABC_U08Buf MK = ABC_BUF_NULL; // Do not free
     json_t *pJSON_Root = NULL;
-    tABC_TxAddress *pAddress = NULL;
     bool bExists = false;
-    json_t *jsonVal = NULL;
 
     *ppAddress = NULL;
 
@@ -3121,13 +3799,36 @@ tABC_CC ABC_TxLoadAddressFile(tABC_WalletID self,
     ABC_CHECK_RET(ABC_WalletGetMK(self, &MK, pError));
 
     // make sure the addresss exists
-    ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
+    ABC_CHECK_RET(ABC_TxStoreExists(self, szFilename, &bExists, pError));
     ABC_CHECK_ASSERT(bExists == true, ABC_CC_NoRequest, "Request address does not exist");
 
     // load the json object (load file, decrypt it, create json object
-    ABC_CHECK_RET(ABC_CryptoDecryptJSONFileObject(szFilename, MK, &pJSON_Root, pError));
+    ABC_CHECK_RET(ABC_TxStoreLoad(self, szFilename, MK, &pJSON_Root, pError));
+    ABC_CHECK_RET(ABC_TxDecodeAddress(pJSON_Root, ppAddress, pError));
+
+exit:
+    if (pJSON_Root) json_decref(pJSON_Root);
 
-    // start decoding
+    return cc;
+}
+
+/**
+ * Decodes an address from its decrypted json.
+ *
+ * @param ppAddress  Pointer to location to hold allocated address
+ *                   (it is the callers responsiblity to free this address)
+ */
+static
+tABC_CC ABC_TxDecodeAddress(json_t *pJSON_Root,
+                            tABC_TxAddress **ppAddress,
+                            tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    tABC_TxAddress *pAddress = NULL;
+    json_t *jsonVal = NULL;
+
+    *ppAddress = NULL;
 
     ABC_NEW(pAddress, tABC_TxAddress);
 
@@ -3154,7 +3855,6 @@ tABC_CC ABC_TxLoadAddressFile(tABC_WalletID self,
     pAddress = NULL;
 
 exit:
-    if (pJSON_Root) json_decref(pJSON_Root);
     ABC_TxFreeAddress(pAddress);
 
     return cc;
@@ -3264,6 +3964,7 @@ tABC_CC ABC_TxSaveAddress(tABC_WalletID self,
     tABC_U08Buf MK = ABC_BUF_NULL; // Do not free
     char *szFilename = NULL;
     json_t *pJSON_Root = NULL;
+    tABC_TxAddress *pNewAddress = NULL;
 
     ABC_CHECK_NULL(pAddress->pStateInfo);
     ABC_CHECK_NULL(pAddress->szID);
@@ -3290,17 +3991,26 @@ tABC_CC ABC_TxSaveAddress(tABC_WalletID self,
     ABC_CHECK_RET(ABC_TxEncodeTxDetails(pJSON_Root, pAddress->pDetails, pError));
 
     // create the address directory if needed
-    ABC_CHECK_RET(ABC_TxCreateAddressDir(self.szUUID, pError));
+    ABC_CHECK_RET(ABC_TxCreateAddressDir(self, pError));
 
     // create the filename for this transaction
     ABC_CHECK_RET(ABC_TxCreateAddressFilename(self, &szFilename, pAddress, pError));
 
     // save out the transaction object to a file encrypted with the master key
-    ABC_CHECK_RET(ABC_CryptoEncryptJSONFileObject(pJSON_Root, MK, ABC_CryptoType_AES256, szFilename, pError));
+    ABC_CHECK_RET(ABC_TxStoreSave(self, pJSON_Root, MK, szFilename, pError));
+
+    // keep the index current, if it has been loaded
+    if (gTxAddressIndexes.count(self.szUUID))
+    {
+        ABC_CHECK_RET(ABC_TxDupAddress(&pNewAddress, pAddress, pError));
+        ABC_TxAddressIndexAdd(gTxAddressIndexes[self.szUUID], pNewAddress);
+        pNewAddress = NULL;
+    }
 
 exit:
     ABC_FREE_STR(szFilename);
     if (pJSON_Root) json_decref(pJSON_Root);
+    ABC_TxFreeAddress(pNewAddress);
 
     return cc;
 }
@@ -3421,14 +4131,20 @@ exit:
  * Creates the address directory if needed
  */
 static
-tABC_CC ABC_TxCreateAddressDir(const char *szWalletUUID, tABC_Error *pError)
+tABC_CC ABC_TxCreateAddressDir(tABC_WalletID self, tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
 
     char *szAddrDir = NULL;
+    RecordLog *pLog = NULL;
+
+    // wallets using the transaction log don't need the directory
+    ABC_CHECK_RET(ABC_TxStoreLog(self, &pLog, pError));
+    if (pLog)
+        goto exit;
 
     // get the address directory
-    ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, szWalletUUID, pError));
+    ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, self.szUUID, pError));
 
     // if transaction dir doesn't exist, create it
     ABC_CHECK_NEW(fileEnsureDir(szAddrDir), pError);
@@ -3516,44 +4232,110 @@ void ABC_TxFreeOutputs(tABC_TxOutput **aOutputs, unsigned int count)
 }
 
 /**
- * Gets the addresses associated with the given wallet.
+ * Duplicates an address, including its details and activity.
  *
- * @param paAddresses       Pointer to store array of addresses info pointers
- * @param pCount            Pointer to store number of addresses
+ * @param ppNewAddress      Location to store the copy (caller must free)
  * @param pError            A pointer to the location to store the error if there is one
  */
 static
-tABC_CC ABC_TxGetAddresses(tABC_WalletID self,
-                           tABC_TxAddress ***paAddresses,
-                           unsigned int *pCount,
-                           tABC_Error *pError)
+tABC_CC ABC_TxDupAddress(tABC_TxAddress **ppNewAddress,
+                         const tABC_TxAddress *pOldAddress,
+                         tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    tABC_TxAddress *pNewAddress = NULL;
+    const tTxAddressStateInfo *pOldState = pOldAddress->pStateInfo;
+
+    ABC_NEW(pNewAddress, tABC_TxAddress);
+    pNewAddress->seq = pOldAddress->seq;
+    ABC_STRDUP(pNewAddress->szID, pOldAddress->szID);
+    ABC_STRDUP(pNewAddress->szPubAddress, pOldAddress->szPubAddress);
+
+    if (pOldAddress->pDetails)
+    {
+        ABC_CHECK_RET(ABC_TxDupDetails(&pNewAddress->pDetails, pOldAddress->pDetails, pError));
+    }
+
+    if (pOldState)
+    {
+        tTxAddressStateInfo *pNewState = NULL;
+        ABC_NEW(pNewState, tTxAddressStateInfo);
+        pNewAddress->pStateInfo = pNewState;
+        pNewState->timeCreation = pOldState->timeCreation;
+        pNewState->bRecycleable = pOldState->bRecycleable;
+
+        if (pOldState->countActivities > 0)
+        {
+            ABC_ARRAY_NEW(pNewState->aActivities, pOldState->countActivities, tTxAddressActivity);
+            pNewState->countActivities = pOldState->countActivities;
+            for (unsigned i = 0; i < pOldState->countActivities; i++)
+            {
+                ABC_STRDUP(pNewState->aActivities[i].szTxID, pOldState->aActivities[i].szTxID);
+                pNewState->aActivities[i].timeCreation = pOldState->aActivities[i].timeCreation;
+                pNewState->aActivities[i].amountSatoshi = pOldState->aActivities[i].amountSatoshi;
+            }
+        }
+    }
+
+    *ppNewAddress = pNewAddress;
+    pNewAddress = NULL;
+
+exit:
+    ABC_TxFreeAddress(pNewAddress);
+
+    return cc;
+}
+
+/**
+ * Gets the address index for a wallet, building it from the
+ * address directory if this is the first time it is needed.
+ *
+ * @param ppIndex           Location to store the index
+ *                          (owned by the cache, do not free)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+static
+tABC_CC ABC_TxAddressIndexLoad(tABC_WalletID self,
+                               TxAddressIndex **ppIndex,
+                               tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
     AutoFileLock fileLock(gFileMutex); // We are iterating over the filesystem
 
+    tABC_U08Buf MK = ABC_BUF_NULL; // Do not free
     char *szAddrDir = NULL;
     tABC_FileIOList *pFileList = NULL;
     char *szFilename = NULL;
-    tABC_TxAddress **aAddresses = NULL;
-    unsigned int count = 0;
-    bool bExists = false;
+    tABC_TxAddress *pAddress = NULL;
+    TxAddressIndex *pIndex = NULL;
+    std::vector<DecryptJob> jobs;
 
-    *paAddresses = NULL;
-    *pCount = 0;
+    // is the index already loaded?
+    auto row = gTxAddressIndexes.find(self.szUUID);
+    if (row != gTxAddressIndexes.end())
+    {
+        *ppIndex = &row->second;
+        goto exit;
+    }
+
+    pIndex = &gTxAddressIndexes[self.szUUID];
+
+    // get the master key we will need to decode the addresses
+    ABC_CHECK_RET(ABC_WalletGetMK(self, &MK, pError));
 
     // get the directory name
     ABC_CHECK_RET(ABC_WalletGetAddressDirName(&szAddrDir, self.szUUID, pError));
 
-    // if there is a address directory
-    ABC_CHECK_RET(ABC_FileIOFileExists(szAddrDir, &bExists, pError));
+    // get all the stored addresses
+    ABC_CHECK_RET(ABC_TxStoreList(self, szAddrDir, &pFileList, pError));
 
-    if (bExists == true)
+    if (pFileList->nCount > 0)
     {
         ABC_STR_NEW(szFilename, ABC_FILEIO_MAX_PATH_LENGTH + 1);
 
-        // get all the files in the address directory
-        ABC_FileIOCreateFileList(&pFileList, szAddrDir, NULL);
         for (int i = 0; i < pFileList->nCount; i++)
         {
             // if this file is a normal file
@@ -3562,118 +4344,73 @@ tABC_CC ABC_TxGetAddresses(tABC_WalletID self,
                 // create the filename for this address
                 sprintf(szFilename, "%s/%s", szAddrDir, pFileList->apFiles[i]->szName);
 
-                // add this address to the array
-                ABC_CHECK_RET(ABC_TxLoadAddressAndAppendToArray(self, szFilename, &aAddresses, &count, pError));
+                jobs.emplace_back();
+                ABC_CHECK_RET(ABC_TxStoreJob(self, szFilename, MK, jobs.back(), pError));
             }
         }
     }
 
-    // if we have more than one, then let's sort them
-    if (count > 1)
+    // decrypt everything at once, then add it to the index
+    ABC_CHECK_RET(ABC_CryptoDecryptJSONBatch(jobs, pError));
+    for (auto &job: jobs)
     {
-        // sort the transactions by creation date using qsort
-        qsort(aAddresses, count, sizeof(tABC_TxAddress *), ABC_TxAddrPtrCompare);
+        ABC_CHECK_RET(ABC_TxDecodeAddress(job.result, &pAddress, pError));
+        ABC_TxAddressIndexAdd(*pIndex, pAddress);
+        pAddress = NULL;
     }
 
-    // store final results
-    *paAddresses = aAddresses;
-    aAddresses = NULL;
-    *pCount = count;
-    count = 0;
+    *ppIndex = pIndex;
+    pIndex = NULL;
 
 exit:
+    // don't leave a half-built index behind
+    if (pIndex)
+        gTxAddressIndexes.erase(self.szUUID);
     ABC_FREE_STR(szAddrDir);
     ABC_FREE_STR(szFilename);
     ABC_FileIOFreeFileList(pFileList);
-    ABC_TxFreeAddresses(aAddresses, count);
+    ABC_TxFreeAddress(pAddress);
+    for (auto &job: jobs)
+        if (job.result) json_decref(job.result);
 
     return cc;
 }
 
 /**
- * This function is used to support sorting an array of tTxAddress pointers via qsort.
- * qsort has the following documentation for the required function:
- *
- * Pointer to a function that compares two elements.
- * This function is called repeatedly by qsort to compare two elements. It shall follow the following prototype:
- *
- * int compar (const void* p1, const void* p2);
- *
- * Taking two pointers as arguments (both converted to const void*). The function defines the order of the elements by returning (in a stable and transitive manner):
- * return value	meaning
- * <0	The element pointed by p1 goes before the element pointed by p2
- * 0	The element pointed by p1 is equivalent to the element pointed by p2
- * >0	The element pointed by p1 goes after the element pointed by p2
- *
- */
-static
-int ABC_TxAddrPtrCompare(const void * a, const void * b)
-{
-    tABC_TxAddress **ppInfoA = (tABC_TxAddress **)a;
-    tABC_TxAddress *pInfoA = (tABC_TxAddress *)*ppInfoA;
-    tABC_TxAddress **ppInfoB = (tABC_TxAddress **)b;
-    tABC_TxAddress *pInfoB = (tABC_TxAddress *)*ppInfoB;
-
-    if (pInfoA->seq < pInfoB->seq) return -1;
-    if (pInfoA->seq == pInfoB->seq) return 0;
-    if (pInfoA->seq > pInfoB->seq) return 1;
-
-    return 0;
-}
-
-/**
- * Loads the given address and adds it to the end of the array
- *
- * @param szFilename        Filename of address
- * @param paAddress         Pointer to array into which the address will be added
- * @param pCount            Pointer to store number of address (will be updated)
- * @param pError            A pointer to the location to store the error if there is one
+ * Puts an address into the index, replacing any older version
+ * with the same sequence number. The index takes ownership of the address.
  */
 static
-tABC_CC ABC_TxLoadAddressAndAppendToArray(tABC_WalletID self,
-                                          const char *szFilename,
-                                          tABC_TxAddress ***paAddresses,
-                                          unsigned int *pCount,
-                                          tABC_Error *pError)
+void ABC_TxAddressIndexAdd(TxAddressIndex &index, tABC_TxAddress *pAddress)
 {
-    tABC_CC cc = ABC_CC_Ok;
-    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
-
-    tABC_TxAddress *pAddress = NULL;
-    tABC_TxAddress **aAddresses = NULL;
-    unsigned int count = 0;
+    int32_t seq = pAddress->seq;
+    const tTxAddressStateInfo *pState = pAddress->pStateInfo;
+    const tABC_TxDetails *pDetails = pAddress->pDetails;
 
-    // hold on to current values
-    count = *pCount;
-    aAddresses = *paAddresses;
-
-    // load the address
-    ABC_CHECK_RET(ABC_TxLoadAddressFile(self, szFilename, &pAddress, pError));
-
-    // create space for new entry
-    if (aAddresses == NULL)
-    {
-        ABC_ARRAY_NEW(aAddresses, 1, tABC_TxAddress*);
-        count = 1;
-    }
-    else
+    auto old = index.addresses.find(seq);
+    if (old != index.addresses.end())
     {
-        count++;
-        ABC_ARRAY_RESIZE(aAddresses, count, tABC_TxAddress*);
+        index.seqs.erase(old->second->szPubAddress);
+        ABC_TxFreeAddress(old->second);
     }
+    index.recyclable.erase(seq);
+    index.owed.erase(seq);
 
-    // add it to the array
-    aAddresses[count - 1] = pAddress;
-    pAddress = NULL;
-
-    // assign the values to the caller
-    *paAddresses = aAddresses;
-    *pCount = count;
+    index.addresses[seq] = pAddress;
+    index.seqs[pAddress->szPubAddress] = seq;
 
-exit:
-    ABC_TxFreeAddress(pAddress);
+    if (pState->bRecycleable && pState->countActivities == 0)
+        index.recyclable.insert(seq);
 
-    return cc;
+    // a request is open once it goes out, until it has been paid in full
+    if (pDetails && !pState->bRecycleable && pDetails->amountSatoshi >= 0)
+    {
+        tABC_Error error;
+        int64_t owedSatoshi = 0;
+        if (ABC_CC_Ok == ABC_TxGetAddressOwed(pAddress, &owedSatoshi, &error)
+                && owedSatoshi > 0)
+            index.owed[seq] = owedSatoshi;
+    }
 }
 
 #if 0
@@ -3795,6 +4532,13 @@ exit:
     return cc;
 }
 
+/**
+ * Looks up a transaction in the wallet's index.
+ *
+ * @param pTx   Location to store an allocated copy of the transaction,
+ *              or NULL if it doesn't exist (caller must free)
+ */
+static
 tABC_CC ABC_TxTransactionExists(tABC_WalletID self,
                                 const char *szID,
                                 tABC_Tx **pTx,
@@ -3802,131 +4546,36 @@ tABC_CC ABC_TxTransactionExists(tABC_WalletID self,
 {
     tABC_CC cc = ABC_CC_Ok;
     AutoCoreLock lock(gCoreMutex);
-    char *szFilename = NULL;
-    bool bExists = false;
-
-    // first try the internal
-    ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, true, pError));
-    ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-
-    // if the internal doesn't exist
-    if (bExists == false)
-    {
-        // try the external
-        ABC_FREE_STR(szFilename);
-        ABC_CHECK_RET(ABC_TxCreateTxFilename(self, &szFilename, szID, false, pError));
-        ABC_CHECK_RET(ABC_FileIOFileExists(szFilename, &bExists, pError));
-    }
-    if (bExists)
-    {
-        ABC_CHECK_RET(ABC_TxLoadTransaction(self, szFilename, pTx, pError));
-    } else {
-        *pTx = NULL;
-    }
-exit:
-    ABC_FREE_STR(szFilename);
 
-    return cc;
-}
+    TxIndex *pIndex = NULL;
+    tABC_Tx *pNewTx = NULL;
 
-/**
- * This implemens the KMP failure function. Its the preprocessing before we can
- * search for substrings.
- *
- * @param needle - The string to preprocess
- * @param table - An array of integers the string length of needle
- *
- * Returns 1 if a match is found otherwise returns 0
- *
- */
-static
-void ABC_TxStrTable(const char *needle, int *table)
-{
-    size_t pos = 2, cnd = 0;
-    table[0] = -1;
-    table[1] = 0;
-    size_t needle_size = strlen(needle);
+    *pTx = NULL;
 
-    while (pos < needle_size)
+    ABC_CHECK_RET(ABC_TxIndexLoad(self, &pIndex, pError));
     {
-        if (tolower(needle[pos - 1]) == tolower(needle[cnd]))
-        {
-            cnd = cnd + 1;
-            table[pos] = cnd;
-            pos = pos + 1;
-        }
-        else if (cnd > 0)
-            cnd = table[cnd];
-        else
+        auto i = pIndex->txs.find(szID);
+        if (i != pIndex->txs.end())
         {
-            table[pos] = 0;
-            pos = pos + 1;
+            ABC_CHECK_RET(ABC_TxDupTx(&pNewTx, i->second, pError));
+
+            // get advanced details
+            ABC_CHECK_RET(
+                ABC_BridgeTxDetails(self.szUUID, pNewTx->pStateInfo->szMalleableTxId,
+                                    &(pNewTx->aOutputs), &(pNewTx->countOutputs),
+                                    &(pNewTx->pDetails->amountSatoshi),
+                                    &(pNewTx->pDetails->amountFeesMinersSatoshi),
+                                    pError));
+
+            *pTx = pNewTx;
+            pNewTx = NULL;
         }
     }
-}
-
-/**
- * This function implemens the KMP string searching algo. This function is
- * used for string matching when searching transactions.
- *
- * @param haystack - The string to search
- * @param needle - The string to find in the haystack
- *
- * Returns 1 if a match is found otherwise returns 0
- *
- */
-static
-int ABC_TxStrStr(const char *haystack, const char *needle,
-                 tABC_Error *pError)
-{
-    tABC_CC cc = ABC_CC_Ok;
-    if (haystack == NULL || needle == NULL) {
-        return 0;
-    }
-    int result = -1;
-    size_t haystack_size;
-    size_t needle_size;
-    size_t m = 0, i = 0;
-    int *table;
-
-    haystack_size = strlen(haystack);
-    needle_size = strlen(needle);
-
-    if (haystack_size == 0 || needle_size == 0) {
-        return 0;
-    }
-
-    ABC_ARRAY_NEW(table, needle_size, int);
-    ABC_TxStrTable(needle, table);
 
-    while (m + i < haystack_size)
-    {
-        if (tolower(needle[i]) == tolower(haystack[m + i]))
-        {
-            if (i == needle_size - 1)
-            {
-                result = m;
-                break;
-            }
-            i = i + 1;
-        }
-        else
-        {
-            if (table[i] > -1)
-            {
-                i = table[i];
-                m = m + i - table[i];
-            }
-            else
-            {
-                i = 0;
-                m = m + 1;
-            }
-        }
-    }
 exit:
-    ABC_FREE(table);
-    return result > -1 ? 1 : 0;
+    ABC_TxFreeTx(pNewTx);
+
+    return cc;
 }
 
 static int
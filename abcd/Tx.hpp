@@ -67,6 +67,23 @@ typedef struct sABC_TxSendInfo
     tABC_Error  errorInfo;
 } tABC_TxSendInfo;
 
+/**
+ * A transaction the watcher has found, as passed to ABC_TxReceiveTransactions.
+ * The caller owns all the pointers.
+ */
+typedef struct sABC_TxIncoming
+{
+    char                    *szTxId;
+    char                    *szMalTxId;
+    int64_t                 amountSatoshi;
+    int64_t                 feeSatoshi;
+
+    tABC_TxOutput           **aInputs;
+    unsigned int            inputCount;
+    tABC_TxOutput           **aOutputs;
+    unsigned int            outputCount;
+} tABC_TxIncoming;
+
 
 tABC_CC ABC_TxDupDetails(tABC_TxDetails **ppNewDetails,
                          const tABC_TxDetails *pOldDetails,
@@ -89,19 +106,18 @@ double ABC_TxSatoshiToBitcoin(int64_t satoshi);
 
 int64_t ABC_TxBitcoinToSatoshi(double bitcoin);
 
-tABC_CC ABC_TxBlockHeightUpdate(uint64_t height,
+tABC_CC ABC_TxBlockHeightUpdate(tABC_WalletID self,
+                                uint64_t height,
                                 tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
                                 void *pData,
                                 tABC_Error *pError);
 
-tABC_CC ABC_TxReceiveTransaction(tABC_WalletID self,
-                                 uint64_t amountSatoshi, uint64_t feeSatoshi,
-                                 tABC_TxOutput **paInAddress, unsigned int inAddressCount,
-                                 tABC_TxOutput **paOutAddresses, unsigned int outAddressCount,
-                                 const char *szTxId, const char *szMalTxId,
-                                 tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
-                                 void *pData,
-                                 tABC_Error *pError);
+tABC_CC ABC_TxReceiveTransactions(tABC_WalletID self,
+                                  const tABC_TxIncoming *aTxs,
+                                  unsigned int count,
+                                  tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
+                                  void *pData,
+                                  tABC_Error *pError);
 
 tABC_CC ABC_TxCreateInitialAddresses(tABC_WalletID self,
                                      tABC_Error *pError);
@@ -144,6 +160,17 @@ tABC_CC ABC_TxGetTransactions(tABC_WalletID self,
                               unsigned int *pCount,
                               tABC_Error *pError);
 
+tABC_CC ABC_TxGetTransactionsPage(tABC_WalletID self,
+                                  int64_t startTime,
+                                  int64_t endTime,
+                                  const char *szCursor,
+                                  unsigned int limit,
+                                  bool bNewestFirst,
+                                  tABC_TxInfo ***paTransactions,
+                                  unsigned int *pCount,
+                                  char **pszNextCursor,
+                                  tABC_Error *pError);
+
 tABC_CC ABC_TxSearchTransactions(tABC_WalletID self,
                                  const char *szQuery,
                                  tABC_TxInfo ***paTransactions,
@@ -152,6 +179,17 @@ tABC_CC ABC_TxSearchTransactions(tABC_WalletID self,
 
 void ABC_TxFreeTransaction(tABC_TxInfo *pTransactions);
 
+tABC_CC ABC_TxGetBalance(tABC_WalletID self,
+                         int64_t *pBalance,
+                         tABC_Error *pError);
+
+void ABC_TxClearCache();
+
+void ABC_TxSealLog(tABC_WalletID self);
+
+tABC_CC ABC_TxMigrateToLog(tABC_WalletID self,
+                           tABC_Error *pError);
+
 void ABC_TxFreeTransactions(tABC_TxInfo **aTransactions,
                             unsigned int count);
 
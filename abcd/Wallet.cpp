@@ -58,6 +58,7 @@ namespace abcd {
 #define WALLET_SYNC_DIR                         "sync"
 #define WALLET_TX_DIR                           "Transactions"
 #define WALLET_ADDR_DIR                         "Addresses"
+#define WALLET_LOG_DIR                          "Log"
 #define WALLET_ACCOUNTS_WALLETS_FILENAME        "Wallets.json"
 #define WALLET_NAME_FILENAME                    "WalletName.json"
 #define WALLET_CURRENCY_FILENAME                "Currency.json"
@@ -82,8 +83,6 @@ typedef struct sWalletData
     tABC_U08Buf     MK;
     tABC_U08Buf     BitcoinPrivateSeed;
     unsigned        archived;
-    bool            balanceDirty;
-    int64_t         balance;
 } tWalletData;
 
 // this holds all the of the currently cached wallets
@@ -307,7 +306,8 @@ tABC_CC ABC_WalletSyncData(tABC_WalletID self, int *pDirty, tABC_Error *pError)
     ABC_CHECK_RET(ABC_WalletCacheData(self, &pData, pError));
     ABC_CHECK_ASSERT(NULL != pData->szWalletAcctKey, ABC_CC_Error, "Expected to find RepoAcctKey in key cache");
 
-    // Sync
+    // Sync, keeping later log writes out of the files being committed
+    ABC_TxSealLog(self);
     ABC_CHECK_RET(ABC_SyncRepo(pData->szWalletSyncDir, pData->szWalletAcctKey, pDirty, pError));
     if (*pDirty || bNew)
     {
@@ -580,6 +580,32 @@ exit:
     return cc;
 }
 
+/**
+ * Gets the transaction log directory for the given wallet UUID.
+ *
+ * @param pszDir the output directory name. The caller must free this.
+ */
+tABC_CC ABC_WalletGetLogDirName(char **pszDir, const char *szWalletUUID, tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    char *szWalletSyncDir = NULL;
+
+    ABC_CHECK_NULL(pszDir);
+    ABC_CHECK_NULL(szWalletUUID);
+
+    ABC_CHECK_RET(ABC_WalletGetSyncDirName(&szWalletSyncDir, szWalletUUID, pError));
+
+    ABC_STR_NEW(*pszDir, ABC_FILEIO_MAX_PATH_LENGTH);
+    ABC_CHECK_NULL(*pszDir);
+    sprintf(*pszDir, "%s/%s", szWalletSyncDir, WALLET_LOG_DIR);
+
+exit:
+    ABC_FREE_STR(szWalletSyncDir);
+
+    return cc;
+}
+
 /**
  * Adds the wallet data to the cache
  * If the wallet is not currently in the cache it is added
@@ -692,8 +718,6 @@ tABC_CC ABC_WalletCacheData(tABC_WalletID self, tWalletData **ppData, tABC_Error
             }
 
         }
-        pData->balance = 0;
-        pData->balanceDirty = true;
 
         // Add to cache
         ABC_CHECK_RET(ABC_WalletAddToCache(pData, pError));
@@ -734,6 +758,8 @@ void ABC_WalletClearCache()
         ABC_FREE(gaWalletsCacheArray);
         gWalletsCacheCount = 0;
     }
+
+    ABC_TxClearCache();
 }
 
 /**
@@ -881,20 +907,6 @@ void ABC_WalletFreeData(tWalletData *pData)
     }
 }
 
-tABC_CC ABC_WalletDirtyCache(tABC_WalletID self,
-                             tABC_Error *pError)
-{
-    tABC_CC cc = ABC_CC_Ok;
-    AutoCoreLock lock(gCoreMutex);
-
-    tWalletData     *pData = NULL;
-
-    ABC_CHECK_RET(ABC_WalletCacheData(self, &pData, pError));
-    pData->balanceDirty = true;
-exit:
-    return cc;
-}
-
 /**
  * Gets information on the given wallet.
  *
@@ -913,8 +925,6 @@ tABC_CC ABC_WalletGetInfo(tABC_WalletID self,
 
     tWalletData     *pData = NULL;
     tABC_WalletInfo *pInfo = NULL;
-    tABC_TxInfo     **aTransactions = NULL;
-    unsigned int    nTxCount = 0;
 
     // load the wallet data into the cache
     ABC_CHECK_RET(ABC_WalletCacheData(self, &pData, pError));
@@ -931,22 +941,7 @@ tABC_CC ABC_WalletGetInfo(tABC_WalletID self,
     pInfo->currencyNum = pData->currencyNum;
     pInfo->archived  = pData->archived;
 
-    if (pData->balanceDirty == true)
-    {
-        ABC_CHECK_RET(
-            ABC_TxGetTransactions(self,
-                                  ABC_GET_TX_ALL_TIMES, ABC_GET_TX_ALL_TIMES,
-                                  &aTransactions, &nTxCount, pError));
-        ABC_CHECK_RET(ABC_BridgeFilterTransactions(self.szUUID, aTransactions, &nTxCount, pError));
-        pData->balance = 0;
-        for (unsigned i = 0; i < nTxCount; i++)
-        {
-            tABC_TxInfo *pTxInfo = aTransactions[i];
-            pData->balance += pTxInfo->pDetails->amountSatoshi;
-        }
-        pData->balanceDirty = false;
-    }
-    pInfo->balanceSatoshi = pData->balance;
+    ABC_CHECK_RET(ABC_TxGetBalance(self, &pInfo->balanceSatoshi, pError));
 
 
     // assign it to the user's pointer
@@ -955,7 +950,6 @@ tABC_CC ABC_WalletGetInfo(tABC_WalletID self,
 
 exit:
     ABC_CLEAR_FREE(pInfo, sizeof(tABC_WalletInfo));
-    if (nTxCount > 0) ABC_FreeTransactions(aTransactions, nTxCount);
 
     return cc;
 }
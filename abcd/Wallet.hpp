@@ -69,9 +69,6 @@ tABC_CC ABC_WalletSetName(tABC_WalletID self,
                           const char *szName,
                           tABC_Error *pError);
 
-tABC_CC ABC_WalletDirtyCache(tABC_WalletID self,
-                             tABC_Error *pError);
-
 tABC_CC ABC_WalletGetInfo(tABC_WalletID self,
                           tABC_WalletInfo **ppWalletInfo,
                           tABC_Error *pError);
@@ -102,6 +99,10 @@ tABC_CC ABC_WalletGetAddressDirName(char **pszDir,
                                     const char *szWalletUUID,
                                     tABC_Error *pError);
 
+tABC_CC ABC_WalletGetLogDirName(char **pszDir,
+                                const char *szWalletUUID,
+                                tABC_Error *pError);
+
 // Blocking functions:
 tABC_CC ABC_WalletCreate(const Login &login,
                          tABC_U08Buf L1,
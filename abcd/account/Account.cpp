@@ -29,6 +29,7 @@ static void ABC_AccountWalletInfoFreeArray(tABC_AccountWalletInfo *aInfo, unsign
 static tABC_CC ABC_AccountWalletGetDir(const Login &login, char **pszWalletDir, tABC_Error *pError);
 static int ABC_AccountWalletCompare(const void *a, const void *b);
 static tABC_CC ABC_AccountWalletsLoad(const Login &login, tABC_AccountWalletInfo **paInfo, unsigned *pCount, tABC_Error *pError);
+static tABC_CC ABC_AccountWalletDecode(json_t *pJSON, const char *szUUID, tABC_AccountWalletInfo *pInfo, tABC_Error *pError);
 
 /**
  * Releases the members of a tABC_AccountWalletInfo structure. Unlike most
@@ -154,7 +155,8 @@ tABC_CC ABC_AccountWalletsLoad(const Login &login,
     unsigned entries = 0;
     unsigned count = 0;
     tABC_AccountWalletInfo *aInfo = NULL;
-    char *szUUID = NULL;
+    std::vector<std::string> uuids;
+    std::vector<DecryptJob> jobs;
 
     // List the wallet directory:
     ABC_CHECK_RET(ABC_AccountWalletGetDir(login, &szWalletDir, pError));
@@ -169,22 +171,27 @@ tABC_CC ABC_AccountWalletsLoad(const Login &login,
         }
     }
 
-    // Load the wallets into the array:
-    ABC_ARRAY_NEW(aInfo, entries, tABC_AccountWalletInfo);
+    // Decrypt the wallets all at once:
     for (int i = 0; i < pFileList->nCount; ++i)
     {
         size_t len = strlen(pFileList->apFiles[i]->szName);
         if (5 <= len &&
             !strcmp(pFileList->apFiles[i]->szName + len - 5, ".json"))
         {
-            char *szUUID = strndup(pFileList->apFiles[i]->szName, len - 5);
-            ABC_CHECK_NULL(szUUID);
-
-            ABC_CHECK_RET(ABC_AccountWalletLoad(login, szUUID, aInfo + count, pError));
-            ABC_FREE_STR(szUUID);
-            ++count;
+            uuids.emplace_back(pFileList->apFiles[i]->szName, len - 5);
+            jobs.push_back(DecryptJob{std::string(szWalletDir) + "/" +
+                pFileList->apFiles[i]->szName, "", toU08Buf(login.dataKey()), NULL});
         }
     }
+    ABC_CHECK_RET(ABC_CryptoDecryptJSONBatch(jobs, pError));
+
+    // Load the wallets into the array:
+    ABC_ARRAY_NEW(aInfo, entries, tABC_AccountWalletInfo);
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        ABC_CHECK_RET(ABC_AccountWalletDecode(jobs[i].result, uuids[i].c_str(), aInfo + count, pError));
+        ++count;
+    }
 
     // Sort the array:
     qsort(aInfo, count, sizeof(tABC_AccountWalletInfo),
@@ -199,7 +206,8 @@ exit:
     ABC_FREE_STR(szWalletDir);
     ABC_FileIOFreeFileList(pFileList);
     ABC_AccountWalletInfoFreeArray(aInfo, count);
-    ABC_FREE_STR(szUUID);
+    for (auto &job: jobs)
+        if (job.result) json_decref(job.result);
 
     return cc;
 }
@@ -218,18 +226,37 @@ tABC_CC ABC_AccountWalletLoad(const Login &login,
                               tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    int e;
 
     json_t *pJSON = NULL;
-    const char *szSyncKey = NULL;
-    const char *szMK = NULL;
-    const char *szBPS = NULL;
-    DataChunk syncKey, dataKey, bitcoinKey;
     auto filename = login.syncDir() + "/Wallets/" + szUUID + ".json";
 
     // Load and decrypt:
     ABC_CHECK_RET(ABC_CryptoDecryptJSONFileObject(filename.c_str(),
         toU08Buf(login.dataKey()), &pJSON, pError));
+    ABC_CHECK_RET(ABC_AccountWalletDecode(pJSON, szUUID, pInfo, pError));
+
+exit:
+    if (pJSON) json_decref(pJSON);
+
+    return cc;
+}
+
+/**
+ * Fills in a wallet info structure from its decrypted info file.
+ */
+static
+tABC_CC ABC_AccountWalletDecode(json_t *pJSON,
+                                const char *szUUID,
+                                tABC_AccountWalletInfo *pInfo,
+                                tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    int e;
+
+    const char *szSyncKey = NULL;
+    const char *szMK = NULL;
+    const char *szBPS = NULL;
+    DataChunk syncKey, dataKey, bitcoinKey;
 
     // Wallet name:
     ABC_STRDUP(pInfo->szUUID, szUUID);
@@ -258,7 +285,6 @@ tABC_CC ABC_AccountWalletLoad(const Login &login,
 
 exit:
     ABC_AccountWalletInfoFree(pInfo);
-    if (pJSON) json_decref(pJSON);
 
     return cc;
 }
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "CoinSelect.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace abcd {
+
+constexpr size_t txOverhead = 10;
+constexpr size_t inputSize = 148;
+constexpr size_t outputSize = 34;
+
+// Gives up on finding a change-free solution after this many steps:
+constexpr unsigned maxTries = 100000;
+
+size_t
+coinSelectSize(size_t inputs, size_t outputs)
+{
+    return txOverhead + inputs * inputSize + outputs * outputSize;
+}
+
+/**
+ * Fills in the fee and change for a set of inputs.
+ * Leftovers smaller than a change output's cost plus dust go to the miners.
+ * @return false if the inputs don't cover the target and fees.
+ */
+static bool
+selectionFinish(CoinSelection &result, const std::vector<size_t> &inputs,
+                uint64_t total, uint64_t target, size_t outputs,
+                const FeeModel &fees, uint64_t dust)
+{
+    uint64_t fee = fees(coinSelectSize(inputs.size(), outputs));
+    if (total < target || total - target < fee)
+        return false;
+
+    uint64_t changeFee = fees(coinSelectSize(inputs.size(), outputs + 1));
+    result.inputs = inputs;
+    if (changeFee + dust <= total - target)
+    {
+        result.fee = changeFee;
+        result.change = total - target - changeFee;
+    }
+    else
+    {
+        result.fee = total - target;
+        result.change = 0;
+    }
+    return true;
+}
+
+/**
+ * Searches for a set of inputs that needs no change output,
+ * preferring the one that leaves the least for the miners.
+ * The search works on values with an estimated per-input fee taken off,
+ * but each candidate gets checked against the exact fee.
+ * @param order candidate positions, largest value first.
+ */
+static bool
+selectionSearch(CoinSelection &result, const std::vector<uint64_t> &values,
+                const std::vector<size_t> &order, uint64_t target,
+                size_t outputs, const FeeModel &fees, uint64_t dust)
+{
+    const uint64_t baseFee = fees(coinSelectSize(0, outputs));
+    const uint64_t inputFee = fees(coinSelectSize(1, outputs)) - baseFee;
+    const uint64_t changeCost = fees(coinSelectSize(1, outputs + 1)) -
+        fees(coinSelectSize(1, outputs)) + dust;
+    const uint64_t goal = target + baseFee;
+
+    // Outputs worth less than their own fee never help:
+    std::vector<size_t> pool;
+    std::vector<uint64_t> effective;
+    uint64_t available = 0;
+    for (auto i: order)
+    {
+        if (values[i] <= inputFee)
+            continue;
+        pool.push_back(i);
+        effective.push_back(values[i] - inputFee);
+        available += values[i] - inputFee;
+    }
+    if (available < goal)
+        return false;
+
+    std::vector<size_t> chosen;     // Positions in the pool
+    uint64_t current = 0;           // Effective value of chosen
+    uint64_t currentTotal = 0;      // Real value of chosen
+    uint64_t bestLeftover = std::numeric_limits<uint64_t>::max();
+    bool found = false;
+
+    size_t next = 0;
+    for (unsigned tries = 0; tries < maxTries; ++tries, ++next)
+    {
+        bool back = false;
+        if (current + available < goal || goal + changeCost < current)
+        {
+            back = true;
+        }
+        else if (goal <= current)
+        {
+            // Adding more would only overshoot, so check this one and turn back:
+            CoinSelection candidate;
+            std::vector<size_t> inputs;
+            for (auto j: chosen)
+                inputs.push_back(pool[j]);
+            if (selectionFinish(candidate, inputs, currentTotal, target,
+                    outputs, fees, dust) && !candidate.change)
+            {
+                uint64_t leftover = currentTotal - target -
+                    fees(coinSelectSize(inputs.size(), outputs));
+                if (leftover < bestLeftover)
+                {
+                    bestLeftover = leftover;
+                    result = candidate;
+                    found = true;
+                    if (!leftover)
+                        break;
+                }
+            }
+            back = true;
+        }
+
+        if (back)
+        {
+            if (chosen.empty())
+                break;
+
+            // Skipped candidates become available again:
+            for (--next; chosen.back() < next; --next)
+                available += effective[next];
+
+            // Try leaving out the last candidate we put in:
+            current -= effective[next];
+            currentTotal -= values[pool[next]];
+            chosen.pop_back();
+        }
+        else
+        {
+            available -= effective[next];
+            current += effective[next];
+            currentTotal += values[pool[next]];
+            chosen.push_back(next);
+        }
+    }
+
+    return found;
+}
+
+bool
+coinSelect(CoinSelection &result, const std::vector<uint64_t> &values,
+           uint64_t target, size_t outputs, FeeModel fees, uint64_t dust)
+{
+    std::vector<size_t> order;
+    for (size_t i = 0; i < values.size(); ++i)
+        if (values[i])
+            order.push_back(i);
+    std::sort(order.begin(), order.end(),
+        [&values](size_t a, size_t b) { return values[b] < values[a]; });
+
+    // Best of all, no change:
+    if (selectionSearch(result, values, order, target, outputs, fees, dust))
+        return true;
+
+    // Next best, a single input with change:
+    const uint64_t singleFee = fees(coinSelectSize(1, outputs + 1));
+    for (auto i = order.rbegin(); i != order.rend(); ++i)
+    {
+        if (values[*i] < target || values[*i] - target < singleFee + dust)
+            continue;
+        if (selectionFinish(result, {*i}, values[*i], target, outputs, fees, dust))
+            return true;
+    }
+
+    // Otherwise, take the biggest outputs until there is enough:
+    std::vector<size_t> inputs;
+    uint64_t sum = 0;
+    for (auto i: order)
+    {
+        inputs.push_back(i);
+        sum += values[i];
+        if (selectionFinish(result, inputs, sum, target, outputs, fees, dust))
+            return true;
+    }
+
+    result.inputs.clear();
+    result.fee = fees(coinSelectSize(order.size(), outputs));
+    result.change = 0;
+    return false;
+}
+
+} // namespace abcd
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Picks which unspent outputs pay for a transaction.
+ */
+
+#ifndef ABCD_BITCOIN_COIN_SELECT_HPP
+#define ABCD_BITCOIN_COIN_SELECT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+namespace abcd {
+
+/**
+ * Returns the miner fee for a transaction of the given size in bytes.
+ * The fee must never go down as the size goes up.
+ */
+typedef std::function<uint64_t (size_t size)> FeeModel;
+
+/**
+ * Estimates the size of a transaction with pay-to-pubkey-hash
+ * inputs and outputs.
+ */
+size_t
+coinSelectSize(size_t inputs, size_t outputs);
+
+struct CoinSelection
+{
+    std::vector<size_t> inputs; // Positions in the list of candidates
+    uint64_t fee;               // Miner fee, including any leftovers
+    uint64_t change;            // Zero if there is no change output
+};
+
+/**
+ * Picks the outputs to spend for a payment, working out the exact fee
+ * for the resulting transaction along the way.
+ *
+ * A branch-and-bound search looks for a set of outputs that covers the
+ * payment and fees, with leftovers too small to be worth a change
+ * output. If there is no such set, the smallest single output that
+ * covers everything plus change wins, and failing that, the largest
+ * outputs get used first. Change smaller than `dust` is never created;
+ * it goes to the miners instead.
+ *
+ * @param values the candidate outputs' values.
+ * @param target the total of the transaction's outputs, not counting change.
+ * @param outputs the number of outputs, not counting change.
+ * @return false if the candidates can't cover the target and fees.
+ * The fee is then the fee for spending every candidate.
+ */
+bool
+coinSelect(CoinSelection &result, const std::vector<uint64_t> &values,
+           uint64_t target, size_t outputs, FeeModel fees, uint64_t dust);
+
+} // namespace abcd
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "HdChain.hpp"
+#include "../util/SecureData.hpp"
+#include "../util/Util.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+
+namespace abcd {
+
+// Starting a thread costs about as much as a few derivations:
+constexpr uint32_t minPerThread = 16;
+
+// Search threads claim this many indices at a time:
+constexpr uint64_t searchChunk = 1024;
+constexpr std::chrono::seconds progressInterval(1);
+
+/**
+ * Overwrites the secret parts of an extended key.
+ */
+static void
+wipe(libwallet::hd_private_key &key)
+{
+    auto &secret = key.private_key();
+    ABC_UtilGuaranteedMemset(const_cast<uint8_t *>(secret.data()), 0, secret.size());
+    auto &chain = key.chain_code();
+    ABC_UtilGuaranteedMemset(const_cast<uint8_t *>(chain.data()), 0, chain.size());
+}
+
+HdChain::~HdChain()
+{
+    // secureFree wipes the whole block, secret and all:
+    key_->~hd_private_key();
+    secureFree(key_, sizeof(*key_));
+}
+
+HdChain::HdChain(DataSlice seed)
+{
+    void *memory = secureAlloc(sizeof(libwallet::hd_private_key));
+    if (!memory)
+        throw std::bad_alloc();
+
+    bc::data_chunk data(seed.begin(), seed.end());
+    libwallet::hd_private_key m(data);
+    libwallet::hd_private_key m0 = m.generate_private_key(0);
+    libwallet::hd_private_key m00 = m0.generate_private_key(0);
+    key_ = new(memory) libwallet::hd_private_key(m00);
+
+    wipe(m);
+    wipe(m0);
+    wipe(m00);
+    ABC_UtilGuaranteedMemset(data.data(), 0, data.size());
+}
+
+bool
+HdChain::pubAddress(std::string &result, uint32_t n) const
+{
+    libwallet::hd_private_key key = key_->generate_private_key(n);
+    bool valid = key.valid();
+    if (valid)
+        result = key.address().encoded();
+    wipe(key);
+    return valid;
+}
+
+bool
+HdChain::privateKey(std::string &result, uint32_t n) const
+{
+    libwallet::hd_private_key key = key_->generate_private_key(n);
+    bool valid = key.valid();
+    if (valid)
+        result = bc::encode_hex(key.private_key());
+    wipe(key);
+    return valid;
+}
+
+std::vector<std::string>
+HdChain::pubAddresses(uint32_t first, uint32_t count) const
+{
+    std::vector<std::string> out(count);
+    auto work = [this, first, &out](uint32_t start, uint32_t end)
+    {
+        for (uint32_t i = start; i < end; ++i)
+            if (!pubAddress(out[i], first + i))
+                out[i].clear();
+    };
+
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, (count + minPerThread - 1) / minPerThread);
+    uint32_t step = threads ? (count + threads - 1) / threads : count;
+
+    // The calling thread takes the first slice:
+    std::vector<std::thread> pool;
+    for (uint32_t start = step; start < count; start += step)
+    {
+        uint32_t end = std::min(count, start + step);
+        try
+        {
+            pool.emplace_back(work, start, end);
+        }
+        catch (const std::system_error &)
+        {
+            work(start, end);
+        }
+    }
+    work(0, std::min(count, step));
+
+    for (auto &thread: pool)
+        thread.join();
+    return out;
+}
+
+std::map<uint32_t, bc::short_hash>
+HdChain::search(const ShortHashSet &targets, uint32_t first, uint32_t last,
+                const SearchProgress &progress) const
+{
+    std::map<uint32_t, bc::short_hash> out;
+    if (last < first || targets.empty())
+        return out;
+    const uint64_t total = uint64_t(last) - first + 1;
+
+    // Shared state:
+    std::mutex mutex;
+    std::condition_variable finished;
+    unsigned running = 0;       // Protected by mutex
+    ShortHashSet found;         // Protected by mutex
+    std::atomic<uint64_t> next(0);
+    std::atomic<uint64_t> checked(0);
+    std::atomic<bool> done(false);
+
+    // Each thread keeps claiming chunks until the range runs out:
+    auto work = [&]()
+    {
+        while (!done)
+        {
+            uint64_t start = next.fetch_add(searchChunk);
+            if (total <= start)
+                break;
+            uint64_t end = std::min(total, start + searchChunk);
+
+            for (uint64_t i = start; i < end; ++i)
+            {
+                uint32_t n = first + i;
+                libwallet::hd_private_key key = key_->generate_private_key(n);
+                if (key.valid())
+                {
+                    bc::short_hash hash = key.address().hash();
+                    if (targets.count(hash))
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        out[n] = hash;
+                        found.insert(hash);
+                        if (found.size() == targets.size())
+                            done = true;
+                    }
+                }
+                wipe(key);
+            }
+            checked += end - start;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        try
+        {
+            pool.emplace_back([&]()
+            {
+                work();
+                std::lock_guard<std::mutex> lock(mutex);
+                --running;
+                finished.notify_all();
+            });
+            ++running;
+        }
+        catch (const std::system_error &)
+        {
+            break;
+        }
+    }
+
+    if (pool.empty())
+    {
+        work();
+    }
+    else
+    {
+        // Report progress while the threads do their thing:
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running)
+        {
+            if (!finished.wait_for(lock, progressInterval,
+                    [&]() { return !running; }) && progress)
+            {
+                lock.unlock();
+                progress(checked);
+                lock.lock();
+            }
+        }
+    }
+
+    for (auto &thread: pool)
+        thread.join();
+    if (progress)
+        progress(checked);
+    return out;
+}
+
+} // namespace abcd
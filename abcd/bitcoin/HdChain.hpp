@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Cached key derivation for the wallet's address chain.
+ */
+
+#ifndef ABCD_BITCOIN_HD_CHAIN_HPP
+#define ABCD_BITCOIN_HD_CHAIN_HPP
+
+#include "../util/Data.hpp"
+#include <wallet/wallet.hpp>
+#include <string.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace abcd {
+
+/**
+ * Hashes a hash160 for use in unordered containers.
+ * The input is already uniformly distributed, so a prefix will do.
+ */
+struct ShortHashHasher
+{
+    size_t
+    operator()(const bc::short_hash &hash) const
+    {
+        size_t out;
+        memcpy(&out, hash.data(), sizeof(out));
+        return out;
+    }
+};
+
+typedef std::unordered_set<bc::short_hash, ShortHashHasher> ShortHashSet;
+
+/**
+ * The wallet's main external chain, m/0/0.
+ *
+ * Finding an address from the seed means walking the whole path,
+ * m -> m/0 -> m/0/0 -> m/0/0/n, with an elliptic-curve multiplication
+ * at each step. This walks the first part once and keeps the m/0/0
+ * extended key around, so each address only costs the final step.
+ * That key lives in locked memory, and is wiped when the object goes away.
+ */
+class HdChain
+{
+public:
+    ~HdChain();
+    HdChain(DataSlice seed);
+
+    HdChain(const HdChain &copy) = delete;
+    HdChain &operator=(const HdChain &copy) = delete;
+
+    /**
+     * Finds the public address for m/0/0/n.
+     * @return false if n happens to be an invalid index,
+     * in which case the caller should move on to the next one.
+     */
+    bool
+    pubAddress(std::string &result, uint32_t n) const;
+
+    /**
+     * Finds the hex-encoded private key for m/0/0/n.
+     * @return false if n happens to be an invalid index.
+     */
+    bool
+    privateKey(std::string &result, uint32_t n) const;
+
+    /**
+     * Finds the public addresses for the indices [first, first + count),
+     * spreading the work across the available cores.
+     * Invalid indices come back as empty strings.
+     */
+    std::vector<std::string>
+    pubAddresses(uint32_t first, uint32_t count) const;
+
+    /**
+     * Receives the number of indices checked so far.
+     */
+    typedef std::function<void (uint64_t checked)> SearchProgress;
+
+    /**
+     * Looks for addresses among the indices [first, last],
+     * spreading the work across the available cores.
+     * Stops early once every target has turned up.
+     * @param targets the hash160s of the addresses to look for.
+     * @param progress called on the calling thread about once a second,
+     * and once more at the end.
+     * @return the hash160s found, by index.
+     */
+    std::map<uint32_t, bc::short_hash>
+    search(const ShortHashSet &targets, uint32_t first, uint32_t last,
+           const SearchProgress &progress=SearchProgress()) const;
+
+private:
+    libwallet::hd_private_key *key_; // From secureAlloc
+};
+
+} // namespace abcd
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "Spendable.hpp"
+
+namespace abcd {
+
+uint64_t
+spendableSearch(uint64_t estimate, SpendTest test)
+{
+    if (!estimate || test(estimate))
+        return estimate;
+
+    // Zero always "passes", since it is the answer when nothing else does:
+    uint64_t pass = 0;
+    uint64_t fail = estimate;
+    while (1 < fail - pass)
+    {
+        uint64_t middle = pass + (fail - pass) / 2;
+        if (test(middle))
+            pass = middle;
+        else
+            fail = middle;
+    }
+    return pass;
+}
+
+} // namespace abcd
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Helpers for working out how much a wallet can send.
+ */
+
+#ifndef ABCD_BITCOIN_SPENDABLE_HPP
+#define ABCD_BITCOIN_SPENDABLE_HPP
+
+#include <stdint.h>
+#include <functional>
+
+namespace abcd {
+
+/**
+ * Returns true if a transaction sending the given amount can be built.
+ */
+typedef std::function<bool (uint64_t amount)> SpendTest;
+
+/**
+ * Finds the largest amount, no larger than the estimate, that passes
+ * the test. This gives the same answer as stepping down one satoshi
+ * at a time, as long as every amount below a passing amount also
+ * passes, but only needs a logarithmic number of tests.
+ * @return 0 if nothing passes.
+ */
+uint64_t
+spendableSearch(uint64_t estimate, SpendTest test);
+
+} // namespace abcd
+
+#endif
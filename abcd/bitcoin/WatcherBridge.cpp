@@ -31,13 +31,24 @@
 
 #include "WatcherBridge.hpp"
 #include "Broadcast.hpp"
+#include "CoinSelect.hpp"
+#include "Spendable.hpp"
+#include "WatcherCache.hpp"
 #include "picker.hpp"
 #include "Testnet.hpp"
 #include "../General.hpp"
+#include "../util/FileIO.hpp"
+#include "../util/RecordLog.hpp"
 #include "../util/Util.hpp"
 #include <bitcoin/watcher.hpp> // Includes the rest of the stack
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <list>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <thread>
 #include <unordered_map>
 
 namespace abcd {
@@ -68,6 +79,9 @@ struct PendingSweep
 struct WatcherInfo
 {
     abcd::watcher *watcher;
+    abcd::RecordLog *journal;
+    std::mutex journalMutex;
+    std::set<bc::hash_digest> journalPending; // Unconfirmed at the last sync
     std::set<std::string> addresses;
     std::list<PendingSweep> sweeping;
 
@@ -80,12 +94,36 @@ struct WatcherInfo
 typedef std::string WalletUUID;
 static std::map<WalletUUID, WatcherInfo*> watchers_;
 
+// Watcher cache writes are coalesced and done on a single thread.
+// Each request waits a short while, so a burst turns into one write,
+// and no wallet gets written more than once per interval:
+typedef std::chrono::steady_clock SaveClock;
+static const auto gSaveDelay = std::chrono::seconds(2);
+static const auto gSaveInterval = std::chrono::seconds(30);
+static std::map<WatcherInfo *, SaveClock::time_point> gSavePending; // When each write is due
+static std::map<WatcherInfo *, SaveClock::time_point> gSaveLast;
+static WatcherInfo *gSaveBusy = nullptr;
+static bool gSaveRunning = false;
+static bool gSaveFlush = false;
+static std::mutex gSaveMutex;
+static std::condition_variable gSaveCondition;
+
+// Between checkpoints, changes to the watcher database go into a journal,
+// which only grows by the size of each change. Once enough transactions
+// build up, the whole database gets written out again:
+static const size_t gJournalLimit = 256;
+static const std::string gJournalTxPrefix = "tx/";
+static const std::string gJournalTxHeightPrefix = "txheight/";
+static const std::string gJournalForgetPrefix = "forget/";
+static const std::string gJournalHeight = "height";
+
 // The last obelisk server we connected to:
 static unsigned gLastObelisk = 0;
 
 static tABC_CC     ABC_BridgeDoSweep(WatcherInfo *watcherInfo, PendingSweep& sweep, tABC_Error *pError);
 static void        ABC_BridgeQuietCallback(WatcherInfo *watcherInfo);
-static void        ABC_BridgeTxCallback(WatcherInfo *watcherInfo, const libbitcoin::transaction_type& tx, tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback, void *pData);
+static void        ABC_BridgeTxCallback(WatcherInfo *watcherInfo, const std::vector<libbitcoin::transaction_type>& txs, tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback, void *pData);
+static tABC_CC     ABC_BridgeTxDecode(WatcherInfo *watcherInfo, const libbitcoin::transaction_type& tx, tABC_TxIncoming *pIncoming, bool *pbMine, tABC_Error *pError);
 static tABC_CC     ABC_BridgeExtractOutputs(abcd::watcher *watcher, abcd::unsigned_transaction_type *utx, std::string malleableId, tABC_UnsignedTx *pUtx, tABC_Error *pError);
 static tABC_CC     ABC_BridgeTxErrorHandler(abcd::unsigned_transaction_type *utx, tABC_Error *pError);
 static void        ABC_BridgeAppendOutput(bc::transaction_output_list& outputs, uint64_t amount, const bc::payment_address &addr);
@@ -93,10 +131,16 @@ static bc::script_type ABC_BridgeCreateScriptHash(const bc::short_hash &script_h
 static bc::script_type ABC_BridgeCreatePubKeyHash(const bc::short_hash &pubkey_hash);
 static uint64_t    ABC_BridgeCalcAbFees(uint64_t amount, tABC_GeneralInfo *pInfo);
 static uint64_t    ABC_BridgeCalcMinerFees(size_t tx_size, tABC_GeneralInfo *pInfo, uint64_t amountSatoshi);
+static void        ABC_BridgeTxFees(uint64_t amount, size_t inputs, bool bTransfer, tABC_GeneralInfo *pInfo, uint64_t *pAbFees, uint64_t *pMinerFees);
 static std::string ABC_BridgeWatcherFile(const char *szWalletUUID);
 static tABC_CC     ABC_BridgeWatcherLoad(WatcherInfo *watcherInfo, tABC_Error *pError);
 static void        ABC_BridgeWatcherSerializeAsync(WatcherInfo *watcherInfo);
-static void        *ABC_BridgeWatcherSerialize(void *pData);
+static void        ABC_BridgeWatcherSaveLoop();
+static void        ABC_BridgeWatcherSerialize(WatcherInfo *watcherInfo);
+static void        ABC_BridgeJournalTxs(WatcherInfo *watcherInfo, const std::vector<bc::transaction_type>& txs, libwallet::tx_state state);
+static void        ABC_BridgeJournalHeight(WatcherInfo *watcherInfo, size_t height);
+static void        ABC_BridgeJournalSync(WatcherInfo *watcherInfo);
+static void        ABC_BridgeJournalReplay(WatcherInfo *watcherInfo);
 static std::string ABC_BridgeNonMalleableTxId(bc::transaction_type tx);
 
 tABC_CC ABC_BridgeSweepKey(tABC_WalletID self,
@@ -154,6 +198,8 @@ tABC_CC ABC_BridgeWatcherStart(tABC_WalletID self,
     watcherInfo->watcher = new abcd::watcher();
 
     ABC_CHECK_RET(ABC_WalletIDCopy(&watcherInfo->wallet, self, pError));
+    watcherInfo->journal = new abcd::RecordLog(
+        ABC_BridgeWatcherFile(self.szUUID) + ".journal", "watcher", false);
 
     ABC_BridgeWatcherLoad(watcherInfo, pError);
     watchers_[self.szUUID] = watcherInfo;
@@ -185,17 +231,18 @@ tABC_CC ABC_BridgeWatcherLoop(const char *szWalletUUID,
     watcherInfo->fAsyncCallback = fAsyncCallback;
     watcherInfo->pData = pData;
 
-    txCallback = [watcherInfo, fAsyncCallback, pData] (const libbitcoin::transaction_type& tx)
+    txCallback = [watcherInfo, fAsyncCallback, pData] (const std::vector<libbitcoin::transaction_type>& txs)
     {
-        ABC_BridgeTxCallback(watcherInfo, tx, fAsyncCallback, pData);
+        ABC_BridgeTxCallback(watcherInfo, txs, fAsyncCallback, pData);
     };
     watcherInfo->watcher->set_tx_callback(txCallback);
 
     heightCallback = [watcherInfo, fAsyncCallback, pData](const size_t height)
     {
         tABC_Error error;
-        ABC_TxBlockHeightUpdate(height, fAsyncCallback, pData, &error);
-        ABC_BridgeWatcherSerializeAsync(watcherInfo);
+        ABC_TxBlockHeightUpdate(watcherInfo->wallet, height, fAsyncCallback, pData, &error);
+        ABC_BridgeJournalHeight(watcherInfo, height);
+        ABC_BridgeJournalSync(watcherInfo);
     };
     watcherInfo->watcher->set_height_callback(heightCallback);
 
@@ -370,12 +417,31 @@ tABC_CC ABC_BridgeWatcherDelete(const char *szWalletUUID, tABC_Error *pError)
     // Remove info from map:
     watchers_.erase(szWalletUUID);
 
+    // Detach the callbacks, so the watcher thread can't queue any more
+    // writes. The watcher makes its calls under a lock, so this also
+    // waits for any call already in progress:
+    watcherInfo->watcher->set_tx_callback(nullptr);
+    watcherInfo->watcher->set_height_callback(nullptr);
+    watcherInfo->watcher->set_tx_sent_callback(nullptr);
+    watcherInfo->watcher->set_quiet_callback(nullptr);
+    watcherInfo->watcher->set_fail_callback(nullptr);
+
+    // Cancel any background write, since we are about to write anyhow:
+    {
+        std::unique_lock<std::mutex> lock(gSaveMutex);
+        gSavePending.erase(watcherInfo);
+        gSaveCondition.wait(lock, [watcherInfo]{ return gSaveBusy != watcherInfo; });
+        gSaveLast.erase(watcherInfo);
+    }
+
     // Delete watcher:
     ABC_BridgeWatcherSerialize(watcherInfo);
     if (watcherInfo->watcher != NULL) {
         delete watcherInfo->watcher;
     }
     watcherInfo->watcher = NULL;
+    delete watcherInfo->journal;
+    watcherInfo->journal = NULL;
 
     // Delete info:
     ABC_WalletIDFree(watcherInfo->wallet);
@@ -400,6 +466,7 @@ tABC_CC ABC_BridgeTxMake(tABC_TxSendInfo *pSendInfo,
     abcd::unsigned_transaction_type *utx;
     bc::transaction_output_list outputs;
     uint64_t totalAmountSatoshi = 0, abFees = 0, minerFees = 0;
+    bool bMade = false;
     std::vector<bc::payment_address> addresses_;
 
     // Find a watcher to use
@@ -433,15 +500,20 @@ tABC_CC ABC_BridgeTxMake(tABC_TxSendInfo *pSendInfo,
     ABC_CHECK_ASSERT(true == ab.set_encoded(ppInfo->pAirBitzFee->szAddresss),
         ABC_CC_Error, "Bad ABV address");
 
-    schedule.satoshi_per_kb = ppInfo->countMinersFees;
     totalAmountSatoshi = pSendInfo->pDetails->amountSatoshi;
 
+    // Miners fees depend on the size of the transaction,
+    // which coin selection works out as it goes:
+    schedule.fees = [ppInfo, pSendInfo](size_t size)
+    {
+        return ABC_BridgeCalcMinerFees(size, ppInfo,
+            pSendInfo->pDetails->amountSatoshi);
+    };
+
     if (!pSendInfo->bTransfer)
     {
-        // Calculate AB Fees
+        // Add in AB fees
         abFees = ABC_BridgeCalcAbFees(pSendInfo->pDetails->amountSatoshi, ppInfo);
-
-        // Add in miners fees
         if (abFees > 0)
         {
             pSendInfo->pDetails->amountFeesAirbitzSatoshi = abFees;
@@ -454,22 +526,18 @@ tABC_CC ABC_BridgeTxMake(tABC_TxSendInfo *pSendInfo,
     // Output to  Destination Address
     ABC_BridgeAppendOutput(outputs, pSendInfo->pDetails->amountSatoshi, dest);
 
-    minerFees = ABC_BridgeCalcMinerFees(bc::satoshi_raw_size(utx->tx), ppInfo, pSendInfo->pDetails->amountSatoshi);
-    if (minerFees > 0)
-    {
-        // If there are miner fees, increase totalSatoshi
-        pSendInfo->pDetails->amountFeesMinersSatoshi = minerFees;
-        totalAmountSatoshi += minerFees;
-    }
-    // Set the fees in the send details
-    pSendInfo->pDetails->amountFeesAirbitzSatoshi = abFees;
-    pSendInfo->pDetails->amountFeesMinersSatoshi = minerFees;
-    ABC_DebugLog("Change: %s, Amount: %ld, Amount w/Fees %d\n",
+    ABC_DebugLog("Change: %s, Amount: %ld, Amount w/AB Fees %d\n",
                     change.encoded().c_str(),
                     pSendInfo->pDetails->amountSatoshi,
                     totalAmountSatoshi);
-    if (!abcd::make_tx(*(row->second->watcher), addresses_, change,
-                            totalAmountSatoshi, schedule, outputs, *utx))
+    bMade = abcd::make_tx(*(row->second->watcher), addresses_, change,
+                          totalAmountSatoshi, schedule, outputs, *utx);
+
+    // Set the fees in the send details
+    minerFees = utx->fees;
+    pSendInfo->pDetails->amountFeesAirbitzSatoshi = abFees;
+    pSendInfo->pDetails->amountFeesMinersSatoshi = minerFees;
+    if (!bMade)
     {
         ABC_CHECK_RET(ABC_BridgeTxErrorHandler(utx, pError));
     }
@@ -526,7 +594,7 @@ tABC_CC ABC_BridgeTxSignSend(tABC_TxSendInfo *pSendInfo,
     malleableId = bc::encode_hex(bc::hash_transaction(utx->tx));
     ABC_STRDUP(pUtx->szTxMalleableId, malleableId.c_str());
 
-    ABC_BridgeWatcherSerializeAsync(watcherInfo);
+    ABC_BridgeJournalTxs(watcherInfo, {utx->tx}, libwallet::tx_state::unsent);
     ABC_BridgeExtractOutputs(watcherInfo->watcher, utx, malleableId, pUtx,pError);
 
 exit:
@@ -543,14 +611,12 @@ tABC_CC ABC_BridgeMaxSpendable(tABC_WalletID self,
     tABC_TxSendInfo SendInfo = {{0}};
     tABC_TxDetails Details;
     tABC_GeneralInfo *ppInfo = NULL;
-    tABC_UnsignedTx utx;
-    tABC_CC txResp;
 
     char *changeAddr = NULL;
     AutoStringArray addresses;
 
     auto row = watchers_.find(self.szUUID);
-    uint64_t total = 0;
+    uint64_t balance = 0, total = 0, fee = 0, abFees = 0, minerFees = 0;
 
     ABC_CHECK_ASSERT(row != watchers_.end(),
         ABC_CC_Error, "Unable find watcher");
@@ -572,34 +638,46 @@ tABC_CC ABC_BridgeMaxSpendable(tABC_WalletID self,
         // Calculate total of utxos for these addresses
         ABC_DebugLog("Get UTOXs for %d\n", addresses.size);
         auto utxos = row->second->watcher->get_utxos(true);
-        for (const auto& utxo: utxos)
-        {
-            total += utxo.value;
-        }
+        for (auto &utxo: utxos)
+            balance += utxo.value;
+        total = balance;
         if (!bTransfer)
         {
             // Subtract ab tx fee
-            total -= ABC_BridgeCalcAbFees(total, ppInfo);
+            fee = ABC_BridgeCalcAbFees(total, ppInfo);
+            total = fee < total ? total - fee : 0;
         }
-        // Subtract minimum tx fee
-        total -= ABC_BridgeCalcMinerFees(0, ppInfo, total);
+        // Subtract the tx fee for spending everything, with no change:
+        fee = ABC_BridgeCalcMinerFees(
+            abcd::coinSelectSize(utxos.size(), fee > 0 ? 2 : 1),
+            ppInfo, total);
+        total = fee < total ? total - fee : 0;
 
         SendInfo.pDetails = &Details;
         SendInfo.bTransfer = bTransfer;
-        Details.amountSatoshi = total;
 
-        // Ewwwwww, fix this to have minimal iterations
-        txResp = ABC_BridgeTxMake(&SendInfo,
-                                  addresses.data, addresses.size,
-                                  changeAddr, &utx, pError);
-        while (txResp == ABC_CC_InsufficientFunds && Details.amountSatoshi > 0)
+        // Coin selection can always fall back on spending everything,
+        // so the estimate builds whenever those fees fit in the balance:
+        ABC_BridgeTxFees(total, utxos.size(), bTransfer, ppInfo,
+                         &abFees, &minerFees);
+        if (abcd::min_output <= total && total + abFees + minerFees <= balance)
+        {
+            *pMaxSatoshi = total;
+        }
+        else
         {
-            Details.amountSatoshi -= 1;
-            txResp = ABC_BridgeTxMake(&SendInfo,
-                                      addresses.data, addresses.size,
-                                      changeAddr, &utx, pError);
+            // Otherwise, find the largest amount that actually builds:
+            *pMaxSatoshi = abcd::spendableSearch(total, [&](uint64_t amount)
+            {
+                tABC_Error error;
+                tABC_UnsignedTx utx = {};
+                Details.amountSatoshi = amount;
+                tABC_CC txResp = ABC_BridgeTxMake(&SendInfo,
+                    addresses.data, addresses.size, changeAddr, &utx, &error);
+                delete static_cast<abcd::unsigned_transaction_type *>(utx.data);
+                return ABC_CC_InsufficientFunds != txResp;
+            });
         }
-        *pMaxSatoshi = AB_MAX(Details.amountSatoshi, 0);
     }
     else
     {
@@ -633,6 +711,31 @@ exit:
     return cc;
 }
 
+/**
+ * Looks up a transaction in the watcher database.
+ * @param pbFound   Set to false if the watcher doesn't have the transaction.
+ * @param pHeight   The transaction's block height, or 0 if it is unconfirmed.
+ */
+tABC_CC
+ABC_BridgeTxFind(const char *szWalletUUID, const char *szTxId,
+                 bool *pbFound, unsigned int *pHeight, tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    int height = 0;
+    bc::hash_digest txid;
+
+    auto row = watchers_.find(szWalletUUID);
+    ABC_CHECK_ASSERT(row != watchers_.end(),
+        ABC_CC_Synchronizing, "Unable to find watcher");
+
+    txid = bc::decode_hash(szTxId);
+    *pbFound = row->second->watcher->get_tx_height(txid, height);
+    *pHeight = *pbFound ? height : 0;
+
+exit:
+    return cc;
+}
+
 tABC_CC
 ABC_BridgeTxBlockHeight(const char *szWalletUUID, unsigned int *height, tABC_Error *pError)
 {
@@ -959,6 +1062,9 @@ exit:
 static
 void ABC_BridgeQuietCallback(WatcherInfo *watcherInfo)
 {
+    // The updater has caught up, so any confirmations have landed:
+    ABC_BridgeJournalSync(watcherInfo);
+
     // If we are sweeping any keys, do that now:
     for (auto& sweep: watcherInfo->sweeping)
     {
@@ -979,32 +1085,82 @@ void ABC_BridgeQuietCallback(WatcherInfo *watcherInfo)
         return sweep.done; });
 }
 
+/**
+ * Hands a batch of new transactions over to the wallet,
+ * leaving out the ones that don't concern it.
+ */
 static
-void ABC_BridgeTxCallback(WatcherInfo *watcherInfo, const libbitcoin::transaction_type& tx,
+void ABC_BridgeTxCallback(WatcherInfo *watcherInfo, const std::vector<libbitcoin::transaction_type>& txs,
                           tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
                           void *pData)
 {
-    tABC_CC cc = ABC_CC_Ok;
     tABC_Error error;
-    tABC_Error *pError = &error;
-    int64_t fees = 0;
-    int64_t totalInSatoshi = 0, totalOutSatoshi = 0, totalMeSatoshi = 0, totalMeInSatoshi = 0;
-    tABC_TxOutput **iarr = NULL, **oarr = NULL;
-    unsigned int idx = 0, iCount = 0, oCount = 0;
-    std::string txId, malTxId;
+    std::vector<tABC_TxIncoming> incoming;
 
     if (watcherInfo == NULL)
+        return;
+
+    // Everything here is already in the database, mine or not:
+    ABC_BridgeJournalTxs(watcherInfo, txs, libwallet::tx_state::unconfirmed);
+
+    incoming.reserve(txs.size());
+    for (const auto& tx: txs)
     {
-        cc = ABC_CC_Error;
-        goto exit;
+        tABC_TxIncoming item = {};
+        bool bMine = false;
+        if (ABC_CC_Ok == ABC_BridgeTxDecode(watcherInfo, tx, &item, &bMine, &error) && bMine)
+        {
+            incoming.push_back(item);
+        }
+        else
+        {
+            ABC_FREE_STR(item.szTxId);
+            ABC_FREE_STR(item.szMalTxId);
+            ABC_TxFreeOutputs(item.aInputs, item.inputCount);
+            ABC_TxFreeOutputs(item.aOutputs, item.outputCount);
+        }
     }
 
+    if (incoming.size())
+    {
+        ABC_DebugLog("calling ABC_TxReceiveTransactions with %d transactions\n",
+                     (int)incoming.size());
+        ABC_TxReceiveTransactions(watcherInfo->wallet,
+                                  incoming.data(), incoming.size(),
+                                  fAsyncBitCoinEventCallback, pData, &error);
+    }
+
+    for (auto& item: incoming)
+    {
+        ABC_FREE_STR(item.szTxId);
+        ABC_FREE_STR(item.szMalTxId);
+        ABC_TxFreeOutputs(item.aInputs, item.inputCount);
+        ABC_TxFreeOutputs(item.aOutputs, item.outputCount);
+    }
+}
+
+/**
+ * Works out what a new transaction means for the wallet.
+ * @param pIncoming Receives the decoded transaction.
+ * The caller must free its contents, even on failure.
+ * @param pbMine    Set to false if the transaction doesn't concern the wallet.
+ */
+static tABC_CC
+ABC_BridgeTxDecode(WatcherInfo *watcherInfo, const libbitcoin::transaction_type& tx,
+                   tABC_TxIncoming *pIncoming, bool *pbMine, tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    int64_t fees = 0;
+    int64_t totalInSatoshi = 0, totalOutSatoshi = 0, totalMeSatoshi = 0, totalMeInSatoshi = 0;
+    unsigned int idx = 0;
+    std::string txId, malTxId;
+
     txId = ABC_BridgeNonMalleableTxId(tx);
     malTxId = bc::encode_hex(bc::hash_transaction(tx));
 
+    ABC_ARRAY_NEW(pIncoming->aInputs, tx.inputs.size(), tABC_TxOutput*);
+    pIncoming->inputCount = tx.inputs.size();
     idx = 0;
-    iCount = tx.inputs.size();
-    iarr = (tABC_TxOutput **) malloc(sizeof(tABC_TxOutput *) * iCount);
     for (auto i : tx.inputs)
     {
         bc::payment_address addr;
@@ -1012,7 +1168,9 @@ void ABC_BridgeTxCallback(WatcherInfo *watcherInfo, const libbitcoin::transactio
         auto prev = i.previous_output;
 
         // Create output
-        tABC_TxOutput *out = (tABC_TxOutput *) malloc(sizeof(tABC_TxOutput));
+        tABC_TxOutput *out = NULL;
+        ABC_NEW(out, tABC_TxOutput);
+        pIncoming->aInputs[idx++] = out;
         out->input = true;
         ABC_STRDUP(out->szTxId, bc::encode_hex(prev.hash).c_str());
         ABC_STRDUP(out->szAddress, addr.encoded().c_str());
@@ -1027,19 +1185,19 @@ void ABC_BridgeTxCallback(WatcherInfo *watcherInfo, const libbitcoin::transactio
             if  (row != watcherInfo->addresses.end())
                 totalMeInSatoshi += tx.outputs[prev.index].value;
         }
-        iarr[idx] = out;
-        idx++;
     }
 
+    ABC_ARRAY_NEW(pIncoming->aOutputs, tx.outputs.size(), tABC_TxOutput*);
+    pIncoming->outputCount = tx.outputs.size();
     idx = 0;
-    oCount = tx.outputs.size();
-    oarr = (tABC_TxOutput **) malloc(sizeof(tABC_TxOutput *) * oCount);
     for (auto o : tx.outputs)
     {
         bc::payment_address addr;
         bc::extract(addr, o.script);
         // Create output
-        tABC_TxOutput *out = (tABC_TxOutput *) malloc(sizeof(tABC_TxOutput));
+        tABC_TxOutput *out = NULL;
+        ABC_NEW(out, tABC_TxOutput);
+        pIncoming->aOutputs[idx++] = out;
         out->input = false;
         out->value = o.value;
         ABC_STRDUP(out->szAddress, addr.encoded().c_str());
@@ -1052,35 +1210,26 @@ void ABC_BridgeTxCallback(WatcherInfo *watcherInfo, const libbitcoin::transactio
             totalMeSatoshi += o.value;
         }
         totalOutSatoshi += o.value;
-
-        oarr[idx] = out;
-        idx++;
     }
     if (totalMeSatoshi == 0 && totalMeInSatoshi == 0)
     {
         ABC_DebugLog("values == 0, this tx does not concern me.\n");
+        *pbMine = false;
         goto exit;
     }
     fees = totalInSatoshi - totalOutSatoshi;
     totalMeSatoshi -= totalMeInSatoshi;
 
-    ABC_DebugLog("calling ABC_TxReceiveTransaction\n");
     ABC_DebugLog("Total Me: %d, Total In: %d, Total Out: %d, Fees: %d\n",
                     totalMeSatoshi, totalInSatoshi, totalOutSatoshi, fees);
-    ABC_CHECK_RET(
-        ABC_TxReceiveTransaction(
-            watcherInfo->wallet,
-            totalMeSatoshi, fees,
-            iarr, iCount,
-            oarr, oCount,
-            txId.c_str(), malTxId.c_str(),
-            fAsyncBitCoinEventCallback,
-            pData,
-            &error));
-    ABC_BridgeWatcherSerializeAsync(watcherInfo);
+    ABC_STRDUP(pIncoming->szTxId, txId.c_str());
+    ABC_STRDUP(pIncoming->szMalTxId, malTxId.c_str());
+    pIncoming->amountSatoshi = totalMeSatoshi;
+    pIncoming->feeSatoshi = fees;
+    *pbMine = true;
+
 exit:
-    ABC_FREE(oarr);
-    ABC_FREE(iarr);
+    return cc;
 }
 
 static tABC_CC
@@ -1206,10 +1355,12 @@ uint64_t ABC_BridgeCalcAbFees(uint64_t amount, tABC_GeneralInfo *pInfo)
 static
 uint64_t ABC_BridgeCalcMinerFees(size_t tx_size, tABC_GeneralInfo *pInfo, uint64_t amountSatoshi)
 {
-    // Look up the size-based fees from the table:
+    // Look up the size-based fees from the table,
+    // with anything past the end paying the largest fee:
     uint64_t sizeFee = 0;
     if (pInfo->countMinersFees > 0)
     {
+        sizeFee = pInfo->aMinersFees[pInfo->countMinersFees - 1]->amountSatoshi;
         for (unsigned i = 0; i < pInfo->countMinersFees; ++i)
         {
             if (tx_size <= pInfo->aMinersFees[i]->sizeTransaction)
@@ -1234,6 +1385,20 @@ uint64_t ABC_BridgeCalcMinerFees(size_t tx_size, tABC_GeneralInfo *pInfo, uint64
     return amountFee - amountFee % minFee;
 }
 
+/**
+ * Works out the fees ABC_BridgeTxMake charges for sending an amount
+ * by spending the given number of outputs, with no change.
+ */
+static
+void ABC_BridgeTxFees(uint64_t amount, size_t inputs, bool bTransfer,
+                      tABC_GeneralInfo *pInfo,
+                      uint64_t *pAbFees, uint64_t *pMinerFees)
+{
+    *pAbFees = bTransfer ? 0 : ABC_BridgeCalcAbFees(amount, pInfo);
+    *pMinerFees = ABC_BridgeCalcMinerFees(
+        abcd::coinSelectSize(inputs, *pAbFees > 0 ? 2 : 1), pInfo, amount);
+}
+
 static
 std::string ABC_BridgeWatcherFile(const char *szWalletUUID)
 {
@@ -1251,8 +1416,7 @@ static
 tABC_CC ABC_BridgeWatcherLoad(WatcherInfo *watcherInfo, tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
-    uint8_t *pData = NULL;
-    std::streampos size;
+    bc::data_chunk db;
 
     std::string filepath(
             ABC_BridgeWatcherFile(watcherInfo->wallet.szUUID));
@@ -1260,53 +1424,356 @@ tABC_CC ABC_BridgeWatcherLoad(WatcherInfo *watcherInfo, tABC_Error *pError)
     struct stat buffer;
     if (stat(filepath.c_str(), &buffer) == 0)
     {
-        std::ifstream file(filepath, std::ios::in | std::ios::binary | std::ios::ate);
-        ABC_CHECK_ASSERT(file.is_open() == true, ABC_CC_Error, "Unable to open file for loading");
-
-        size = file.tellg();
-        pData = new uint8_t[size];
-        file.seekg(0, std::ios::beg);
-        file.read(reinterpret_cast<char *>(pData), size);
-        file.close();
-
-        ABC_CHECK_ASSERT(watcherInfo->watcher->load(bc::data_chunk(pData, pData + size)) == true,
-            ABC_CC_Error, "Unable to load serialized state\n");
+        // A damaged cache is no worse than a missing one,
+        // since the watcher can always fetch everything again:
+        Status s = watcherCacheLoad(db, filepath);
+        if (s)
+        {
+            ABC_CHECK_ASSERT(watcherInfo->watcher->load(db) == true,
+                ABC_CC_Error, "Unable to load serialized state\n");
+        }
+        else
+        {
+            ABC_DebugLog("Discarding watcher cache for %s: %s\n",
+                watcherInfo->wallet.szUUID, s.message().c_str());
+        }
     }
+    ABC_BridgeJournalReplay(watcherInfo);
+
 exit:
-    ABC_FREE(pData);
     return cc;
 }
 
+/**
+ * Schedules the watcher's cache to be written out in the background.
+ * Requests that arrive before the write happens are merged into it.
+ */
 static
 void ABC_BridgeWatcherSerializeAsync(WatcherInfo *watcherInfo)
 {
-    pthread_t handle;
-    if (!pthread_create(&handle, NULL, ABC_BridgeWatcherSerialize, watcherInfo))
+    std::lock_guard<std::mutex> lock(gSaveMutex);
+
+    if (gSavePending.count(watcherInfo))
+        return;
+
+    auto due = SaveClock::now() + gSaveDelay;
+    auto last = gSaveLast.find(watcherInfo);
+    if (last != gSaveLast.end())
+        due = std::max(due, last->second + gSaveInterval);
+    gSavePending[watcherInfo] = due;
+
+    if (gSaveRunning)
+    {
+        gSaveCondition.notify_all();
+        return;
+    }
+    try
     {
-        pthread_detach(handle);
+        std::thread(ABC_BridgeWatcherSaveLoop).detach();
+        gSaveRunning = true;
+    }
+    catch (const std::system_error &)
+    {
+        // The next request will try again
     }
 }
 
+/**
+ * Writes out pending watcher caches as they come due,
+ * and exits once there are none left.
+ */
 static
-void *ABC_BridgeWatcherSerialize(void *pData)
+void ABC_BridgeWatcherSaveLoop()
+{
+    std::unique_lock<std::mutex> lock(gSaveMutex);
+
+    while (!gSavePending.empty())
+    {
+        auto next = std::min_element(gSavePending.begin(), gSavePending.end(),
+            [](const std::pair<WatcherInfo *const, SaveClock::time_point> &a,
+               const std::pair<WatcherInfo *const, SaveClock::time_point> &b)
+            {
+                return a.second < b.second;
+            });
+        if (!gSaveFlush && SaveClock::now() < next->second)
+        {
+            gSaveCondition.wait_until(lock, next->second);
+            continue;
+        }
+
+        WatcherInfo *watcherInfo = next->first;
+        gSavePending.erase(next);
+        gSaveBusy = watcherInfo;
+        lock.unlock();
+        ABC_BridgeWatcherSerialize(watcherInfo);
+        lock.lock();
+        gSaveBusy = nullptr;
+        gSaveLast[watcherInfo] = SaveClock::now();
+        gSaveCondition.notify_all();
+    }
+
+    gSaveRunning = false;
+    gSaveCondition.notify_all();
+}
+
+void
+watcherBridgeFlush()
+{
+    std::unique_lock<std::mutex> lock(gSaveMutex);
+
+    gSaveFlush = true;
+    gSaveCondition.notify_all();
+    gSaveCondition.wait(lock, []{ return !gSaveRunning; });
+
+    // Anything left over never got a thread, so write it here:
+    while (!gSavePending.empty())
+    {
+        WatcherInfo *watcherInfo = gSavePending.begin()->first;
+        gSavePending.erase(gSavePending.begin());
+        lock.unlock();
+        ABC_BridgeWatcherSerialize(watcherInfo);
+        lock.lock();
+    }
+    gSaveFlush = false;
+}
+
+/**
+ * Writes the watcher's cache to disk.
+ * The data goes to a temporary file first, which then replaces
+ * the old cache in one step, so a crash never leaves half a file.
+ */
+static
+void ABC_BridgeWatcherSerialize(WatcherInfo *watcherInfo)
 {
-    bc::data_chunk db;
-    WatcherInfo *watcherInfo = (WatcherInfo *) pData;
     std::string filepath(
             ABC_BridgeWatcherFile(watcherInfo->wallet.szUUID));
+    std::string temppath = filepath + ".tmp";
 
-    std::ofstream file(filepath);
-    if (!file.is_open())
+    // Only journal entries the database already reflects will be in this
+    // checkpoint, since sent transactions reach it asynchronously.
+    // Remember each entry's stamp, in case it changes before the trim:
+    ABC_BridgeJournalSync(watcherInfo);
+    std::map<std::string, uint64_t> covered;
     {
-        ABC_DebugLog("Unable to open file for serialization");
+        std::lock_guard<std::mutex> lock(watcherInfo->journalMutex);
+        auto &journal = *watcherInfo->journal;
+        for (const auto &key: journal.keys(gJournalTxPrefix))
+        {
+            auto hex = key.substr(gJournalTxPrefix.size());
+            bc::data_chunk record;
+            if (watcherInfo->watcher->db().has_tx(bc::decode_hash(hex)) ||
+                journal.get(record, gJournalForgetPrefix + hex))
+                covered[key] = journal.stamp(key);
+        }
+        for (const auto &prefix: {gJournalTxHeightPrefix, gJournalForgetPrefix})
+            for (const auto &key: journal.keys(prefix))
+                covered[key] = journal.stamp(key);
     }
-    else
+
+    bc::data_chunk db = watcherInfo->watcher->serialize();
+    if (!fileSave(watcherCacheEncode(db), temppath) ||
+        rename(temppath.c_str(), filepath.c_str()))
+    {
+        ABC_DebugLog("Unable to save watcher cache for %s\n", watcherInfo->wallet.szUUID);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(watcherInfo->journalMutex);
+    watcherInfo->journal->begin();
+    for (const auto &i: covered)
+        if (watcherInfo->journal->stamp(i.first) == i.second)
+            watcherInfo->journal->erase(i.first);
+    if (!watcherInfo->journal->commit())
+        ABC_DebugLog("Unable to trim watcher journal for %s\n", watcherInfo->wallet.szUUID);
+}
+
+/**
+ * Records transactions that just went into the watcher database,
+ * scheduling a checkpoint once the journal gets long.
+ * An existing record is kept, so a sent transaction stays unsent
+ * even after the watcher reports it back.
+ */
+static
+void ABC_BridgeJournalTxs(WatcherInfo *watcherInfo,
+                          const std::vector<bc::transaction_type>& txs,
+                          libwallet::tx_state state)
+{
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(watcherInfo->journalMutex);
+        watcherInfo->journal->begin();
+        for (const auto& tx: txs)
+        {
+            std::string key = gJournalTxPrefix +
+                bc::encode_hex(bc::hash_transaction(tx));
+            bc::data_chunk record;
+            if (watcherInfo->journal->get(record, key))
+                continue;
+
+            record.resize(1 + satoshi_raw_size(tx));
+            record[0] = static_cast<uint8_t>(state);
+            bc::satoshi_save(tx, record.begin() + 1);
+            watcherInfo->journal->set(key, record);
+        }
+        if (!watcherInfo->journal->commit())
+            ABC_DebugLog("Unable to write watcher journal for %s\n", watcherInfo->wallet.szUUID);
+        count = watcherInfo->journal->keys(gJournalTxPrefix).size();
+    }
+
+    if (gJournalLimit <= count)
+        ABC_BridgeWatcherSerializeAsync(watcherInfo);
+}
+
+/**
+ * Encodes a height for the journal.
+ */
+static bc::data_chunk
+ABC_BridgeJournalInt(uint64_t value)
+{
+    bc::data_chunk record(8);
+    abcd::putBigEndian(record.data(), value, 8);
+    return record;
+}
+
+/**
+ * Records a new block height.
+ * The record is overwritten each time, so it never needs a checkpoint.
+ */
+static
+void ABC_BridgeJournalHeight(WatcherInfo *watcherInfo, size_t height)
+{
+    bc::data_chunk record = ABC_BridgeJournalInt(height);
+
+    std::lock_guard<std::mutex> lock(watcherInfo->journalMutex);
+    if (!watcherInfo->journal->set(gJournalHeight, record))
+        ABC_DebugLog("Unable to write watcher journal for %s\n", watcherInfo->wallet.szUUID);
+}
+
+/**
+ * Records the confirmations and forgotten transactions that the database
+ * picked up since the last call, since it makes those changes without
+ * reporting them. Only transactions that were unconfirmed last time
+ * can have changed, so those are the only ones checked.
+ */
+static
+void ABC_BridgeJournalSync(WatcherInfo *watcherInfo)
+{
+    auto &db = watcherInfo->watcher->db();
+    std::lock_guard<std::mutex> lock(watcherInfo->journalMutex);
+    auto &journal = *watcherInfo->journal;
+
+    std::set<bc::hash_digest> pending;
+    db.foreach_unconfirmed([&pending](bc::hash_digest txid)
     {
-        db = watcherInfo->watcher->serialize();
-        file.write(reinterpret_cast<const char *>(db.data()), db.size());
-        file.close();
+        pending.insert(txid);
+    });
+
+    journal.begin();
+    for (const auto &txid: watcherInfo->journalPending)
+    {
+        if (pending.count(txid))
+            continue;
+        std::string hex = bc::encode_hex(txid);
+        if (db.has_tx(txid))
+            journal.set(gJournalTxHeightPrefix + hex,
+                ABC_BridgeJournalInt(db.get_tx_height(txid)));
+        else
+            journal.set(gJournalForgetPrefix + hex, bc::data_chunk());
     }
-    return NULL;
+
+    // A transaction can also come back, or drop back to unconfirmed
+    // after a reorg. If the journal or checkpoint might have it
+    // forgotten or confirmed, record that it isn't any more:
+    for (const auto &txid: pending)
+    {
+        if (watcherInfo->journalPending.count(txid))
+            continue;
+        std::string hex = bc::encode_hex(txid);
+        journal.erase(gJournalForgetPrefix + hex);
+        bc::data_chunk record;
+        if (journal.get(record, gJournalTxHeightPrefix + hex) ||
+            !journal.get(record, gJournalTxPrefix + hex))
+            journal.set(gJournalTxHeightPrefix + hex, ABC_BridgeJournalInt(0));
+    }
+
+    if (!journal.commit())
+        ABC_DebugLog("Unable to write watcher journal for %s\n", watcherInfo->wallet.szUUID);
+    watcherInfo->journalPending.swap(pending);
+}
+
+/**
+ * Applies the journal on top of the last checkpoint: first the
+ * transactions, then any heights they have reached since,
+ * and finally the ones the database has forgotten.
+ */
+static
+void ABC_BridgeJournalReplay(WatcherInfo *watcherInfo)
+{
+    auto &db = watcherInfo->watcher->db();
+    std::lock_guard<std::mutex> lock(watcherInfo->journalMutex);
+
+    if (!watcherInfo->journal->load())
+    {
+        ABC_DebugLog("Unable to load watcher journal for %s\n", watcherInfo->wallet.szUUID);
+        return;
+    }
+
+    for (const auto &key: watcherInfo->journal->keys(gJournalTxPrefix))
+    {
+        bc::data_chunk record;
+        if (!watcherInfo->journal->get(record, key) || record.size() < 2)
+            continue;
+        if (db.has_tx(bc::decode_hash(key.substr(gJournalTxPrefix.size()))))
+            continue;
+
+        bc::transaction_type tx;
+        try
+        {
+            bc::satoshi_load(record.begin() + 1, record.end(), tx);
+        }
+        catch (const bc::end_of_stream&)
+        {
+            continue;
+        }
+        db.insert(tx, static_cast<libwallet::tx_state>(record[0]));
+    }
+
+    for (const auto &key: watcherInfo->journal->keys(gJournalTxHeightPrefix))
+    {
+        bc::data_chunk record;
+        auto txid = bc::decode_hash(key.substr(gJournalTxHeightPrefix.size()));
+        if (!watcherInfo->journal->get(record, key) || 8 != record.size() ||
+            !db.has_tx(txid))
+            continue;
+
+        uint64_t height = abcd::getBigEndian(record.data(), 8);
+        if (height)
+            db.confirmed(txid, height);
+        else
+            db.unconfirmed(txid);
+    }
+
+    for (const auto &key: watcherInfo->journal->keys(gJournalForgetPrefix))
+    {
+        auto txid = bc::decode_hash(key.substr(gJournalForgetPrefix.size()));
+        if (db.has_tx(txid))
+            db.forget(txid);
+    }
+
+    bc::data_chunk record;
+    if (watcherInfo->journal->get(record, gJournalHeight) && 8 == record.size())
+    {
+        uint64_t height = abcd::getBigEndian(record.data(), 8);
+        if (db.last_height() < height)
+            db.at_height(height);
+    }
+
+    // Later syncs only need to look at what is still unconfirmed:
+    watcherInfo->journalPending.clear();
+    db.foreach_unconfirmed([watcherInfo](bc::hash_digest txid)
+    {
+        watcherInfo->journalPending.insert(txid);
+    });
 }
 
 /**
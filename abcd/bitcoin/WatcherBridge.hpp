@@ -70,6 +70,12 @@ tABC_CC ABC_BridgeWatcherStop(const char *szWalletUUID, tABC_Error *pError);
 
 tABC_CC ABC_BridgeWatcherDelete(const char *szWalletUUID, tABC_Error *pError);
 
+/**
+ * Writes out any watcher caches still waiting on the background thread.
+ */
+void
+watcherBridgeFlush();
+
 tABC_CC ABC_BridgeWatchAddr(const char *szWalletUUID, const char *address,
                             tABC_Error *pError);
 
@@ -100,6 +106,8 @@ tABC_CC ABC_BridgeMaxSpendable(tABC_WalletID self,
 
 tABC_CC ABC_BridgeTxHeight(const char *szWalletUUID, const char *szTxId, unsigned int *height, tABC_Error *pError);
 
+tABC_CC ABC_BridgeTxFind(const char *szWalletUUID, const char *szTxId, bool *pbFound, unsigned int *pHeight, tABC_Error *pError);
+
 tABC_CC ABC_BridgeTxBlockHeight(const char *szWalletUUID, unsigned int *height, tABC_Error *pError);
 
 tABC_CC ABC_BridgeTxDetails(const char *szWalletUUID, const char *szTxID,
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "WatcherCache.hpp"
+#include <zlib.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace abcd {
+
+/*
+ * The cache file has the following layout, with integers in big-endian order:
+ *
+ *  4 bytes: magic number
+ *  4 bytes: format version
+ *  8 bytes: database length
+ *  4 bytes: CRC-32 of the database
+ *  database bytes, as produced by watcher::serialize
+ */
+constexpr size_t headerSize = 20;
+constexpr uint8_t cacheMagic[4] = {'A', 'B', 'W', 'C'};
+constexpr uint32_t cacheVersion = 1;
+
+/**
+ * Unmaps a file on the way out of scope.
+ */
+class AutoMap
+{
+public:
+    AutoMap(): data(nullptr), size(0) {}
+    ~AutoMap()
+    {
+        if (data)
+            munmap(data, size);
+    }
+
+    void *data;
+    size_t size;
+};
+
+/**
+ * Checks the header and checksum on a mapped cache file.
+ */
+static Status
+cacheDecode(DataChunk &result, DataSlice file)
+{
+    const uint8_t *p = file.data();
+
+    // Older files are just the bare database:
+    if (file.size() < sizeof(cacheMagic) ||
+        memcmp(p, cacheMagic, sizeof(cacheMagic)))
+    {
+        result.assign(file.begin(), file.end());
+        return Status();
+    }
+
+    if (file.size() < headerSize)
+        return ABC_ERROR(ABC_CC_ParseError, "Truncated watcher cache header");
+    if (cacheVersion != getBigEndian(p + 4, 4))
+        return ABC_ERROR(ABC_CC_ParseError, "Unknown watcher cache version");
+
+    const uint64_t size = getBigEndian(p + 8, 8);
+    if (file.size() - headerSize != size)
+        return ABC_ERROR(ABC_CC_ParseError, "Truncated watcher cache");
+    if (getBigEndian(p + 16, 4) != crc32(0, p + headerSize, size))
+        return ABC_ERROR(ABC_CC_ParseError, "Corrupt watcher cache");
+
+    result.assign(p + headerSize, p + headerSize + size);
+    return Status();
+}
+
+DataChunk
+watcherCacheEncode(DataSlice db)
+{
+    DataChunk out(headerSize + db.size());
+    uint8_t *p = out.data();
+
+    std::copy(cacheMagic, cacheMagic + sizeof(cacheMagic), p);
+    putBigEndian(p + 4, cacheVersion, 4);
+    putBigEndian(p + 8, db.size(), 8);
+    putBigEndian(p + 16, crc32(0, db.data(), db.size()), 4);
+    std::copy(db.begin(), db.end(), p + headerSize);
+
+    return out;
+}
+
+Status
+watcherCacheLoad(DataChunk &result, const std::string &filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return ABC_ERROR(ABC_CC_FileOpenError, "Cannot open " + filename);
+
+    struct stat info;
+    if (fstat(fd, &info))
+    {
+        close(fd);
+        return ABC_ERROR(ABC_CC_FileReadError, "Cannot read " + filename);
+    }
+    if (!info.st_size)
+    {
+        close(fd);
+        return ABC_ERROR(ABC_CC_ParseError, "Empty watcher cache");
+    }
+
+    AutoMap map;
+    map.size = info.st_size;
+    map.data = mmap(nullptr, map.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map.data)
+    {
+        map.data = nullptr;
+        return ABC_ERROR(ABC_CC_FileReadError, "Cannot map " + filename);
+    }
+
+    auto p = static_cast<const uint8_t *>(map.data);
+    return cacheDecode(result, DataSlice(p, p + map.size));
+}
+
+} // namespace abcd
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * On-disk format for the watcher's transaction database.
+ */
+
+#ifndef ABCD_BITCOIN_WATCHER_CACHE_HPP
+#define ABCD_BITCOIN_WATCHER_CACHE_HPP
+
+#include "../util/Data.hpp"
+#include "../util/Status.hpp"
+
+namespace abcd {
+
+/**
+ * Wraps a serialized watcher database in a versioned header
+ * with a checksum, ready to be written to disk.
+ */
+DataChunk
+watcherCacheEncode(DataSlice db);
+
+/**
+ * Reads a watcher cache file, returning the serialized database inside.
+ * The file is mapped into memory rather than read, and the checksum is
+ * verified before anything gets copied out, so a damaged file fails
+ * here instead of being half-loaded.
+ * Files written before the header existed are returned as-is.
+ */
+Status
+watcherCacheLoad(DataChunk &result, const std::string &filename);
+
+} // namespace abcd
+
+#endif
@@ -16,8 +16,6 @@ namespace abcd {
 using namespace libbitcoin;
 using namespace libwallet;
 
-constexpr unsigned min_output = 5430;
-
 static std::map<data_chunk, std::string> address_map;
 static operation create_data_operation(data_chunk& data);
 
@@ -37,34 +35,44 @@ BC_API bool make_tx(
 
     // Gather all the unspent outputs in the wallet:
     auto unspent = watcher.get_utxos(true);
-
-    // Select a collection of outputs that satisfies our requirements:
-    select_outputs_result utxos = select_outputs(unspent, amountSatoshi);
-    if (utxos.points.size() <= 0)
+    std::vector<uint64_t> values;
+    values.reserve(unspent.size());
+    for (auto &utxo : unspent)
+        values.push_back(utxo.value);
+
+    // Select a collection of outputs that covers the amount and fees:
+    CoinSelection selection;
+    bool enough = coinSelect(selection, values, amountSatoshi,
+        utx.tx.outputs.size(), sched.fees, min_output);
+    utx.fees = selection.fee;
+    if (!enough)
     {
         utx.code = insufficent_funds;
         return false;
     }
 
     // Build the transaction's input list:
-    for (auto &point : utxos.points)
+    for (auto i : selection.inputs)
     {
         transaction_input_type input;
         input.sequence = 4294967295;
-        input.previous_output = point;
+        input.previous_output = unspent[i].point;
         utx.tx.inputs.push_back(input);
     }
 
     // If change is needed, add that to the output list:
-    if (utxos.change > 0)
+    if (selection.change > 0)
     {
         transaction_output_type change;
-        change.value = utxos.change;
+        change.value = selection.change;
         change.script = build_pubkey_hash_script(changeAddr.hash());
         utx.tx.outputs.push_back(change);
     }
 
     // Remove any dust outputs, returning those funds to the miners:
+    for (auto &o : utx.tx.outputs)
+        if (o.value < min_output)
+            utx.fees += o.value;
     auto last = std::remove_if(utx.tx.outputs.begin(), utx.tx.outputs.end(),
         [](transaction_output_type &o){ return o.value < min_output; });
     utx.tx.outputs.erase(last, utx.tx.outputs.end());
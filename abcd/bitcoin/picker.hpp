@@ -8,6 +8,7 @@
 #ifndef ABCD_BITCOIN_PICKER_HPP
 #define ABCD_BITCOIN_PICKER_HPP
 
+#include "CoinSelect.hpp"
 #include "watcher.hpp"
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/transaction.hpp>
@@ -25,12 +26,18 @@ enum {
 struct unsigned_transaction_type
 {
     bc::transaction_type tx;
+    uint64_t fees;
     int code;
 };
 
+/**
+ * Outputs smaller than this are dust, and get left out of new transactions.
+ */
+constexpr uint64_t min_output = 5430;
+
 struct fee_schedule
 {
-    uint64_t satoshi_per_kb;
+    FeeModel fees;
 };
 
 BC_API bool make_tx(
@@ -18,6 +18,7 @@ using std::placeholders::_2;
 
 constexpr unsigned default_poll = 10000;
 constexpr unsigned priority_poll = 1000;
+constexpr size_t max_batch = 256;
 
 static unsigned watcher_id = 0;
 
@@ -35,7 +36,8 @@ BC_API watcher::~watcher()
 }
 
 BC_API watcher::watcher()
-  : socket_(ctx_, ZMQ_PAIR),
+  : utxo_dirty_(true),
+    socket_(ctx_, ZMQ_PAIR),
     connection_(nullptr)
 {
     std::stringstream name;
@@ -80,6 +82,8 @@ BC_API data_chunk watcher::serialize()
 
 BC_API bool watcher::load(const data_chunk& data)
 {
+    std::lock_guard<std::mutex> lock(utxo_mutex_);
+    utxo_dirty_ = true;
     return db_.load(data);
 }
 
@@ -88,6 +92,12 @@ BC_API void watcher::watch_address(const payment_address& address, unsigned poll
     auto a = addresses_.find(address);
     if (a != addresses_.end() && a->second == poll_ms)
         return;
+    if (a == addresses_.end())
+    {
+        std::lock_guard<std::mutex> lock(utxo_mutex_);
+        watching_.insert(address);
+        utxo_dirty_ = true;
+    }
     addresses_[address] = poll_ms;
     send_watch_addr(address, poll_ms);
 }
@@ -113,6 +123,8 @@ BC_API transaction_type watcher::find_tx(hash_digest txid)
 /**
  * Sets up the new-transaction callback. This callback will be called from
  * some random thread, so be sure to handle that with a mutex or such.
+ * Transactions that show up together, such as when catching up after
+ * a reconnect, arrive in a single call.
  */
 BC_API void watcher::set_tx_callback(tx_callback cb)
 {
@@ -170,30 +182,86 @@ BC_API output_info_list watcher::get_utxos(const payment_address& address)
 
 /**
  * Returns all the unspent transaction outputs in the wallet.
+ * This takes time proportional to the number of unspent outputs,
+ * not the size of the wallet's history.
  * @param filter true to filter out unconfirmed outputs.
  */
 BC_API output_info_list watcher::get_utxos(bool filter)
 {
-    libwallet::address_set addresses;
-    for (auto& row: addresses_)
-        addresses.insert(row.first);
+    std::lock_guard<std::mutex> lock(utxo_mutex_);
+    if (utxo_dirty_)
+        utxo_rebuild();
+
+    output_info_list out;
+    out.reserve(utxos_.size());
+    for (auto& row: utxos_)
+    {
+        if (!utxo_usable(row.first.first, filter))
+            continue;
+
+        output_info_type utxo;
+        utxo.point.hash = row.first.first;
+        utxo.point.index = row.first.second;
+        utxo.value = row.second;
+        out.push_back(utxo);
+    }
+    return out;
+}
+
+/**
+ * Scans the database for unspent outputs, replacing the cached set.
+ * The caller must hold utxo_mutex_.
+ */
+void watcher::utxo_rebuild()
+{
+    utxos_.clear();
+    spent_.clear();
+    for (auto& utxo: db_.get_utxos(watching_))
+        utxos_[utxo_key(utxo.point.hash, utxo.point.index)] = utxo.value;
+    utxo_dirty_ = false;
+}
 
-    auto utxos = db_.get_utxos(addresses);
+/**
+ * Updates the cached set for a transaction that just entered the database.
+ * Applying a transaction twice has no effect, and spends are remembered,
+ * so transactions can arrive in any order.
+ * The caller must hold utxo_mutex_.
+ */
+void watcher::utxo_apply(const transaction_type& tx)
+{
+    for (auto& input: tx.inputs)
+    {
+        utxo_key key(input.previous_output.hash, input.previous_output.index);
+        auto i = utxos_.find(key);
+        if (i != utxos_.end())
+            utxos_.erase(i);
+        spent_.insert(key);
+    }
 
-    // Filter out unconfirmed ones:
-    if (filter)
+    auto txid = hash_transaction(tx);
+    for (uint32_t i = 0; i < tx.outputs.size(); ++i)
     {
-        output_info_list out;
-        for (auto& utxo: utxos)
-        {
-            if (db_.get_tx_height(utxo.point.hash) ||
-                db_.is_spend(utxo.point.hash, addresses))
-                out.push_back(utxo);
-        }
-        utxos = std::move(out);
+        payment_address address;
+        if (!extract(address, tx.outputs[i].script) || !watching_.count(address))
+            continue;
+
+        utxo_key key(txid, i);
+        if (spent_.count(key) || utxos_.count(key))
+            continue;
+        utxos_[key] = tx.outputs[i].value;
     }
+}
 
-    return utxos;
+/**
+ * Decides if an output can be spent. Unconfirmed outputs are only
+ * usable if they are change from one of our own transactions.
+ * The caller must hold utxo_mutex_.
+ */
+bool watcher::utxo_usable(const hash_digest& txid, bool filter)
+{
+    return !filter ||
+        db_.get_tx_height(txid) ||
+        db_.is_spend(txid, watching_);
 }
 
 BC_API size_t watcher::get_last_block_height()
@@ -257,6 +325,10 @@ BC_API void watcher::loop()
             if (next_wakeup.count())
                 delay = next_wakeup.count();
         }
+        // Hold new transactions until the sockets go quiet,
+        // so a burst of them reaches the callback as one batch:
+        if (!added_.empty())
+            delay = 0;
         if (zmq_poll(items.data(), items.size(), delay) < 0)
             switch (errno)
             {
@@ -274,6 +346,10 @@ BC_API void watcher::loop()
             if (!command(static_cast<uint8_t*>(msg.data()), msg.size()))
                 done = true;
         }
+
+        bool idle = !items[0].revents && !(1 < items.size() && items[1].revents);
+        if (idle || done || max_batch <= added_.size())
+            flush_added();
     }
     delete connection_;
 }
@@ -392,15 +468,39 @@ bool watcher::command(uint8_t* data, size_t size)
     }
 }
 
-void watcher::on_add(const transaction_type& tx)
+void watcher::flush_added()
 {
+    if (added_.empty())
+        return;
+
+    std::vector<transaction_type> added;
+    added.swap(added_);
+
     std::lock_guard<std::mutex> lock(cb_mutex_);
     if (cb_)
-        cb_(tx);
+        cb_(added);
+}
+
+void watcher::on_add(const transaction_type& tx)
+{
+    {
+        // A dirty set gets rebuilt from the database, which has this already:
+        std::lock_guard<std::mutex> lock(utxo_mutex_);
+        if (!utxo_dirty_)
+            utxo_apply(tx);
+    }
+    added_.push_back(tx);
 }
 
 void watcher::on_height(size_t height)
 {
+    {
+        // The database confirms and drops transactions around new blocks
+        // without telling us, so catch up on the next query:
+        std::lock_guard<std::mutex> lock(utxo_mutex_);
+        utxo_dirty_ = true;
+    }
+
     std::lock_guard<std::mutex> lock(cb_mutex_);
     if (height_cb_)
         height_cb_(height);
@@ -12,7 +12,10 @@
 #include <bitcoin/client.hpp>
 #include <zmq.hpp>
 #include <iostream>
+#include <map>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 namespace abcd {
 
@@ -50,7 +53,7 @@ public:
     BC_API size_t get_last_block_height();
 
     // - Callbacks: --------------------
-    typedef std::function<void (const bc::transaction_type&)> tx_callback;
+    typedef std::function<void (const std::vector<bc::transaction_type>&)> tx_callback;
     BC_API void set_tx_callback(tx_callback cb);
 
     typedef std::function<void (std::error_code, const bc::transaction_type&)> tx_sent_callback;
@@ -100,6 +103,19 @@ private:
     std::unordered_map<bc::payment_address, unsigned> addresses_;
     bc::payment_address priority_address_;
 
+    // Unspent outputs, updated as transactions arrive.
+    // Events the database doesn't report, like confirmations,
+    // are picked up by rescanning after each new block:
+    typedef std::pair<bc::hash_digest, uint32_t> utxo_key;
+    std::mutex utxo_mutex_;
+    libwallet::address_set watching_;
+    std::map<utxo_key, uint64_t> utxos_;
+    std::set<utxo_key> spent_;
+    bool utxo_dirty_;
+    void utxo_rebuild();
+    void utxo_apply(const bc::transaction_type& tx);
+    bool utxo_usable(const bc::hash_digest& txid, bool filter);
+
     // Socket for talking to the thread:
     std::mutex socket_mutex_;
     std::string socket_name_;
@@ -133,6 +149,10 @@ private:
     };
     connection* connection_;
 
+    // New transactions waiting to go out as one batch:
+    std::vector<bc::transaction_type> added_;
+    void flush_added();
+
     bool command(uint8_t* data, size_t size);
 
     // tx_callbacks interface:
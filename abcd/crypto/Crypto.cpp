@@ -33,11 +33,18 @@
 #include "Encoding.hpp"
 #include "Random.hpp"
 #include "../json/JsonFile.hpp"
+#include "../util/FileIO.hpp"
+#include "../util/SecureData.hpp"
 #include "../util/Util.hpp"
+#include "../util/WorkerPool.hpp"
 #include <bitcoin/bitcoin.hpp> // wow! such slow, very compile time
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include <openssl/sha.h>
+#include <sys/stat.h>
+#include <list>
+#include <memory>
+#include <mutex>
 
 namespace abcd {
 
@@ -45,30 +52,124 @@ namespace abcd {
 #define JSON_ENC_IV_FIELD       "iv_hex"
 #define JSON_ENC_DATA_FIELD     "data_base64"
 
+#define FILE_CACHE_SIZE         64
+#define CONTEXT_POOL_SIZE       16
+
+/**
+ * A decrypted file, along with enough about the file and key
+ * to tell if it is still valid.
+ */
+struct FileCacheEntry
+{
+    std::string path;
+    ino_t inode;
+    time_t mtime;
+    off_t size;
+    DataArray<SHA256_DIGEST_LENGTH> keyId;
+    SecureChunk data;   // Locked in memory, and wiped when freed
+};
+
+// Most-recently used first:
+static std::list<FileCacheEntry> gFileCache;
+static std::mutex gFileCacheMutex;
+
+/**
+ * Reusable OpenSSL state, so each call doesn't need to set up its own.
+ * The scratch buffer holds plaintext between uses, so it is wiped
+ * after each one, but it keeps its storage.
+ */
+struct CryptoContext
+{
+    EVP_CIPHER_CTX *cipher;
+    EVP_MD_CTX *digest;
+    DataChunk scratch;
+
+    CryptoContext():
+        cipher(EVP_CIPHER_CTX_new()),
+        digest(EVP_MD_CTX_create())
+    {}
+
+    ~CryptoContext()
+    {
+        ABC_UtilGuaranteedMemset(scratch.data(), 0, scratch.size());
+        if (cipher) EVP_CIPHER_CTX_free(cipher);
+        if (digest) EVP_MD_CTX_destroy(digest);
+    }
+};
+
+// Idle contexts:
+static std::vector<std::unique_ptr<CryptoContext>> gContexts;
+static std::mutex gContextMutex;
+
+/**
+ * Borrows an idle context for as long as this object lives.
+ * Every thread doing crypto at the same time gets its own,
+ * and the pool settles at about one per thread.
+ */
+class AutoCryptoContext
+{
+public:
+    AutoCryptoContext()
+    {
+        std::lock_guard<std::mutex> lock(gContextMutex);
+        if (gContexts.empty())
+        {
+            context_.reset(new CryptoContext());
+        }
+        else
+        {
+            context_ = std::move(gContexts.back());
+            gContexts.pop_back();
+        }
+    }
+
+    ~AutoCryptoContext()
+    {
+        std::lock_guard<std::mutex> lock(gContextMutex);
+        if (gContexts.size() < CONTEXT_POOL_SIZE)
+            gContexts.push_back(std::move(context_));
+    }
+
+    CryptoContext &operator*() { return *context_; }
+    CryptoContext *operator->() { return context_.get(); }
+
+private:
+    std::unique_ptr<CryptoContext> context_;
+};
+
+static
+tABC_CC ABC_CryptoEncryptAES256Package(DataSlice  Data,
+                                       DataSlice  Key,
+                                       DataChunk  &EncData,
+                                       DataChunk  &IV,
+                                       tABC_Error *pError);
 static
-tABC_CC ABC_CryptoEncryptAES256Package(const tABC_U08Buf Data,
-                                       const tABC_U08Buf Key,
-                                       tABC_U08Buf       *pEncData,
-                                       DataChunk         &IV,
-                                       tABC_Error        *pError);
+tABC_CC ABC_CryptoDecryptAES256Package(DataSlice  EncData,
+                                       DataSlice  Key,
+                                       DataSlice  IV,
+                                       DataChunk  &Data,
+                                       tABC_Error *pError);
 static
-tABC_CC ABC_CryptoDecryptAES256Package(const tABC_U08Buf EncData,
-                                       const tABC_U08Buf Key,
-                                       const tABC_U08Buf IV,
-                                       tABC_U08Buf       *pData,
-                                       tABC_Error        *pError);
+tABC_CC ABC_CryptoEncryptAES256GCM(DataSlice  Data,
+                                   DataSlice  Key,
+                                   DataChunk  &EncData,
+                                   DataChunk  &IV,
+                                   tABC_Error *pError);
 static
-tABC_CC ABC_CryptoEncryptAES256(const tABC_U08Buf Data,
-                                const tABC_U08Buf Key,
-                                const tABC_U08Buf IV,
-                                tABC_U08Buf       *pEncData,
-                                tABC_Error        *pError);
+tABC_CC ABC_CryptoDecryptAES256GCM(DataSlice  EncData,
+                                   DataSlice  Key,
+                                   DataSlice  IV,
+                                   DataChunk  &Data,
+                                   tABC_Error *pError);
 static
-tABC_CC ABC_CryptoDecryptAES256(const tABC_U08Buf EncData,
-                                const tABC_U08Buf Key,
-                                const tABC_U08Buf IV,
-                                tABC_U08Buf       *pData,
-                                tABC_Error        *pError);
+tABC_CC ABC_CryptoAES256(CryptoContext &ctx,
+                         bool          bEncrypt,
+                         DataSlice     Key,
+                         DataSlice     IV,
+                         DataSlice     In,
+                         uint8_t       *pOut,
+                         size_t        *pOutLength,
+                         tABC_Error    *pError);
 
 std::string
 cryptoFilename(DataSlice key, const std::string &name)
@@ -77,6 +178,102 @@ cryptoFilename(DataSlice key, const std::string &name)
         bc::hmac_sha256_hash(DataSlice(name), key)));
 }
 
+static void
+fileCacheErase(std::list<FileCacheEntry>::iterator i)
+{
+    gFileCache.erase(i);
+}
+
+void
+cryptoFileCacheInvalidate(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(gFileCacheMutex);
+
+    std::string dir = path;
+    if (!dir.empty() && '/' != dir.back())
+        dir += '/';
+
+    for (auto i = gFileCache.begin(); i != gFileCache.end(); )
+    {
+        auto next = std::next(i);
+        if (path.empty() || path == i->path ||
+            0 == i->path.compare(0, dir.size(), dir))
+            fileCacheErase(i);
+        i = next;
+    }
+}
+
+/**
+ * Looks for a decrypted copy of the file, checking that the file
+ * has not changed since then. Fills in the entry's identity either way,
+ * ready for fileCacheInsert.
+ */
+static bool
+fileCacheFind(FileCacheEntry &entry, const char *szFilename, const tABC_U08Buf Key)
+{
+    struct stat info;
+    if (stat(szFilename, &info))
+        return false;
+
+    entry.path = szFilename;
+    entry.inode = info.st_ino;
+    entry.mtime = info.st_mtime;
+    entry.size = info.st_size;
+    SHA256(ABC_BUF_PTR(Key), ABC_BUF_SIZE(Key), entry.keyId.data());
+
+    std::lock_guard<std::mutex> lock(gFileCacheMutex);
+    for (auto i = gFileCache.begin(); i != gFileCache.end(); ++i)
+    {
+        if (i->path != entry.path || i->keyId != entry.keyId)
+            continue;
+
+        if (i->inode != entry.inode || i->mtime != entry.mtime ||
+            i->size != entry.size)
+        {
+            fileCacheErase(i);
+            return false;
+        }
+
+        gFileCache.splice(gFileCache.begin(), gFileCache, i);
+        entry.data = i->data;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Decrypts a file's json into a cache entry. The plaintext only
+ * touches the ordinary heap long enough to be copied out and wiped.
+ */
+static tABC_CC
+fileCacheDecrypt(FileCacheEntry &entry, const json_t *pJSON_Enc,
+                 DataSlice Key, tABC_Error *pError)
+{
+    DataChunk data;
+    tABC_CC cc = ABC_CryptoDecryptJSONObject(pJSON_Enc, Key, data, pError);
+    entry.data.assign(data.begin(), data.end());
+    ABC_UtilGuaranteedMemset(data.data(), 0, data.size());
+    return cc;
+}
+
+static void
+fileCacheInsert(FileCacheEntry &entry)
+{
+    std::lock_guard<std::mutex> lock(gFileCacheMutex);
+
+    for (auto i = gFileCache.begin(); i != gFileCache.end(); ++i)
+    {
+        if (i->path == entry.path && i->keyId == entry.keyId)
+        {
+            fileCacheErase(i);
+            break;
+        }
+    }
+    gFileCache.push_front(entry);
+    if (FILE_CACHE_SIZE < gFileCache.size())
+        fileCacheErase(std::prev(gFileCache.end()));
+}
+
 /**
  * Encrypt data into a jansson object
  */
@@ -89,7 +286,7 @@ tABC_CC ABC_CryptoEncryptJSONObject(const tABC_U08Buf Data,
     tABC_CC cc = ABC_CC_Ok;
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
-    AutoU08Buf     EncData;
+    DataChunk      EncData;
     DataChunk      IV;
     json_t          *jsonRoot       = NULL;
 
@@ -103,7 +300,7 @@ tABC_CC ABC_CryptoEncryptJSONObject(const tABC_U08Buf Data,
         // encrypt
         ABC_CHECK_RET(ABC_CryptoEncryptAES256Package(Data,
                                                      Key,
-                                                     &EncData,
+                                                     EncData,
                                                      IV,
                                                      pError));
 
@@ -111,12 +308,24 @@ tABC_CC ABC_CryptoEncryptJSONObject(const tABC_U08Buf Data,
         jsonRoot = json_pack("{sissss}",
             JSON_ENC_TYPE_FIELD, cryptoType,
             JSON_ENC_IV_FIELD,   base16Encode(IV).c_str(),
-            JSON_ENC_DATA_FIELD, base64Encode(U08Buf(EncData)).c_str());
+            JSON_ENC_DATA_FIELD, base64Encode(EncData).c_str());
 
         // assign our final result
         *ppJSON_Enc = jsonRoot;
         json_incref(jsonRoot);  // because we will decl below
     }
+    else if (cryptoType == ABC_CryptoType_AES256_GCM)
+    {
+        ABC_CHECK_RET(ABC_CryptoEncryptAES256GCM(Data, Key, EncData, IV, pError));
+
+        jsonRoot = json_pack("{sissss}",
+            JSON_ENC_TYPE_FIELD, cryptoType,
+            JSON_ENC_IV_FIELD,   base16Encode(IV).c_str(),
+            JSON_ENC_DATA_FIELD, base64Encode(EncData).c_str());
+
+        *ppJSON_Enc = jsonRoot;
+        json_incref(jsonRoot);
+    }
     else
     {
         ABC_RET_ERROR(ABC_CC_InvalidCryptoType, "Unsupported encryption type");
@@ -147,6 +356,7 @@ tABC_CC ABC_CryptoEncryptJSONFile(const tABC_U08Buf Data,
     ABC_CHECK_NULL(szFilename);
 
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(Data, Key, cryptoType, &root, pError));
+    cryptoFileCacheInvalidate(szFilename);
     ABC_CHECK_NEW(JsonFile(root).save(szFilename), pError);
 
 exit:
@@ -193,19 +403,45 @@ tABC_CC ABC_CryptoDecryptJSONObject(const json_t      *pJSON_Enc,
     tABC_CC cc = ABC_CC_Ok;
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
+    DataChunk data;
+
+    ABC_CHECK_NULL_BUF(Key);
+    ABC_CHECK_NULL(pData);
+
+    ABC_CHECK_RET(ABC_CryptoDecryptJSONObject(pJSON_Enc, DataSlice(Key), data, pError));
+
+    // calloc(0) may return null, so always leave room for a byte:
+    ABC_BUF_NEW(*pData, data.size() + 1);
+    ABC_BUF_SET_PTR(*pData, ABC_BUF_PTR(*pData), data.size());
+    memcpy(ABC_BUF_PTR(*pData), data.data(), data.size());
+
+exit:
+    ABC_UtilGuaranteedMemset(data.data(), 0, data.size());
+
+    return cc;
+}
+
+tABC_CC ABC_CryptoDecryptJSONObject(const json_t *pJSON_Enc,
+                                    DataSlice    Key,
+                                    DataChunk    &Data,
+                                    tABC_Error   *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
     DataChunk data;
     DataChunk iv;
     int type;
     json_t *jsonVal = NULL;
 
     ABC_CHECK_NULL(pJSON_Enc);
-    ABC_CHECK_NULL_BUF(Key);
-    ABC_CHECK_NULL(pData);
+    ABC_CHECK_ASSERT(!Key.empty(), ABC_CC_NULLPtr, "Missing key");
 
     jsonVal = json_object_get(pJSON_Enc, JSON_ENC_TYPE_FIELD);
     ABC_CHECK_ASSERT((jsonVal && json_is_number(jsonVal)), ABC_CC_DecryptError, "Error parsing JSON encrypt package - missing type");
     type = (int) json_integer_value(jsonVal);
-    ABC_CHECK_ASSERT(ABC_CryptoType_AES256 == type, ABC_CC_UnknownCryptoType, "Invalid encryption type");
+    ABC_CHECK_ASSERT(ABC_CryptoType_AES256 == type ||
+        ABC_CryptoType_AES256_GCM == type, ABC_CC_UnknownCryptoType, "Invalid encryption type");
 
     // get the IV
     jsonVal = json_object_get(pJSON_Enc, JSON_ENC_IV_FIELD);
@@ -218,7 +454,14 @@ tABC_CC ABC_CryptoDecryptJSONObject(const json_t      *pJSON_Enc,
     ABC_CHECK_NEW(base64Decode(data, json_string_value(jsonVal)), pError);
 
     // decrypted the data
-    ABC_CHECK_RET(ABC_CryptoDecryptAES256Package(toU08Buf(data), Key, toU08Buf(iv), pData, pError));
+    if (ABC_CryptoType_AES256_GCM == type)
+    {
+        ABC_CHECK_RET(ABC_CryptoDecryptAES256GCM(data, Key, iv, Data, pError));
+    }
+    else
+    {
+        ABC_CHECK_RET(ABC_CryptoDecryptAES256Package(data, Key, iv, Data, pError));
+    }
 
 exit:
     return cc;
@@ -236,13 +479,24 @@ tABC_CC ABC_CryptoDecryptJSONFile(const char *szFilename,
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
     JsonFile json;
+    FileCacheEntry entry;
 
     ABC_CHECK_NULL(szFilename);
     ABC_CHECK_NULL_BUF(Key);
     ABC_CHECK_NULL(pData);
 
+    // The same small files get read over and over:
+    if (fileCacheFind(entry, szFilename, Key))
+    {
+        ABC_BUF_DUP_PTR(*pData, entry.data.data(), entry.data.size());
+        goto exit;
+    }
+
     ABC_CHECK_NEW(json.load(szFilename), pError);
-    ABC_CHECK_RET(ABC_CryptoDecryptJSONObject(json.root(), Key, pData, pError));
+    ABC_CHECK_RET(fileCacheDecrypt(entry, json.root(), DataSlice(Key), pError));
+    ABC_BUF_DUP_PTR(*pData, entry.data.data(), entry.data.size());
+    if (!entry.path.empty())
+        fileCacheInsert(entry);
 
 exit:
     return cc;
@@ -278,6 +532,136 @@ exit:
     return cc;
 }
 
+/**
+ * Per-job scratch space for ABC_CryptoDecryptJSONBatch.
+ */
+struct DecryptWork
+{
+    FileCacheEntry entry;   // Plaintext ends up in entry.data
+    bool cached = false;
+    std::string encrypted;
+    tABC_CC cc = ABC_CC_Ok;
+    tABC_Error error;
+};
+
+/**
+ * Fetches a batch job's encrypted json, or its cached plaintext.
+ * This touches the filesystem, so it runs on the calling thread.
+ */
+static
+tABC_CC ABC_CryptoDecryptBatchRead(const DecryptJob &job,
+                                   DecryptWork &work,
+                                   tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    DataChunk data;
+
+    ABC_CHECK_NULL_BUF(job.key);
+
+    if (!job.encrypted.empty())
+    {
+        work.encrypted = job.encrypted;
+    }
+    else if (fileCacheFind(work.entry, job.filename.c_str(), job.key))
+    {
+        work.cached = true;
+    }
+    else
+    {
+        ABC_CHECK_NEW(fileLoad(data, job.filename), pError);
+        work.encrypted = toString(data);
+    }
+
+exit:
+    return cc;
+}
+
+/**
+ * Decrypts and parses one batch job. This is safe to run on any thread.
+ */
+static
+tABC_CC ABC_CryptoDecryptBatchJob(DecryptJob &job,
+                                  DecryptWork &work,
+                                  tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    JsonFile encrypted;
+    JsonFile file;
+
+    if (!work.cached)
+    {
+        ABC_CHECK_NEW(encrypted.decode(work.encrypted), pError);
+        ABC_CHECK_RET(fileCacheDecrypt(work.entry, encrypted.root(), DataSlice(job.key), pError));
+    }
+    ABC_CHECK_NEW(file.decode(toString(work.entry.data)), pError);
+    job.result = json_incref(file.root());
+
+exit:
+    return cc;
+}
+
+tABC_CC ABC_CryptoDecryptJSONBatch(std::vector<DecryptJob> &jobs,
+                                   tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    std::vector<DecryptWork> works(jobs.size());
+
+    // The callers often hold the file lock, so do all the reading here:
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        jobs[i].result = nullptr;
+        works[i].cc = ABC_CryptoDecryptBatchRead(jobs[i], works[i], &works[i].error);
+    }
+
+    workerPoolRun(jobs.size(), [&](size_t i)
+    {
+        if (ABC_CC_Ok == works[i].cc)
+            works[i].cc = ABC_CryptoDecryptBatchJob(jobs[i], works[i], &works[i].error);
+    });
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (ABC_CC_Ok != works[i].cc)
+        {
+            if (pError)
+                *pError = works[i].error;
+            cc = works[i].cc;
+            goto exit;
+        }
+        if (!works[i].cached && !works[i].entry.path.empty())
+            fileCacheInsert(works[i].entry);
+    }
+
+exit:
+    if (ABC_CC_Ok != cc)
+    {
+        for (auto &job: jobs)
+        {
+            if (job.result) json_decref(job.result);
+            job.result = nullptr;
+        }
+    }
+
+    return cc;
+}
+
+/**
+ * Copies a key or IV into a fixed-size buffer,
+ * zero-padding or truncating it as needed.
+ */
+static void
+padData(uint8_t *out, size_t size, DataSlice in)
+{
+    memset(out, 0, size);
+    memcpy(out, in.data(), std::min(size, in.size()));
+}
+
 /**
  * Creates an encrypted aes256 package that includes data, random header/footer and sha256
  * Package format:
@@ -290,108 +674,94 @@ exit:
  *   32 bytes:   32 bytes SHA256 of all data up to this point
  */
 static
-tABC_CC ABC_CryptoEncryptAES256Package(const tABC_U08Buf Data,
-                                       const tABC_U08Buf Key,
-                                       tABC_U08Buf       *pEncData,
-                                       DataChunk         &IV,
-                                       tABC_Error        *pError)
+tABC_CC ABC_CryptoEncryptAES256Package(DataSlice  Data,
+                                       DataSlice  Key,
+                                       DataChunk  &EncData,
+                                       DataChunk  &IV,
+                                       tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
-    DataChunk headerData;
-    DataChunk footerData;
-    AutoU08Buf UnencryptedData;
+    AutoCryptoContext ctx;
+    DataChunk sizes;
+    DataChunk padding;
     unsigned char nRandomHeaderBytes;
     unsigned char nRandomFooterBytes;
-    unsigned long totalSizeUnencrypted = 0;
-    unsigned char *pCurUnencryptedData = NULL;
-    unsigned char nSizeByte = 0;
-    unsigned char sha256Output[SHA256_DIGEST_LENGTH];
+    size_t totalSizeUnencrypted = 0;
+    size_t encLength = 0;
+    unsigned int digestLength = 0;
+    unsigned char *pCur = NULL;
 
-    ABC_CHECK_NULL_BUF(Data);
-    ABC_CHECK_NULL_BUF(Key);
-    ABC_CHECK_NULL(pEncData);
+    ABC_CHECK_ASSERT(!Key.empty(), ABC_CC_NULLPtr, "Missing key");
+    ABC_CHECK_ASSERT(ctx->digest, ABC_CC_EncryptError, "Cannot create digest context");
 
     // create a random IV
     ABC_CHECK_NEW(randomData(IV, AES_256_IV_LENGTH), pError);
 
-    // create a random number of header bytes 0-255
-    {
-        DataChunk r;
-        ABC_CHECK_NEW(randomData(r, 1), pError);
-        nRandomHeaderBytes = r[0];
-    }
-    //printf("rand header count: %d\n", nRandomHeaderBytes);
-    ABC_CHECK_NEW(randomData(headerData, nRandomHeaderBytes), pError);
-
-    // create a random number of footer bytes 0-255
-    {
-        DataChunk r;
-        ABC_CHECK_NEW(randomData(r, 1), pError);
-        nRandomFooterBytes = r[0];
-    }
-    //printf("rand footer count: %d\n", nRandomFooterBytes);
-    ABC_CHECK_NEW(randomData(footerData, nRandomFooterBytes), pError);
+    // create a random number of header and footer bytes, 0-255 each
+    ABC_CHECK_NEW(randomData(sizes, 2), pError);
+    nRandomHeaderBytes = sizes[0];
+    nRandomFooterBytes = sizes[1];
+    ABC_CHECK_NEW(randomData(padding, nRandomHeaderBytes + nRandomFooterBytes), pError);
 
     // calculate the size of our unencrypted buffer
     totalSizeUnencrypted += 1; // header count
     totalSizeUnencrypted += nRandomHeaderBytes; // header
     totalSizeUnencrypted += 4; // space to hold data size
-    totalSizeUnencrypted += ABC_BUF_SIZE(Data); // data
+    totalSizeUnencrypted += Data.size(); // data
     totalSizeUnencrypted += 1; // footer count
     totalSizeUnencrypted += nRandomFooterBytes; // footer
     totalSizeUnencrypted += SHA256_DIGEST_LENGTH; // sha256
-    //printf("total size unencrypted: %lu\n", (unsigned long) totalSizeUnencrypted);
 
-    // allocate the unencrypted buffer
-    ABC_BUF_NEW(UnencryptedData, totalSizeUnencrypted);
-    pCurUnencryptedData = ABC_BUF_PTR(UnencryptedData);
+    // build the package in the context's scratch space
+    ctx->scratch.resize(totalSizeUnencrypted);
+    pCur = ctx->scratch.data();
 
     // add the random header count and bytes
-    memcpy(pCurUnencryptedData, &nRandomHeaderBytes, 1);
-    pCurUnencryptedData += 1;
-    memcpy(pCurUnencryptedData, headerData.data(), headerData.size());
-    pCurUnencryptedData += nRandomHeaderBytes;
+    *pCur++ = nRandomHeaderBytes;
+    memcpy(pCur, padding.data(), nRandomHeaderBytes);
+    pCur += nRandomHeaderBytes;
 
     // add the size of the data
-    nSizeByte = (ABC_BUF_SIZE(Data) >> 24) & 0xff;
-    memcpy(pCurUnencryptedData, &nSizeByte, 1);
-    pCurUnencryptedData += 1;
-    nSizeByte = (ABC_BUF_SIZE(Data) >> 16) & 0xff;
-    memcpy(pCurUnencryptedData, &nSizeByte, 1);
-    pCurUnencryptedData += 1;
-    nSizeByte = (ABC_BUF_SIZE(Data) >> 8) & 0xff;
-    memcpy(pCurUnencryptedData, &nSizeByte, 1);
-    pCurUnencryptedData += 1;
-    nSizeByte = (ABC_BUF_SIZE(Data) >> 0) & 0xff;
-    memcpy(pCurUnencryptedData, &nSizeByte, 1);
-    pCurUnencryptedData += 1;
+    *pCur++ = (Data.size() >> 24) & 0xff;
+    *pCur++ = (Data.size() >> 16) & 0xff;
+    *pCur++ = (Data.size() >> 8) & 0xff;
+    *pCur++ = (Data.size() >> 0) & 0xff;
 
     // add the data
-    memcpy(pCurUnencryptedData, ABC_BUF_PTR(Data), ABC_BUF_SIZE(Data));
-    pCurUnencryptedData += ABC_BUF_SIZE(Data);
+    memcpy(pCur, Data.data(), Data.size());
+    pCur += Data.size();
 
     // add the random footer count and bytes
-    memcpy(pCurUnencryptedData, &nRandomFooterBytes, 1);
-    pCurUnencryptedData += 1;
-    memcpy(pCurUnencryptedData, footerData.data(), footerData.size());
-    pCurUnencryptedData += nRandomFooterBytes;
+    *pCur++ = nRandomFooterBytes;
+    memcpy(pCur, padding.data() + nRandomHeaderBytes, nRandomFooterBytes);
+    pCur += nRandomFooterBytes;
 
     // add the sha256
-    SHA256(ABC_BUF_PTR(UnencryptedData), totalSizeUnencrypted - SHA256_DIGEST_LENGTH, sha256Output);
-    memcpy(pCurUnencryptedData, sha256Output, SHA256_DIGEST_LENGTH);
-    pCurUnencryptedData += SHA256_DIGEST_LENGTH;
-
-    // encrypted our new unencrypted package
-    ABC_CHECK_RET(ABC_CryptoEncryptAES256(UnencryptedData, Key, toU08Buf(IV), pEncData, pError));
+    ABC_CHECK_ASSERT(
+        EVP_DigestInit_ex(ctx->digest, EVP_sha256(), NULL) &&
+        EVP_DigestUpdate(ctx->digest, ctx->scratch.data(), pCur - ctx->scratch.data()) &&
+        EVP_DigestFinal_ex(ctx->digest, pCur, &digestLength),
+        ABC_CC_EncryptError, "SHA256 failed");
+
+    // encrypt our new unencrypted package
+    // (max ciphertext len for n bytes of plaintext is n + AES_256_BLOCK_LENGTH)
+    EncData.resize(totalSizeUnencrypted + AES_256_BLOCK_LENGTH);
+    ABC_CHECK_RET(ABC_CryptoAES256(*ctx, true, Key, IV, ctx->scratch,
+        EncData.data(), &encLength, pError));
+    EncData.resize(encLength);
 
 exit:
+    ABC_UtilGuaranteedMemset(ctx->scratch.data(), 0, ctx->scratch.size());
+
     return cc;
 }
 
 /**
  * Decrypts an encrypted aes256 package which includes data, random header/footer and sha256
+ * The package is decrypted in place in the output buffer,
+ * and the data is then moved to the front, so there are no extra copies.
  * Note: it is critical that this function returns ABC_CC_DecryptFailure if there is an issue
  *       because code is counting on this specific error to know a key is bad
  * Package format:
@@ -404,33 +774,37 @@ exit:
  *   32 bytes:   32 bytes SHA256 of all data up to this point
  */
 static
-tABC_CC ABC_CryptoDecryptAES256Package(const tABC_U08Buf EncData,
-                                       const tABC_U08Buf Key,
-                                       const tABC_U08Buf IV,
-                                       tABC_U08Buf       *pData,
-                                       tABC_Error        *pError)
+tABC_CC ABC_CryptoDecryptAES256Package(DataSlice  EncData,
+                                       DataSlice  Key,
+                                       DataSlice  IV,
+                                       DataChunk  &Data,
+                                       tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
-    AutoU08Buf Data;
+    AutoCryptoContext ctx;
+    size_t length = 0;
     unsigned char headerLength;
-    unsigned int minSize;
+    size_t minSize;
     unsigned char *pDataLengthPos;
-    unsigned int dataSecLength;
+    unsigned int dataSecLength = 0;
     unsigned char footerLength;
-    unsigned int shaCheckLength;
+    size_t shaCheckLength;
     unsigned char *pSHALoc;
     unsigned char sha256Output[SHA256_DIGEST_LENGTH];
-    unsigned char *pFinalDataPos;
+    unsigned int digestLength = 0;
 
-    ABC_CHECK_NULL_BUF(EncData);
-    ABC_CHECK_NULL_BUF(Key);
-    ABC_CHECK_NULL_BUF(IV);
-    ABC_CHECK_NULL(pData);
+    ABC_CHECK_ASSERT(!EncData.empty(), ABC_CC_NULLPtr, "Missing encrypted data");
+    ABC_CHECK_ASSERT(!Key.empty(), ABC_CC_NULLPtr, "Missing key");
+    ABC_CHECK_ASSERT(!IV.empty(), ABC_CC_NULLPtr, "Missing IV");
+    ABC_CHECK_ASSERT(ctx->digest, ABC_CC_DecryptError, "Cannot create digest context");
 
     // start by decrypting the pacakge
-    if (ABC_CC_Ok != ABC_CryptoDecryptAES256(EncData, Key, IV, &Data, pError))
+    // (because we have padding ON, we must allocate an extra cipher block size of memory)
+    Data.resize(EncData.size() + AES_256_BLOCK_LENGTH);
+    if (ABC_CC_Ok != ABC_CryptoAES256(*ctx, false, Key, IV, EncData,
+        Data.data(), &length, pError))
     {
         cc = ABC_CC_DecryptFailure;
         if (pError)
@@ -439,41 +813,43 @@ tABC_CC ABC_CryptoDecryptAES256Package(const tABC_U08Buf EncData,
         }
         goto exit;
     }
+    ABC_CHECK_ASSERT(0 < length, ABC_CC_DecryptFailure, "Decrypted data is not long enough");
 
     // get the size of the random header section
-    headerLength = *ABC_BUF_PTR(Data);
+    headerLength = Data[0];
 
     // check that we have enough data based upon this info
     minSize = 1 + headerLength + 4 + 1 + 1 + SHA256_DIGEST_LENGTH; // decrypted package must be at least this big
-    ABC_CHECK_ASSERT(ABC_BUF_SIZE(Data) >= minSize, ABC_CC_DecryptFailure, "Decrypted data is not long enough");
+    ABC_CHECK_ASSERT(length >= minSize, ABC_CC_DecryptFailure, "Decrypted data is not long enough");
 
     // get the size of the data section
-    pDataLengthPos = ABC_BUF_PTR(Data) + (1 + headerLength);
-    dataSecLength = ((unsigned int) *pDataLengthPos) << 24;
-    pDataLengthPos++;
-    dataSecLength += ((unsigned int) *pDataLengthPos) << 16;
-    pDataLengthPos++;
-    dataSecLength += ((unsigned int) *pDataLengthPos) << 8;
-    pDataLengthPos++;
-    dataSecLength += ((unsigned int) *pDataLengthPos);
+    pDataLengthPos = Data.data() + (1 + headerLength);
+    dataSecLength = ((unsigned int) pDataLengthPos[0]) << 24;
+    dataSecLength += ((unsigned int) pDataLengthPos[1]) << 16;
+    dataSecLength += ((unsigned int) pDataLengthPos[2]) << 8;
+    dataSecLength += ((unsigned int) pDataLengthPos[3]);
 
     // check that we have enough data based upon this info
-    minSize = 1 + headerLength + 4 + dataSecLength + 1 + SHA256_DIGEST_LENGTH; // decrypted package must be at least this big
-    ABC_CHECK_ASSERT(ABC_BUF_SIZE(Data) >= minSize, ABC_CC_DecryptFailure, "Decrypted data is not long enough");
+    minSize = 1 + headerLength + 4 + (size_t)dataSecLength + 1 + SHA256_DIGEST_LENGTH; // decrypted package must be at least this big
+    ABC_CHECK_ASSERT(length >= minSize, ABC_CC_DecryptFailure, "Decrypted data is not long enough");
 
     // get the size of the random footer section
-    footerLength = *(ABC_BUF_PTR(Data) + 1 + headerLength + 4 + dataSecLength);
+    footerLength = Data[1 + headerLength + 4 + dataSecLength];
 
     // check that we have enough data based upon this info
-    minSize = 1 + headerLength + 4 + dataSecLength + 1 + footerLength + SHA256_DIGEST_LENGTH; // decrypted package must be at least this big
-    ABC_CHECK_ASSERT(ABC_BUF_SIZE(Data) >= minSize, ABC_CC_DecryptFailure, "Decrypted data is not long enough");
+    minSize = 1 + headerLength + 4 + (size_t)dataSecLength + 1 + footerLength + SHA256_DIGEST_LENGTH; // decrypted package must be at least this big
+    ABC_CHECK_ASSERT(length >= minSize, ABC_CC_DecryptFailure, "Decrypted data is not long enough");
 
     // set up for the SHA check
     shaCheckLength = 1 + headerLength + 4 + dataSecLength + 1 + footerLength; // all but the sha
-    pSHALoc = ABC_BUF_PTR(Data) + shaCheckLength;
+    pSHALoc = Data.data() + shaCheckLength;
 
     // calc the sha256
-    SHA256(ABC_BUF_PTR(Data), shaCheckLength, sha256Output);
+    ABC_CHECK_ASSERT(
+        EVP_DigestInit_ex(ctx->digest, EVP_sha256(), NULL) &&
+        EVP_DigestUpdate(ctx->digest, Data.data(), shaCheckLength) &&
+        EVP_DigestFinal_ex(ctx->digest, sha256Output, &digestLength),
+        ABC_CC_DecryptError, "SHA256 failed");
 
     // check the sha256
     if (0 != memcmp(pSHALoc, sha256Output, SHA256_DIGEST_LENGTH))
@@ -482,150 +858,169 @@ tABC_CC ABC_CryptoDecryptAES256Package(const tABC_U08Buf EncData,
         ABC_RET_ERROR(ABC_CC_DecryptFailure, "Decrypted data failed checksum (SHA) check");
     }
 
-    // all is good, so create the final data
-    pFinalDataPos = ABC_BUF_PTR(Data) + 1 + headerLength + 4;
-    ABC_BUF_NEW(*pData, dataSecLength);
-    memcpy(ABC_BUF_PTR(*pData), pFinalDataPos, dataSecLength);
+    // all is good, so slide the data to the front
+    memmove(Data.data(), Data.data() + 1 + headerLength + 4, dataSecLength);
 
 exit:
+    // wipe everything past the data, which is all of it on failure
+    if (ABC_CC_Ok != cc)
+        dataSecLength = 0;
+    ABC_UtilGuaranteedMemset(Data.data() + dataSecLength, 0, Data.size() - dataSecLength);
+    Data.resize(dataSecLength);
+
     return cc;
 }
 
 /**
- * Encrypts the given data with AES256
+ * Encrypts the given data with AES256 in GCM mode.
+ * The output is the ciphertext followed by the authentication tag,
+ * produced in a single pass with no intermediate package.
  */
 static
-tABC_CC ABC_CryptoEncryptAES256(const tABC_U08Buf Data,
-                                const tABC_U08Buf Key,
-                                const tABC_U08Buf IV,
-                                tABC_U08Buf       *pEncData,
-                                tABC_Error        *pError)
+tABC_CC ABC_CryptoEncryptAES256GCM(DataSlice  Data,
+                                   DataSlice  Key,
+                                   DataChunk  &EncData,
+                                   DataChunk  &IV,
+                                   tABC_Error *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
+    AutoCryptoContext ctx;
     unsigned char aKey[AES_256_KEY_LENGTH];
-    unsigned int keyLength = ABC_BUF_SIZE(Key);
-    unsigned char aIV[AES_256_IV_LENGTH];
-    unsigned int IVLength;
-    int c_len;
+    int c_len = 0;
     int f_len = 0;
-    unsigned char *pTmpEncData = NULL;
 
-    ABC_CHECK_NULL_BUF(Data);
-    ABC_CHECK_NULL_BUF(Key);
-    ABC_CHECK_NULL_BUF(IV);
-    ABC_CHECK_NULL(pEncData);
+    ABC_CHECK_ASSERT(!Key.empty(), ABC_CC_NULLPtr, "Missing key");
 
     // create the final key
-    memset(aKey, 0, AES_256_KEY_LENGTH);
-    if (keyLength > AES_256_KEY_LENGTH)
-    {
-        keyLength = AES_256_KEY_LENGTH;
-    }
-    memcpy(aKey, ABC_BUF_PTR(Key), keyLength);
-
-    // create the IV
-    memset(aIV, 0, AES_256_IV_LENGTH);
-    IVLength = ABC_BUF_SIZE(IV);
-    if (IVLength > AES_256_IV_LENGTH)
-    {
-        IVLength = AES_256_IV_LENGTH;
-    }
-    memcpy(aIV, ABC_BUF_PTR(IV), IVLength);
+    padData(aKey, sizeof(aKey), Key);
+
+    // GCM must never see the same IV twice under one key:
+    ABC_CHECK_NEW(randomData(IV, AES_GCM_IV_LENGTH), pError);
+
+    ABC_CHECK_ASSERT(ctx->cipher, ABC_CC_EncryptError, "Cannot create cipher context");
+    ABC_CHECK_ASSERT(
+        EVP_EncryptInit_ex(ctx->cipher, EVP_aes_256_gcm(), NULL, NULL, NULL) &&
+        EVP_CIPHER_CTX_ctrl(ctx->cipher, EVP_CTRL_GCM_SET_IVLEN, AES_GCM_IV_LENGTH, NULL) &&
+        EVP_EncryptInit_ex(ctx->cipher, NULL, NULL, aKey, IV.data()),
+        ABC_CC_EncryptError, "Cannot set up AES-GCM");
+
+    // GCM is a stream mode, so the ciphertext is exactly as long as the input:
+    EncData.resize(Data.size() + AES_GCM_TAG_LENGTH);
+    ABC_CHECK_ASSERT(
+        EVP_EncryptUpdate(ctx->cipher, EncData.data(), &c_len, Data.data(), Data.size()) &&
+        EVP_EncryptFinal_ex(ctx->cipher, EncData.data() + c_len, &f_len) &&
+        EVP_CIPHER_CTX_ctrl(ctx->cipher, EVP_CTRL_GCM_GET_TAG, AES_GCM_TAG_LENGTH,
+            EncData.data() + c_len + f_len),
+        ABC_CC_EncryptError, "AES-GCM encryption failed");
 
-    // init our cipher text struct
-    EVP_CIPHER_CTX e_ctx;
-    EVP_CIPHER_CTX_init(&e_ctx);
-    EVP_EncryptInit_ex(&e_ctx, EVP_aes_256_cbc(), NULL, aKey, aIV);
-
-    // max ciphertext len for a n bytes of plaintext is n + AES_256_BLOCK_LENGTH -1 bytes
-    c_len = ABC_BUF_SIZE(Data) + AES_256_BLOCK_LENGTH;
-    ABC_ARRAY_NEW(pTmpEncData, c_len, unsigned char);
+exit:
+    ABC_UtilGuaranteedMemset(aKey, 0, AES_256_KEY_LENGTH);
 
-    // allows reusing of 'e' for multiple encryption cycles
-    EVP_EncryptInit_ex(&e_ctx, NULL, NULL, NULL, NULL);
+    return cc;
+}
 
-    // update pTmpEncData, c_len is filled with the length of pTmpEncData generated, dataLength is the size of plaintext in bytes
-    EVP_EncryptUpdate(&e_ctx, pTmpEncData, &c_len, ABC_BUF_PTR(Data), ABC_BUF_SIZE(Data));
+/**
+ * Decrypts and authenticates AES256-GCM data,
+ * writing the plaintext straight into the output buffer.
+ * Note: like the package decoder, this returns ABC_CC_DecryptFailure
+ *       if the key is wrong or the data has been tampered with.
+ */
+static
+tABC_CC ABC_CryptoDecryptAES256GCM(DataSlice  EncData,
+                                   DataSlice  Key,
+                                   DataSlice  IV,
+                                   DataChunk  &Data,
+                                   tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
-    // update pTmpEncData with the final remaining bytes
-    EVP_EncryptFinal_ex(&e_ctx, pTmpEncData + c_len, &f_len);
+    AutoCryptoContext ctx;
+    unsigned char aKey[AES_256_KEY_LENGTH];
+    size_t dataLength = 0;
+    int p_len = 0;
+    int f_len = 0;
 
-    // set final values
-    ABC_BUF_SET_PTR(*pEncData, pTmpEncData, c_len + f_len);
+    ABC_CHECK_ASSERT(!Key.empty(), ABC_CC_NULLPtr, "Missing key");
+    ABC_CHECK_ASSERT(AES_GCM_IV_LENGTH == IV.size(), ABC_CC_DecryptFailure, "Bad AES-GCM IV");
+    ABC_CHECK_ASSERT(AES_GCM_TAG_LENGTH <= EncData.size(), ABC_CC_DecryptFailure, "Encrypted data is not long enough");
+    dataLength = EncData.size() - AES_GCM_TAG_LENGTH;
 
-    EVP_CIPHER_CTX_cleanup(&e_ctx);
+    // create the final key
+    padData(aKey, sizeof(aKey), Key);
+
+    ABC_CHECK_ASSERT(ctx->cipher, ABC_CC_DecryptError, "Cannot create cipher context");
+    ABC_CHECK_ASSERT(
+        EVP_DecryptInit_ex(ctx->cipher, EVP_aes_256_gcm(), NULL, NULL, NULL) &&
+        EVP_CIPHER_CTX_ctrl(ctx->cipher, EVP_CTRL_GCM_SET_IVLEN, AES_GCM_IV_LENGTH, NULL) &&
+        EVP_DecryptInit_ex(ctx->cipher, NULL, NULL, aKey, IV.data()),
+        ABC_CC_DecryptError, "Cannot set up AES-GCM");
+
+    // leave room for a byte, so the output pointer is never null:
+    Data.resize(dataLength + 1);
+    ABC_CHECK_ASSERT(
+        EVP_DecryptUpdate(ctx->cipher, Data.data(), &p_len, EncData.data(), dataLength) &&
+        EVP_CIPHER_CTX_ctrl(ctx->cipher, EVP_CTRL_GCM_SET_TAG, AES_GCM_TAG_LENGTH,
+            const_cast<uint8_t *>(EncData.data()) + dataLength) &&
+        0 < EVP_DecryptFinal_ex(ctx->cipher, Data.data() + p_len, &f_len),
+        ABC_CC_DecryptFailure, "Decrypted data failed authentication");
 
 exit:
+    ABC_UtilGuaranteedMemset(aKey, 0, AES_256_KEY_LENGTH);
+    if (ABC_CC_Ok != cc)
+        dataLength = 0;
+    ABC_UtilGuaranteedMemset(Data.data() + dataLength, 0, Data.size() - dataLength);
+    Data.resize(dataLength);
 
     return cc;
 }
 
 /**
- * Decrypts the given data with AES256
+ * Runs AES256-CBC in either direction.
+ *
+ * @param pOut          Output buffer, with room for the input plus one block
+ * @param pOutLength    Set to the number of bytes written
  */
 static
-tABC_CC ABC_CryptoDecryptAES256(const tABC_U08Buf EncData,
-                                const tABC_U08Buf Key,
-                                const tABC_U08Buf IV,
-                                tABC_U08Buf       *pData,
-                                tABC_Error        *pError)
+tABC_CC ABC_CryptoAES256(CryptoContext &ctx,
+                         bool          bEncrypt,
+                         DataSlice     Key,
+                         DataSlice     IV,
+                         DataSlice     In,
+                         uint8_t       *pOut,
+                         size_t        *pOutLength,
+                         tABC_Error    *pError)
 {
     tABC_CC cc = ABC_CC_Ok;
     ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
 
-    unsigned char *pTmpData = NULL;
-    int p_len, f_len;
-    unsigned int IVLength;
-    unsigned int keyLength;
-
-    ABC_CHECK_NULL_BUF(EncData);
-    ABC_CHECK_NULL_BUF(Key);
-    ABC_CHECK_NULL_BUF(IV);
-    ABC_CHECK_NULL(pData);
-
-    // create the final key
     unsigned char aKey[AES_256_KEY_LENGTH];
-    memset(aKey, 0, AES_256_KEY_LENGTH);
-    keyLength = ABC_BUF_SIZE(Key);
-    if (keyLength > AES_256_KEY_LENGTH)
-    {
-        keyLength = AES_256_KEY_LENGTH;
-    }
-    memcpy(aKey, ABC_BUF_PTR(Key), keyLength);
-
-    // create the IV
     unsigned char aIV[AES_256_IV_LENGTH];
-    memset(aIV, 0, AES_256_IV_LENGTH);
-    IVLength = ABC_BUF_SIZE(IV);
-    if (IVLength > AES_256_IV_LENGTH)
-    {
-        IVLength = AES_256_IV_LENGTH;
-    }
-    memcpy(aIV, ABC_BUF_PTR(IV), IVLength);
-
-    // init our cipher text struct
-    EVP_CIPHER_CTX d_ctx;
-    EVP_CIPHER_CTX_init(&d_ctx);
-    EVP_DecryptInit_ex(&d_ctx, EVP_aes_256_cbc(), NULL, aKey, aIV);
+    tABC_CC failure = bEncrypt ? ABC_CC_EncryptError : ABC_CC_DecryptError;
+    int c_len = 0;
+    int f_len = 0;
 
-    /* because we have padding ON, we must allocate an extra cipher block size of memory */
-    p_len = ABC_BUF_SIZE(EncData);
-    f_len = 0;
-    ABC_ARRAY_NEW(pTmpData, p_len + AES_256_BLOCK_LENGTH, unsigned char);
+    *pOutLength = 0;
 
-    // decrypt
-    EVP_DecryptInit_ex(&d_ctx, NULL, NULL, NULL, NULL);
-    EVP_DecryptUpdate(&d_ctx, pTmpData, &p_len, ABC_BUF_PTR(EncData), ABC_BUF_SIZE(EncData));
-    EVP_DecryptFinal_ex(&d_ctx, pTmpData + p_len, &f_len);
+    // create the final key and IV
+    padData(aKey, sizeof(aKey), Key);
+    padData(aIV, sizeof(aIV), IV);
 
-    EVP_CIPHER_CTX_cleanup(&d_ctx);
+    // EVP picks the hardware AES instructions on its own, if there are any
+    ABC_CHECK_ASSERT(ctx.cipher, failure, "Cannot create cipher context");
+    ABC_CHECK_ASSERT(
+        EVP_CipherInit_ex(ctx.cipher, EVP_aes_256_cbc(), NULL, aKey, aIV, bEncrypt) &&
+        EVP_CipherUpdate(ctx.cipher, pOut, &c_len, In.data(), In.size()) &&
+        EVP_CipherFinal_ex(ctx.cipher, pOut + c_len, &f_len),
+        failure, "AES256 failed");
 
-    // set final values
-    ABC_BUF_SET_PTR(*pData, pTmpData, p_len + f_len);
+    *pOutLength = c_len + f_len;
 
 exit:
+    ABC_UtilGuaranteedMemset(aKey, 0, AES_256_KEY_LENGTH);
+
     return cc;
 }
 
@@ -39,16 +39,21 @@
 #include "../util/Data.hpp"
 #include "../../src/ABC.h"
 #include <jansson.h>
+#include <vector>
 
 namespace abcd {
 
 #define AES_256_IV_LENGTH       16
 #define AES_256_BLOCK_LENGTH    16
 #define AES_256_KEY_LENGTH      32
+#define AES_GCM_IV_LENGTH       12
+#define AES_GCM_TAG_LENGTH      16
 
 typedef enum eABC_CryptoType
 {
     ABC_CryptoType_AES256 = 0,
+    /** Authenticated AES256, without the padding and checksum. */
+    ABC_CryptoType_AES256_GCM = 1,
     ABC_CryptoType_Count
 } tABC_CryptoType;
 
@@ -61,6 +66,16 @@ typedef enum eABC_CryptoType
 std::string
 cryptoFilename(DataSlice key, const std::string &name);
 
+/**
+ * Forgets any cached plaintext for the given file,
+ * or for every file inside it if it is a directory.
+ * An empty path forgets everything.
+ * Anything that changes encrypted files without going through
+ * ABC_CryptoEncryptJSONFile needs to call this.
+ */
+void
+cryptoFileCacheInvalidate(const std::string &path=std::string());
+
 // Encryption:
 tABC_CC ABC_CryptoEncryptJSONObject(const tABC_U08Buf Data,
                                     const tABC_U08Buf Key,
@@ -85,11 +100,41 @@ tABC_CC ABC_CryptoDecryptJSONObject(const json_t      *pJSON_Enc,
                                     tABC_U08Buf       *pData,
                                     tABC_Error        *pError);
 
+/**
+ * Decrypts straight into the caller's buffer, reusing its storage.
+ * This saves an allocation and a copy per call on hot paths.
+ * The buffer is wiped and emptied on failure.
+ */
+tABC_CC ABC_CryptoDecryptJSONObject(const json_t *pJSON_Enc,
+                                    DataSlice    Key,
+                                    DataChunk    &Data,
+                                    tABC_Error   *pError);
+
 tABC_CC ABC_CryptoDecryptJSONFile(const char *szFilename,
                                   const tABC_U08Buf Key,
                                   tABC_U08Buf       *pData,
                                   tABC_Error        *pError);
 
+/**
+ * One item for ABC_CryptoDecryptJSONBatch.
+ */
+struct DecryptJob
+{
+    std::string filename;   // Where to find the encrypted json,
+    std::string encrypted;  // unless it is already here
+    tABC_U08Buf key;
+    json_t *result;         // The decrypted json (caller must json_decref)
+};
+
+/**
+ * Decrypts and parses a batch of files or in-memory objects,
+ * spreading the work over all the available cores.
+ * The results land in the same order as the jobs.
+ * If any job fails, the first failure is returned and no results are kept.
+ */
+tABC_CC ABC_CryptoDecryptJSONBatch(std::vector<DecryptJob> &jobs,
+                                   tABC_Error *pError);
+
 tABC_CC ABC_CryptoDecryptJSONFileObject(const char *szFilename,
                                         const tABC_U08Buf Key,
                                         json_t **ppJSON_Data,
@@ -7,16 +7,18 @@
 
 #include "Encoding.hpp"
 #include <algorithm>
+#include <array>
 
 namespace abcd {
 
 /**
- * Encodes data in an arbitrary power-of-2 base.
+ * Encodes data in an arbitrary power-of-2 base, one bit-group at a time.
+ * This handles any length, but is slow.
  * @param Bytes number of bytes per chunk of characters.
  * @param Chars number of characters per chunk.
  */
 template<unsigned Bytes, unsigned Chars> std::string
-chunkEncode(DataSlice data, const char *alphabet)
+chunkEncodeGeneric(DataSlice data, const char *alphabet)
 {
     std::string out;
     auto chunks = (data.size() + Bytes - 1) / Bytes; // Rounding up
@@ -47,7 +49,8 @@ chunkEncode(DataSlice data, const char *alphabet)
 }
 
 /**
- * Decodes data from an arbitrary power-of-2 base.
+ * Decodes data from an arbitrary power-of-2 base, one bit-group at a time.
+ * This handles padding, but is slow.
  * @param Bytes number of bytes per chunk of characters.
  * @param Chars number of characters per chunk.
  * @param Decode function for converting characters to their values.
@@ -55,7 +58,7 @@ chunkEncode(DataSlice data, const char *alphabet)
  */
 template<unsigned Bytes, unsigned Chars, int Decode(char c)>
 Status
-chunkDecode(DataChunk &result, const std::string &in)
+chunkDecodeGeneric(DataChunk &result, const std::string &in)
 {
     // The string must be a multiple of the chunk size:
     if (in.size() % Chars)
@@ -105,6 +108,108 @@ chunkDecode(DataChunk &result, const std::string &in)
     return Status();
 }
 
+/**
+ * Builds a lookup table from a character-decoding function.
+ */
+template<int Decode(char c)>
+const int8_t *
+decodeTable()
+{
+    static const auto table = []()
+    {
+        std::array<int8_t, 256> out;
+        for (int i = 0; i < 256; ++i)
+            out[i] = Decode(static_cast<char>(i));
+        return out;
+    }();
+    return table.data();
+}
+
+/**
+ * Encodes data in an arbitrary power-of-2 base.
+ * Whole chunks are packed into a single integer and written straight
+ * into place, so only the final, padded chunk takes the slow path.
+ */
+template<unsigned Bytes, unsigned Chars> std::string
+chunkEncode(DataSlice data, const char *alphabet)
+{
+    constexpr unsigned shift = 8 * Bytes / Chars; // Bits per character
+    constexpr unsigned mask = (1 << shift) - 1;
+    auto chunks = data.size() / Bytes; // Rounding down
+
+    std::string out(Chars * chunks, 0);
+    auto i = data.begin();
+    auto o = &out[0];
+    for (size_t n = 0; n < chunks; ++n)
+    {
+        uint64_t chunk = 0;
+        for (unsigned k = 0; k < Bytes; ++k)
+            chunk = chunk << 8 | *i++;
+        for (unsigned k = Chars; k--; )
+        {
+            o[k] = alphabet[chunk & mask];
+            chunk >>= shift;
+        }
+        o += Chars;
+    }
+
+    out += chunkEncodeGeneric<Bytes, Chars>(DataSlice(i, data.end()), alphabet);
+    return out;
+}
+
+/**
+ * Decodes data from an arbitrary power-of-2 base.
+ * Only the last chunk can hold padding, so the ones before it are
+ * decoded a whole chunk at a time, using a lookup table.
+ */
+template<unsigned Bytes, unsigned Chars, int Decode(char c)>
+Status
+chunkDecode(DataChunk &result, const std::string &in)
+{
+    constexpr unsigned shift = 8 * Bytes / Chars; // Bits per character
+
+    // The string must be a multiple of the chunk size:
+    if (in.size() % Chars)
+        return ABC_ERROR(ABC_CC_ParseError, "Bad encoding");
+    if (in.empty())
+        return chunkDecodeGeneric<Bytes, Chars, Decode>(result, in);
+
+    auto table = decodeTable<Decode>();
+    auto chunks = in.size() / Chars - 1;
+
+    DataChunk out(Bytes * chunks);
+    out.reserve(Bytes * (chunks + 1));
+    auto i = reinterpret_cast<const uint8_t *>(in.data());
+    auto o = out.data();
+    for (size_t n = 0; n < chunks; ++n)
+    {
+        uint64_t chunk = 0;
+        int bad = 0; // Goes negative if any character is invalid
+        for (unsigned k = 0; k < Chars; ++k)
+        {
+            int value = table[*i++];
+            bad |= value;
+            chunk = chunk << shift | (value & ((1 << shift) - 1));
+        }
+        if (bad < 0)
+            return ABC_ERROR(ABC_CC_ParseError, "Bad encoding");
+        for (unsigned k = Bytes; k--; )
+        {
+            o[k] = chunk;
+            chunk >>= 8;
+        }
+        o += Bytes;
+    }
+
+    DataChunk last;
+    ABC_CHECK((chunkDecodeGeneric<Bytes, Chars, Decode>(last,
+        in.substr(in.size() - Chars))));
+    out.insert(out.end(), last.begin(), last.end());
+
+    result = std::move(out);
+    return Status();
+}
+
 static int
 base16Decode(char c)
 {
@@ -7,17 +7,46 @@
 
 #include "Random.hpp"
 #include "../util/FileIO.hpp"
+#include "../util/Util.hpp"
 #include <openssl/rand.h>
 #ifndef __ANDROID__
 #include <sys/statvfs.h>
 #endif
 #include <sys/time.h>
 #include <unistd.h>
+#include <mutex>
 
 namespace abcd {
 
 #define UUID_BYTE_COUNT         16
 #define UUID_STR_LENGTH         (UUID_BYTE_COUNT * 2) + 4
+#define RANDOM_POOL_SIZE        4096
+
+/**
+ * Random bytes generated ahead of time, so small requests
+ * don't each need a trip through the OpenSSL generator.
+ * Bytes are wiped as they are handed out.
+ */
+struct RandomPool
+{
+    uint8_t data[RANDOM_POOL_SIZE];
+    size_t used = RANDOM_POOL_SIZE;
+    pid_t pid = 0;
+};
+
+static RandomPool gRandomPool;
+static std::mutex gRandomMutex;
+
+/**
+ * Throws away whatever is left in the pool.
+ * The caller must hold gRandomMutex.
+ */
+static void
+randomPoolFlush()
+{
+    ABC_UtilGuaranteedMemset(gRandomPool.data, 0, RANDOM_POOL_SIZE);
+    gRandomPool.used = RANDOM_POOL_SIZE;
+}
 
 /**
  * Sets the seed for the random number generator
@@ -84,6 +113,12 @@ tABC_CC ABC_CryptoSetRandomSeed(const tABC_U08Buf Seed,
     // seed it
     RAND_seed(ABC_BUF_PTR(NewSeed), ABC_BUF_SIZE(NewSeed));
 
+    // anything generated before the new seed shouldn't be used
+    {
+        std::lock_guard<std::mutex> lock(gRandomMutex);
+        randomPoolFlush();
+    }
+
 exit:
     ABC_FREE_STR(szFileIORootDir);
 
@@ -96,8 +131,40 @@ randomData(DataChunk &result, size_t size)
     DataChunk out;
     out.resize(size);
 
-    if (!RAND_bytes(out.data(), out.size()))
-        return ABC_ERROR(ABC_CC_Error, "Random data generation failed");
+    // Big requests aren't worth buffering:
+    if (RANDOM_POOL_SIZE / 4 < size)
+    {
+        if (!RAND_bytes(out.data(), out.size()))
+            return ABC_ERROR(ABC_CC_Error, "Random data generation failed");
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(gRandomMutex);
+
+        // A forked child must not hand out the same bytes as its parent:
+        pid_t pid = getpid();
+        if (gRandomPool.pid != pid)
+        {
+            randomPoolFlush();
+            RAND_seed(&pid, sizeof(pid));
+            gRandomPool.pid = pid;
+        }
+
+        if (RANDOM_POOL_SIZE - gRandomPool.used < size)
+        {
+            if (!RAND_bytes(gRandomPool.data, RANDOM_POOL_SIZE))
+            {
+                randomPoolFlush();
+                return ABC_ERROR(ABC_CC_Error, "Random data generation failed");
+            }
+            gRandomPool.used = 0;
+        }
+
+        uint8_t *p = gRandomPool.data + gRandomPool.used;
+        memcpy(out.data(), p, size);
+        ABC_UtilGuaranteedMemset(p, 0, size);
+        gRandomPool.used += size;
+    }
 
     result = std::move(out);
     return Status();
@@ -18,6 +18,8 @@ tABC_CC ABC_CryptoSetRandomSeed(const tABC_U08Buf Seed,
 
 /**
  * Generates cryptographically-secure random data.
+ * Small requests are served from a buffer of pre-generated bytes,
+ * which is thrown away after a fork or a call to ABC_CryptoSetRandomSeed.
  */
 Status
 randomData(DataChunk &result, size_t size);
@@ -8,9 +8,23 @@
 #include "Scrypt.hpp"
 #include "Encoding.hpp"
 #include "Random.hpp"
+#include "ScryptCache.hpp"
 #include "../bitcoin/Testnet.hpp"
+#include "../json/JsonObject.hpp"
+#include "../util/FileIO.hpp"
 #include "../../minilibs/scrypt/crypto_scrypt.h"
+#include <string.h>
 #include <sys/time.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+#include <atomic>
+#include <fstream>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 namespace abcd {
 
@@ -33,12 +47,24 @@ namespace abcd {
 
 #define TIMED_SCRYPT_PARAMS        TRUE
 
+#define SCRYPT_CALIBRATION_FILENAME "Scrypt.json"
+
 //
-// Eeewww. Global var. Should we mutex this? It's just a single initialized var at
-// startup. It's never written after that. Only read.
+// Set at startup from the saved calibration, or by benchmarking.
+// Only an explicit re-calibration writes them after that.
 //
-unsigned int g_timedScryptN = SCRYPT_DEFAULT_CLIENT_N;
-unsigned int g_timedScryptR = SCRYPT_DEFAULT_CLIENT_R;
+std::atomic<unsigned int> g_timedScryptN(SCRYPT_DEFAULT_CLIENT_N);
+std::atomic<unsigned int> g_timedScryptR(SCRYPT_DEFAULT_CLIENT_R);
+std::atomic<unsigned int> g_timedScryptTime(0);
+
+struct ScryptCalibrationJson:
+    public JsonObject
+{
+    ABC_JSON_STRING(Hardware, "hardware", "")
+    ABC_JSON_INTEGER(Time, "time", 0)
+    ABC_JSON_INTEGER(N, "n", 0)
+    ABC_JSON_INTEGER(R, "r", 0)
+};
 
 static unsigned char gaS1[] = { 0xb5, 0x86, 0x5f, 0xfb, 0x9f, 0xa7, 0xb3, 0xbf, 0xe4, 0xb2, 0x38, 0x4d, 0x47, 0xce, 0x83, 0x1e, 0xe2, 0x2a, 0x4a, 0x9d, 0x5c, 0x34, 0xc7, 0xef, 0x7d, 0x21, 0x46, 0x7c, 0xc7, 0x58, 0xf8, 0x1b };
 
@@ -46,22 +72,143 @@ static unsigned char gaS1[] = { 0xb5, 0x86, 0x5f, 0xfb, 0x9f, 0xa7, 0xb3, 0xbf,
 // with same login that exist on both testnet and mainnet and don't conflict
 static unsigned char gaS1_testnet[] = { 0xa5, 0x96, 0x3f, 0x3b, 0x9c, 0xa6, 0xb3, 0xbf, 0xe4, 0xb2, 0x36, 0x42, 0x37, 0xfe, 0x87, 0x1e, 0xf2, 0x2a, 0x4a, 0x9d, 0x4c, 0x34, 0xa7, 0xef, 0x3d, 0x21, 0x47, 0x8c, 0xc7, 0x58, 0xf8, 0x1b };
 
-/*
- * Initializes Scrypt paramenters by benchmarking device
+static std::string
+scryptCalibrationPath()
+{
+    return getRootDir() + SCRYPT_CALIBRATION_FILENAME;
+}
+
+/**
+ * Describes the processor, so a saved calibration
+ * can be thrown out if the hardware changes underneath it.
  */
-tABC_CC ABC_InitializeCrypto(tABC_Error        *pError)
+static std::string
+hardwareModel()
 {
-    tABC_CC cc = ABC_CC_Ok;
+    std::string out;
+
+#ifdef __APPLE__
+    char model[256];
+    size_t size = sizeof(model);
+    if (!sysctlbyname("machdep.cpu.brand_string", model, &size, NULL, 0) ||
+        (size = sizeof(model), !sysctlbyname("hw.machine", model, &size, NULL, 0)))
+        out = std::string(model, strnlen(model, size));
+#else
+    // x86 says "model name", while ARM says "Hardware" or "Processor":
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (out.empty() && std::getline(cpuinfo, line))
+    {
+        for (auto key: {"model name", "Hardware", "Processor"})
+        {
+            auto colon = line.find(':');
+            if (0 == line.compare(0, strlen(key), key) &&
+                std::string::npos != colon)
+            {
+                // The value might be blank, in which case keep looking:
+                auto value = line.find_first_not_of(" \t", colon + 1);
+                if (std::string::npos != value)
+                    out = line.substr(value);
+                break;
+            }
+        }
+    }
+#endif
+
+    struct utsname name;
+    if (!uname(&name))
+        out += std::string(" ") + name.machine;
+    // Count the configured cores, not the online ones,
+    // since phones switch cores on and off to save power:
+    out += " x" + std::to_string(sysconf(_SC_NPROCESSORS_CONF));
+    return out;
+}
+
+/**
+ * Chooses the client scrypt parameters,
+ * given the time taken by a run with the default ones.
+ */
+static void
+scryptChooseParams(unsigned int totalTime)
+{
+    unsigned int N = SCRYPT_DEFAULT_CLIENT_N;
+    unsigned int r = SCRYPT_DEFAULT_CLIENT_R;
+
+#ifdef TIMED_SCRYPT_PARAMS
+    if (totalTime >= SCRYPT_TARGET_USECONDS)
+    {
+        // Very slow device.
+        // Do nothing, use default scrypt settings which are lowest we'll go
+    }
+    else if (totalTime >= SCRYPT_TARGET_USECONDS / 8)
+    {
+        // Medium speed device.
+        // Scale R between 1 to 8 assuming linear effect on hashing time.
+        // Don't touch N.
+        r = SCRYPT_TARGET_USECONDS / totalTime;
+    }
+    else if (totalTime > 0)
+    {
+        // Very fast device.
+        r = 8;
+
+        // Need to adjust scryptN to make scrypt even stronger:
+        unsigned int temp = (SCRYPT_TARGET_USECONDS / 8) / totalTime;
+        N = temp - 1 < 32 ? N << (temp - 1) : 0;
+        if (SCRYPT_MAX_CLIENT_N < N || !N)
+        {
+            N = SCRYPT_MAX_CLIENT_N;
+        }
+    }
+#endif
+
+    g_timedScryptN = N;
+    g_timedScryptR = r;
+    g_timedScryptTime = totalTime;
+}
 
+/**
+ * Reads the saved calibration, if it matches this hardware.
+ */
+static Status
+scryptCalibrationLoad()
+{
+    ScryptCalibrationJson json;
+    ABC_CHECK(json.load(scryptCalibrationPath()));
+    ABC_CHECK(json.hasHardware());
+    ABC_CHECK(json.hasTime());
+    ABC_CHECK(json.hasN());
+    ABC_CHECK(json.hasR());
+
+    if (hardwareModel() != json.getHardware())
+        return ABC_ERROR(ABC_CC_Error, "Scrypt calibration is for other hardware");
+
+    // Reject anything the benchmark could not have chosen:
+    json_int_t N = json.getN();
+    json_int_t r = json.getR();
+    if (N < SCRYPT_DEFAULT_CLIENT_N || SCRYPT_MAX_CLIENT_N < N || (N & (N - 1)) ||
+        r < SCRYPT_DEFAULT_CLIENT_R || 8 < r || json.getTime() < 0)
+        return ABC_ERROR(ABC_CC_Error, "Bad scrypt calibration");
+
+    g_timedScryptN = N;
+    g_timedScryptR = r;
+    g_timedScryptTime = json.getTime();
+    return Status();
+}
+
+/**
+ * Times a scrypt run with the default client parameters,
+ * and chooses the real parameters based on that.
+ */
+static Status
+scryptBenchmark()
+{
     struct timeval timerStart;
     struct timeval timerEnd;
-    int totalTime;
+    unsigned int totalTime;
     tABC_U08Buf Salt; // Do not free
     AutoU08Buf temp;
 
-    ABC_DebugLog("%s called", __FUNCTION__);
-
-    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
     if (isTestnet())
     {
         ABC_BUF_SET_PTR(Salt, gaS1_testnet, sizeof(gaS1));
@@ -71,52 +218,76 @@ tABC_CC ABC_InitializeCrypto(tABC_Error        *pError)
         ABC_BUF_SET_PTR(Salt, gaS1, sizeof(gaS1));
     }
     gettimeofday(&timerStart, NULL);
-    ABC_CHECK_RET(ABC_CryptoScrypt(Salt,
+    ABC_CHECK_OLD(ABC_CryptoScrypt(Salt,
                                    Salt,
                                    SCRYPT_DEFAULT_CLIENT_N,
                                    SCRYPT_DEFAULT_CLIENT_R,
                                    SCRYPT_DEFAULT_CLIENT_P,
                                    SCRYPT_DEFAULT_LENGTH,
                                    &temp,
-                                   pError));
+                                   &error));
     gettimeofday(&timerEnd, NULL);
 
     // Totaltime is in uSec
     totalTime = 1000000 * (timerEnd.tv_sec - timerStart.tv_sec);
     totalTime += timerEnd.tv_usec;
     totalTime -= timerStart.tv_usec;
+    scryptChooseParams(totalTime);
 
-#ifdef TIMED_SCRYPT_PARAMS
-    if (totalTime >= SCRYPT_TARGET_USECONDS)
-    {
-        // Very slow device.
-        // Do nothing, use default scrypt settings which are lowest we'll go
-    }
-    else if (totalTime >= SCRYPT_TARGET_USECONDS / 8)
-    {
-        // Medium speed device.
-        // Scale R between 1 to 8 assuming linear effect on hashing time.
-        // Don't touch N.
-        g_timedScryptR = SCRYPT_TARGET_USECONDS / totalTime;
-    }
-    else if (totalTime > 0)
+    return Status();
+}
+
+static Status
+scryptCalibrationSave()
+{
+    ScryptCalibrationJson json;
+    ABC_CHECK(json.setHardware(hardwareModel().c_str()));
+    ABC_CHECK(json.setTime(g_timedScryptTime));
+    ABC_CHECK(json.setN(g_timedScryptN));
+    ABC_CHECK(json.setR(g_timedScryptR));
+    ABC_CHECK(json.save(scryptCalibrationPath()));
+
+    return Status();
+}
+
+Status
+scryptCalibrate()
+{
+    ABC_CHECK(scryptBenchmark());
+    ABC_CHECK(scryptCalibrationSave());
+
+    return Status();
+}
+
+ScryptCalibration
+scryptCalibration()
+{
+    return ScryptCalibration{g_timedScryptTime, g_timedScryptN, g_timedScryptR};
+}
+
+/*
+ * Initializes Scrypt parameters from the saved calibration,
+ * benchmarking the device only if there is none for this hardware.
+ */
+tABC_CC ABC_InitializeCrypto(tABC_Error        *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+
+    ABC_DebugLog("%s called", __FUNCTION__);
+
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+    if (!scryptCalibrationLoad())
     {
-        // Very fast device.
-        g_timedScryptR = 8;
+        ABC_CHECK_NEW(scryptBenchmark(), pError);
 
-        // Need to adjust scryptN to make scrypt even stronger:
-        unsigned int temp = (SCRYPT_TARGET_USECONDS / 8) / totalTime;
-        g_timedScryptN <<= (temp - 1);
-        if (SCRYPT_MAX_CLIENT_N < g_timedScryptN || !g_timedScryptN)
-        {
-            g_timedScryptN = SCRYPT_MAX_CLIENT_N;
-        }
+        // The results are still good, even if saving them isn't:
+        if (!scryptCalibrationSave())
+            ABC_DebugLog("Cannot save scrypt calibration");
     }
-#endif
 
-    ABC_DebugLog("Scrypt timing: %d\n", totalTime);
-    ABC_DebugLog("Scrypt N = %d\n",g_timedScryptN);
-    ABC_DebugLog("Scrypt R = %d\n",g_timedScryptR);
+    ABC_DebugLog("Scrypt timing: %d\n", (unsigned int)g_timedScryptTime);
+    ABC_DebugLog("Scrypt N = %d\n", (unsigned int)g_timedScryptN);
+    ABC_DebugLog("Scrypt R = %d\n", (unsigned int)g_timedScryptR);
 
 exit:
 
@@ -137,6 +308,13 @@ tABC_CC ABC_CryptoScryptSNRP(const tABC_U08Buf     Data,
     ABC_CHECK_NULL(pSNRP);
     ABC_CHECK_NULL(pScryptData);
 
+    // Repeated logins can skip the work, if the cache is on:
+    ABC_BUF_NEW(*pScryptData, SCRYPT_DEFAULT_LENGTH);
+    if (scryptCacheGet(ABC_BUF_PTR(*pScryptData), SCRYPT_DEFAULT_LENGTH,
+                       Data, pSNRP->Salt, pSNRP->N, pSNRP->r, pSNRP->p))
+        goto exit;
+    ABC_BUF_FREE(*pScryptData);
+
     ABC_CHECK_RET(ABC_CryptoScrypt(Data,
                                    pSNRP->Salt,
                                    pSNRP->N,
@@ -145,12 +323,69 @@ tABC_CC ABC_CryptoScryptSNRP(const tABC_U08Buf     Data,
                                    SCRYPT_DEFAULT_LENGTH,
                                    pScryptData,
                                    pError));
+    scryptCacheSet(*pScryptData,
+                   Data, pSNRP->Salt, pSNRP->N, pSNRP->r, pSNRP->p);
 
 exit:
 
     return cc;
 }
 
+/**
+ * Runs several scrypt derivations at once, one thread apiece.
+ * Login often needs two or three keys from the same password,
+ * and scrypt is memory-hard but single-threaded,
+ * so the wall-clock time drops to that of the slowest job.
+ * If any job fails, the first failure is reported.
+ */
+tABC_CC ABC_CryptoScryptSNRPs(std::initializer_list<tABC_CryptoScryptJob> jobs,
+                              tABC_Error *pError)
+{
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    const tABC_CryptoScryptJob *aJobs = jobs.begin();
+    std::vector<tABC_CC> results(jobs.size(), ABC_CC_Ok);
+    std::vector<tABC_Error> errors(jobs.size());
+    std::vector<std::thread> threads;
+    auto run = [&](size_t i)
+    {
+        results[i] = ABC_CryptoScryptSNRP(aJobs[i].Data, aJobs[i].pSNRP,
+                                          aJobs[i].pScryptData, &errors[i]);
+    };
+
+    // The first job runs on this thread, and the rest get their own:
+    for (size_t i = 1; i < jobs.size(); ++i)
+    {
+        try
+        {
+            threads.emplace_back(run, i);
+        }
+        catch (const std::system_error &)
+        {
+            run(i);
+        }
+    }
+    if (jobs.size())
+        run(0);
+    for (auto &thread: threads)
+        thread.join();
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (ABC_CC_Ok != results[i])
+        {
+            if (pError)
+                *pError = errors[i];
+            cc = results[i];
+            goto exit;
+        }
+    }
+
+exit:
+    return cc;
+}
+
 /**
  * Allocate and generate scrypt data given all vars
  */
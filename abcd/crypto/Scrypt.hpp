@@ -8,9 +8,11 @@
 #ifndef ABCD_CRYPTO_SCRYPT_HPP
 #define ABCD_CRYPTO_SCRYPT_HPP
 
+#include "../util/Status.hpp"
 #include "../util/U08Buf.hpp"
 #include "../../src/ABC.h"
 #include <jansson.h>
+#include <initializer_list>
 
 namespace abcd {
 
@@ -22,6 +24,31 @@ typedef struct sABC_CryptoSNRP
     unsigned long   p;
 } tABC_CryptoSNRP;
 
+/**
+ * The cost of scrypt on this device, and the client parameters chosen
+ * to bring it up to the target time.
+ */
+struct ScryptCalibration
+{
+    unsigned int time;  // Microseconds for a default-parameter run
+    unsigned int N;
+    unsigned int r;
+};
+
+/**
+ * Returns the calibration in effect.
+ */
+ScryptCalibration
+scryptCalibration();
+
+/**
+ * Benchmarks scrypt and saves the results to the root directory,
+ * replacing any earlier calibration.
+ * ABC_InitializeCrypto only does this when the hardware changes.
+ */
+Status
+scryptCalibrate();
+
 tABC_CC ABC_InitializeCrypto(tABC_Error        *pError);
 
 tABC_CC ABC_CryptoScryptSNRP(const tABC_U08Buf     Data,
@@ -29,6 +56,19 @@ tABC_CC ABC_CryptoScryptSNRP(const tABC_U08Buf     Data,
                              tABC_U08Buf           *pScryptData,
                              tABC_Error            *pError);
 
+/**
+ * One of several independent key derivations to run together.
+ */
+typedef struct sABC_CryptoScryptJob
+{
+    tABC_U08Buf             Data;
+    const tABC_CryptoSNRP   *pSNRP;
+    tABC_U08Buf             *pScryptData;
+} tABC_CryptoScryptJob;
+
+tABC_CC ABC_CryptoScryptSNRPs(std::initializer_list<tABC_CryptoScryptJob> jobs,
+                              tABC_Error *pError);
+
 tABC_CC ABC_CryptoScrypt(const tABC_U08Buf Data,
                          const tABC_U08Buf Salt,
                          unsigned long     N,
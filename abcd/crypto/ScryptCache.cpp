@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "ScryptCache.hpp"
+#include "Random.hpp"
+#include "../util/Util.hpp"
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <chrono>
+#include <mutex>
+
+namespace abcd {
+
+constexpr size_t cacheSlots = 32;
+constexpr size_t cacheSlotSize = 32;
+constexpr size_t cacheSecretSize = 32;
+
+typedef std::chrono::steady_clock Clock;
+typedef DataArray<32> CacheId;
+
+struct CacheEntry
+{
+    bool used;
+    CacheId id;
+    size_t size;
+    Clock::time_point expires;
+};
+
+/**
+ * The hashing secret and the results share one locked block,
+ * so none of it can end up in swap.
+ */
+struct CacheMemory
+{
+    uint8_t secret[cacheSecretSize];
+    uint8_t slots[cacheSlots][cacheSlotSize];
+};
+
+static std::mutex gCacheMutex;
+static CacheMemory *gCacheMemory = nullptr;
+static size_t gCacheMemorySize = 0;
+static Clock::duration gCacheLifetime;
+static CacheEntry gCacheEntries[cacheSlots];
+
+static void
+cacheWipe(size_t slot)
+{
+    ABC_UtilGuaranteedMemset(gCacheMemory->slots[slot], 0, cacheSlotSize);
+    gCacheEntries[slot].used = false;
+}
+
+static void
+cacheFree()
+{
+    if (gCacheMemory)
+    {
+        ABC_UtilGuaranteedMemset(gCacheMemory, 0, gCacheMemorySize);
+        munlock(gCacheMemory, gCacheMemorySize);
+        free(gCacheMemory);
+        gCacheMemory = nullptr;
+    }
+    for (auto &entry: gCacheEntries)
+        entry.used = false;
+}
+
+/**
+ * Hashes the scrypt inputs under the cache secret.
+ */
+static CacheId
+cacheId(DataSlice data, DataSlice salt,
+        unsigned long N, unsigned long r, unsigned long p)
+{
+    // Hash the password by itself, so it never gets copied anywhere:
+    DataArray<32> inner;
+    HMAC(EVP_sha256(), gCacheMemory->secret, cacheSecretSize,
+        data.data(), data.size(), inner.data(), nullptr);
+
+    // The fixed-size fields on either end keep this unambiguous.
+    // Reserving everything up front means the buffer never moves,
+    // so wiping it at the end leaves no copies of the hash behind:
+    DataChunk message;
+    message.reserve(inner.size() + salt.size() + 3 * 8);
+    message.insert(message.end(), inner.begin(), inner.end());
+    message.insert(message.end(), salt.begin(), salt.end());
+    for (uint64_t param: {N, r, p})
+        for (int shift = 56; 0 <= shift; shift -= 8)
+            message.push_back(param >> shift);
+    ABC_UtilGuaranteedMemset(inner.data(), 0, inner.size());
+
+    CacheId out;
+    HMAC(EVP_sha256(), gCacheMemory->secret, cacheSecretSize,
+        message.data(), message.size(), out.data(), nullptr);
+    ABC_UtilGuaranteedMemset(message.data(), 0, message.size());
+    return out;
+}
+
+Status
+scryptCacheEnable(unsigned seconds)
+{
+    std::lock_guard<std::mutex> lock(gCacheMutex);
+
+    if (!seconds)
+    {
+        cacheFree();
+        return Status();
+    }
+    gCacheLifetime = std::chrono::seconds(seconds);
+    if (gCacheMemory)
+        return Status();
+
+    DataChunk secret;
+    ABC_CHECK(randomData(secret, cacheSecretSize));
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = (sizeof(CacheMemory) + page - 1) / page * page;
+    void *memory;
+    if (posix_memalign(&memory, page, size))
+        return ABC_ERROR(ABC_CC_NULLPtr, "Out of memory");
+    if (mlock(memory, size))
+    {
+        free(memory);
+        return ABC_ERROR(ABC_CC_SysError, "Cannot lock the scrypt cache into memory");
+    }
+    memset(memory, 0, size);
+
+    gCacheMemory = static_cast<CacheMemory *>(memory);
+    gCacheMemorySize = size;
+    memcpy(gCacheMemory->secret, secret.data(), cacheSecretSize);
+    ABC_UtilGuaranteedMemset(secret.data(), 0, secret.size());
+
+    return Status();
+}
+
+void
+scryptCacheClear()
+{
+    std::lock_guard<std::mutex> lock(gCacheMutex);
+
+    if (gCacheMemory)
+        for (size_t i = 0; i < cacheSlots; ++i)
+            cacheWipe(i);
+}
+
+bool
+scryptCacheGet(uint8_t *result, size_t size, DataSlice data,
+               DataSlice salt, unsigned long N, unsigned long r, unsigned long p)
+{
+    std::lock_guard<std::mutex> lock(gCacheMutex);
+
+    if (!gCacheMemory || cacheSlotSize < size)
+        return false;
+
+    const auto id = cacheId(data, salt, N, r, p);
+    const auto now = Clock::now();
+    for (size_t i = 0; i < cacheSlots; ++i)
+    {
+        const auto &entry = gCacheEntries[i];
+        if (!entry.used)
+            continue;
+        if (entry.expires <= now)
+        {
+            cacheWipe(i);
+            continue;
+        }
+        if (size == entry.size && id == entry.id)
+        {
+            memcpy(result, gCacheMemory->slots[i], size);
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+scryptCacheSet(DataSlice result, DataSlice data,
+               DataSlice salt, unsigned long N, unsigned long r, unsigned long p)
+{
+    std::lock_guard<std::mutex> lock(gCacheMutex);
+
+    if (!gCacheMemory || cacheSlotSize < result.size())
+        return;
+
+    // Take a free, stale, or matching slot, or else evict the oldest:
+    const auto id = cacheId(data, salt, N, r, p);
+    const auto now = Clock::now();
+    size_t slot = 0;
+    for (size_t i = 0; i < cacheSlots; ++i)
+    {
+        const auto &entry = gCacheEntries[i];
+        if (!entry.used || entry.expires <= now || id == entry.id)
+        {
+            slot = i;
+            break;
+        }
+        if (entry.expires < gCacheEntries[slot].expires)
+            slot = i;
+    }
+
+    cacheWipe(slot);
+    memcpy(gCacheMemory->slots[slot], result.data(), result.size());
+    gCacheEntries[slot] = CacheEntry{true, id, result.size(), now + gCacheLifetime};
+}
+
+} // namespace abcd
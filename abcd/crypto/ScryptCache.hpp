@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Short-lived cache for scrypt results.
+ */
+
+#ifndef ABCD_CRYPTO_SCRYPT_CACHE_HPP
+#define ABCD_CRYPTO_SCRYPT_CACHE_HPP
+
+#include "../util/Data.hpp"
+#include "../util/Status.hpp"
+
+namespace abcd {
+
+/**
+ * Turns on the scrypt cache, keeping each result for the given time.
+ * Results live in locked memory, and are wiped when they expire,
+ * when they are evicted, and when the cache is cleared.
+ * The cache is off until this is called.
+ * A lifetime of zero turns it back off.
+ */
+Status
+scryptCacheEnable(unsigned seconds);
+
+/**
+ * Wipes every cached result, leaving the cache enabled.
+ */
+void
+scryptCacheClear();
+
+/**
+ * Looks up an earlier scrypt result.
+ * @return false if the cache is off, or has no live entry for these inputs.
+ */
+bool
+scryptCacheGet(uint8_t *result, size_t size, DataSlice data,
+               DataSlice salt, unsigned long N, unsigned long r, unsigned long p);
+
+/**
+ * Saves a scrypt result, if the cache is on.
+ * The inputs are only kept as a keyed hash.
+ */
+void
+scryptCacheSet(DataSlice result, DataSlice data,
+               DataSlice salt, unsigned long N, unsigned long r, unsigned long p);
+
+} // namespace abcd
+
+#endif
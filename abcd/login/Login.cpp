@@ -105,8 +105,12 @@ tABC_CC ABC_LoginCreate(std::shared_ptr<Login> &result,
     // LP = L + P:
     ABC_BUF_STRCAT(LP, lobby->username().c_str(), szPassword);
 
+    // LP1 = Scrypt(LP, SNRP1), LP2 = Scrypt(LP, SNRP2):
+    ABC_CHECK_RET(ABC_CryptoScryptSNRPs({
+        {LP, pCarePackage->pSNRP1, &LP1},
+        {LP, pCarePackage->pSNRP2, &LP2}}, pError));
+
     // Set up EMK_LP2:
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LP, pCarePackage->pSNRP2, &LP2, pError));
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(toU08Buf(dataKey), LP2,
         ABC_CryptoType_AES256, &pLoginPackage->EMK_LP2, pError));
 
@@ -115,7 +119,6 @@ tABC_CC ABC_LoginCreate(std::shared_ptr<Login> &result,
         ABC_CryptoType_AES256, &pLoginPackage->ESyncKey, pError));
 
     // Set up ELP1:
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LP, pCarePackage->pSNRP1, &LP1, pError));
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(LP1, toU08Buf(dataKey),
         ABC_CryptoType_AES256, &pLoginPackage->ELP1, pError));
 
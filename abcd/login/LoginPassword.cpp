@@ -67,12 +67,15 @@ tABC_CC ABC_LoginPasswordServer(std::shared_ptr<Login> &result,
     // Get the CarePackage:
     ABC_CHECK_RET(ABC_LoginServerGetCarePackage(toU08Buf(lobby->authId()), &pCarePackage, pError));
 
+    // LP1 = Scrypt(LP, SNRP1), LP2 = Scrypt(LP, SNRP2):
+    ABC_CHECK_RET(ABC_CryptoScryptSNRPs({
+        {LP, pCarePackage->pSNRP1, &LP1},
+        {LP, pCarePackage->pSNRP2, &LP2}}, pError));
+
     // Get the LoginPackage:
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LP, pCarePackage->pSNRP1, &LP1, pError));
     ABC_CHECK_RET(ABC_LoginServerGetLoginPackage(toU08Buf(lobby->authId()), LP1, LRA1, &pLoginPackage, pError));
 
     // Decrypt MK:
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LP, pCarePackage->pSNRP2, &LP2, pError));
     ABC_CHECK_RET(ABC_CryptoDecryptJSONObject(pLoginPackage->EMK_LP2, LP2, &MK, pError));
 
     // Decrypt SyncKey:
@@ -157,15 +160,18 @@ tABC_CC ABC_LoginPasswordSet(Login &login,
     // LP = L + P:
     ABC_BUF_STRCAT(LP, login.lobby().username().c_str(), szPassword);
 
+    // LP1 = Scrypt(LP, SNRP1), LP2 = Scrypt(LP, SNRP2):
+    ABC_CHECK_RET(ABC_CryptoScryptSNRPs({
+        {LP, pCarePackage->pSNRP1, &LP1},
+        {LP, pCarePackage->pSNRP2, &LP2}}, pError));
+
     // Update EMK_LP2:
     json_decref(pLoginPackage->EMK_LP2);
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LP, pCarePackage->pSNRP2, &LP2, pError));
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(toU08Buf(login.dataKey()), LP2,
         ABC_CryptoType_AES256, &pLoginPackage->EMK_LP2, pError));
 
     // Update ELP1:
     json_decref(pLoginPackage->ELP1);
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LP, pCarePackage->pSNRP1, &LP1, pError));
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(LP1, toU08Buf(login.dataKey()),
         ABC_CryptoType_AES256, &pLoginPackage->ELP1, pError));
 
@@ -176,8 +176,9 @@ tABC_CC ABC_LoginPin(std::shared_ptr<Login> &result,
 
     // LPIN = L + PIN:
     ABC_BUF_STRCAT(LPIN, lobby->username().c_str(), szPin);
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LPIN, pCarePackage->pSNRP1, &LPIN1, pError));
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LPIN, pCarePackage->pSNRP2, &LPIN2, pError));
+    ABC_CHECK_RET(ABC_CryptoScryptSNRPs({
+        {LPIN, pCarePackage->pSNRP1, &LPIN1},
+        {LPIN, pCarePackage->pSNRP2, &LPIN2}}, pError));
 
     // Get EPINK from the server:
     ABC_CHECK_RET(ABC_LoginServerGetPinPackage(toU08Buf(pLocal->DID), LPIN1, &szEPINK, pError));
@@ -241,8 +242,9 @@ tABC_CC ABC_LoginPinSetup(Login &login,
 
     // LPIN = L + PIN:
     ABC_BUF_STRCAT(LPIN, login.lobby().username().c_str(), szPin);
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LPIN, pCarePackage->pSNRP1, &LPIN1, pError));
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LPIN, pCarePackage->pSNRP2, &LPIN2, pError));
+    ABC_CHECK_RET(ABC_CryptoScryptSNRPs({
+        {LPIN, pCarePackage->pSNRP1, &LPIN1},
+        {LPIN, pCarePackage->pSNRP2, &LPIN2}}, pError));
 
     // Set up PINK stuff:
     ABC_CHECK_NEW(randomData(PINK, KEY_LENGTH), pError);
@@ -82,12 +82,15 @@ tABC_CC ABC_LoginRecovery(std::shared_ptr<Login> &result,
     // LRA = L + RA:
     ABC_BUF_STRCAT(LRA, lobby->username().c_str(), szRecoveryAnswers);
 
+    // LRA1 = Scrypt(LRA, SNRP1), LRA3 = Scrypt(LRA, SNRP3):
+    ABC_CHECK_RET(ABC_CryptoScryptSNRPs({
+        {LRA, pCarePackage->pSNRP1, &LRA1},
+        {LRA, pCarePackage->pSNRP3, &LRA3}}, pError));
+
     // Get the LoginPackage:
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LRA, pCarePackage->pSNRP1, &LRA1, pError));
     ABC_CHECK_RET(ABC_LoginServerGetLoginPackage(toU08Buf(lobby->authId()), LP1, LRA1, &pLoginPackage, pError));
 
     // Decrypt MK:
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LRA, pCarePackage->pSNRP3, &LRA3, pError));
     ABC_CHECK_RET(ABC_CryptoDecryptJSONObject(pLoginPackage->EMK_LRA3, LRA3, &MK, pError));
 
     // Decrypt SyncKey:
@@ -141,8 +144,14 @@ tABC_CC ABC_LoginRecoverySet(Login &login,
     ABC_CHECK_RET(ABC_CryptoCreateSNRPForClient(&pCarePackage->pSNRP3, pError));
     ABC_CHECK_RET(ABC_CryptoCreateSNRPForClient(&pCarePackage->pSNRP4, pError));
 
-    // L4  = Scrypt(L, SNRP4):
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(toU08Buf(login.lobby().username()), pCarePackage->pSNRP4, &L4, pError));
+    // LRA = L + RA:
+    ABC_BUF_STRCAT(LRA, login.lobby().username().c_str(), szRecoveryAnswers);
+
+    // L4 = Scrypt(L, SNRP4), LRA1 = Scrypt(LRA, SNRP1), LRA3 = Scrypt(LRA, SNRP3):
+    ABC_CHECK_RET(ABC_CryptoScryptSNRPs({
+        {toU08Buf(login.lobby().username()), pCarePackage->pSNRP4, &L4},
+        {LRA, pCarePackage->pSNRP1, &LRA1},
+        {LRA, pCarePackage->pSNRP3, &LRA3}}, pError));
 
     // Update ERQ:
     if (pCarePackage->ERQ) json_decref(pCarePackage->ERQ);
@@ -150,18 +159,13 @@ tABC_CC ABC_LoginRecoverySet(Login &login,
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(RQ, L4,
         ABC_CryptoType_AES256, &pCarePackage->ERQ, pError));
 
-    // LRA = L + RA:
-    ABC_BUF_STRCAT(LRA, login.lobby().username().c_str(), szRecoveryAnswers);
-
     // Update EMK_LRA3:
     if (pLoginPackage->EMK_LRA3) json_decref(pLoginPackage->EMK_LRA3);
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LRA, pCarePackage->pSNRP3, &LRA3, pError));
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(toU08Buf(login.dataKey()), LRA3,
         ABC_CryptoType_AES256, &pLoginPackage->EMK_LRA3, pError));
 
     // Update ELRA1:
     if (pLoginPackage->ELRA1) json_decref(pLoginPackage->ELRA1);
-    ABC_CHECK_RET(ABC_CryptoScryptSNRP(LRA, pCarePackage->pSNRP1, &LRA1, pError));
     ABC_CHECK_RET(ABC_CryptoEncryptJSONObject(LRA1, toU08Buf(login.dataKey()),
         ABC_CryptoType_AES256, &pLoginPackage->ELRA1, pError));
 
@@ -35,4 +35,23 @@ buildData(std::initializer_list<DataSlice> slices)
     return out;
 }
 
+void
+putBigEndian(uint8_t *p, uint64_t value, unsigned bytes)
+{
+    for (unsigned i = bytes; i--; )
+    {
+        p[i] = value & 0xff;
+        value >>= 8;
+    }
+}
+
+uint64_t
+getBigEndian(const uint8_t *p, unsigned bytes)
+{
+    uint64_t out = 0;
+    for (unsigned i = 0; i < bytes; ++i)
+        out = out << 8 | p[i];
+    return out;
+}
+
 } // namespace abcd
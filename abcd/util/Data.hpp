@@ -90,6 +90,18 @@ typedef std::vector<uint8_t> DataChunk;
 DataChunk
 buildData(std::initializer_list<DataSlice> slices);
 
+/**
+ * Writes the low `bytes` bytes of an integer in big-endian order.
+ */
+void
+putBigEndian(uint8_t *p, uint64_t value, unsigned bytes);
+
+/**
+ * Reads a `bytes`-byte big-endian integer.
+ */
+uint64_t
+getBigEndian(const uint8_t *p, unsigned bytes);
+
 } // namespace abcd
 
 #endif
@@ -0,0 +1,478 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "RecordLog.hpp"
+#include "AutoFree.hpp"
+#include "FileIO.hpp"
+#include <zlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace abcd {
+
+/*
+ * Each record has the following layout, with integers in big-endian order:
+ *
+ *  4 bytes: CRC-32 of everything that follows
+ *  8 bytes: timestamp, in microseconds
+ *  4 bytes: key length
+ *  4 bytes: data length, or erasedSize for a deletion
+ *  key bytes
+ *  data bytes
+ */
+constexpr size_t headerSize = 20;
+constexpr uint32_t erasedSize = 0xffffffff;
+constexpr size_t maxSegmentSize = 64 << 10;
+constexpr size_t maxSegmentCount = 256;
+
+constexpr char segmentExtension[] = ".log";
+constexpr char tempExtension[] = ".tmp";
+
+typedef AutoFree<tABC_FileIOList, ABC_FileIOFreeFileList> AutoFileList;
+
+static size_t
+recordSize(const std::string &key, size_t dataSize)
+{
+    return headerSize + key.size() + dataSize;
+}
+
+/**
+ * Appends an encoded record to the end of a buffer.
+ */
+static void
+encodeRecord(DataChunk &out, const std::string &key, DataSlice data,
+             uint64_t stamp, bool erased)
+{
+    size_t start = out.size();
+    out.resize(start + recordSize(key, data.size()));
+    uint8_t *p = out.data() + start;
+
+    putBigEndian(p + 4, stamp, 8);
+    putBigEndian(p + 12, key.size(), 4);
+    putBigEndian(p + 16, erased ? erasedSize : data.size(), 4);
+    std::copy(key.begin(), key.end(), p + headerSize);
+    std::copy(data.begin(), data.end(), p + headerSize + key.size());
+
+    uLong crc = crc32(0, p + 4, out.size() - start - 4);
+    putBigEndian(p, crc, 4);
+}
+
+/**
+ * Splits a segment filename into its writer and sequence number.
+ * @return false if the name doesn't look like a segment.
+ */
+static bool
+parseSegmentName(std::string &writer, unsigned &segment,
+                 const std::string &name)
+{
+    const size_t extSize = sizeof(segmentExtension) - 1;
+    if (name.size() <= extSize ||
+            name.compare(name.size() - extSize, extSize, segmentExtension))
+        return false;
+
+    auto dash = name.rfind('-');
+    if (dash == std::string::npos || dash == 0)
+        return false;
+
+    std::string number = name.substr(dash + 1, name.size() - extSize - dash - 1);
+    if (number.empty() ||
+            number.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+
+    writer = name.substr(0, dash);
+    segment = strtoul(number.c_str(), nullptr, 10);
+    return true;
+}
+
+/**
+ * Writes a buffer to the end of a file, making sure it reaches the disk.
+ */
+static Status
+appendFile(DataSlice data, const std::string &filename, const char *mode)
+{
+    AutoFileLock lock(gFileMutex);
+
+    FILE *fp = fopen(filename.c_str(), mode);
+    if (!fp)
+        return ABC_ERROR(ABC_CC_FileOpenError, "Cannot open for writing: " + filename);
+
+    if (1 != fwrite(data.data(), data.size(), 1, fp) ||
+            fflush(fp) || fsync(fileno(fp)))
+    {
+        fclose(fp);
+        return ABC_ERROR(ABC_CC_FileWriteError, "Cannot write file: " + filename);
+    }
+
+    fclose(fp);
+    return Status();
+}
+
+RecordLog::RecordLog(const std::string &dir, const std::string &writer,
+                     bool shared):
+    dir_(dir),
+    writer_(writer),
+    shared_(shared),
+    segment_(0),
+    segmentSize_(0),
+    ownSize_(0),
+    liveSize_(0),
+    stamp_(0),
+    batching_(false)
+{
+}
+
+bool
+RecordLog::exists() const
+{
+    bool exists = false;
+    tABC_Error error;
+    ABC_FileIOFileExists(dir_.c_str(), &exists, &error);
+    return exists;
+}
+
+Status
+RecordLog::load()
+{
+    AutoFileLock lock(gFileMutex);
+
+    records_.clear();
+    segments_.clear();
+    segment_ = 0;
+    segmentSize_ = 0;
+    ownSize_ = 0;
+    liveSize_ = 0;
+    batching_ = false;
+    batch_.clear();
+
+    ABC_CHECK(fileEnsureDir(dir_));
+
+    // Find the segments, ordered by sequence number:
+    std::map<std::pair<unsigned, std::string>, bool> segments;
+    AutoFileList list;
+    ABC_CHECK_OLD(ABC_FileIOCreateFileList(&list.get(), dir_.c_str(), &error));
+    for (int i = 0; i < list->nCount; ++i)
+    {
+        const auto &file = *list->apFiles[i];
+        std::string writer;
+        unsigned segment;
+        if (ABC_FileIOFileType_Regular == file.type &&
+                parseSegmentName(writer, segment, file.szName))
+            segments[std::make_pair(segment, std::string(file.szName))] =
+                writer == writer_;
+    }
+
+    for (const auto &i: segments)
+    {
+        unsigned segment = i.first.first;
+        const std::string &name = i.first.second;
+        bool own = i.second;
+
+        DataChunk data;
+        ABC_CHECK(fileLoad(data, dir_ + "/" + name));
+
+        // Replay the records, stopping at the first damaged one:
+        size_t offset = 0;
+        while (headerSize <= data.size() - offset)
+        {
+            const uint8_t *p = data.data() + offset;
+            size_t keySize = getBigEndian(p + 12, 4);
+            uint32_t dataSize = getBigEndian(p + 16, 4);
+            bool erased = erasedSize == dataSize;
+            if (erased)
+                dataSize = 0;
+
+            size_t size = headerSize + keySize + dataSize;
+            if (data.size() - offset < size ||
+                    getBigEndian(p, 4) != crc32(0, p + 4, size - 4))
+                break;
+
+            const uint8_t *keyStart = p + headerSize;
+            const uint8_t *dataStart = keyStart + keySize;
+            std::string key(keyStart, dataStart);
+            Record record{DataChunk(dataStart, dataStart + dataSize),
+                          getBigEndian(p + 4, 8), erased, own};
+            if (stamp_ < record.stamp)
+                stamp_ = record.stamp;
+            insert(key, record);
+
+            offset += size;
+        }
+
+        if (own)
+        {
+            segments_.push_back(segment);
+            segment_ = segment;
+            segmentSize_ = data.size();
+            ownSize_ += data.size();
+        }
+    }
+
+    // Never append to a segment from an earlier session,
+    // since it may already be synced or have a damaged tail:
+    seal();
+
+    return Status();
+}
+
+bool
+RecordLog::get(DataChunk &result, const std::string &key) const
+{
+    auto i = records_.find(key);
+    if (records_.end() == i || i->second.erased)
+        return false;
+
+    result = i->second.data;
+    return true;
+}
+
+uint64_t
+RecordLog::stamp(const std::string &key) const
+{
+    auto i = records_.find(key);
+    if (records_.end() == i)
+        return 0;
+
+    return i->second.stamp;
+}
+
+std::list<std::string>
+RecordLog::keys(const std::string &prefix) const
+{
+    std::list<std::string> out;
+    for (auto i = records_.lower_bound(prefix); records_.end() != i; ++i)
+    {
+        if (i->first.compare(0, prefix.size(), prefix))
+            break;
+        if (!i->second.erased)
+            out.push_back(i->first);
+    }
+    return out;
+}
+
+Status
+RecordLog::set(const std::string &key, DataSlice data)
+{
+    std::map<std::string, DataChunk> records;
+    records[key] = DataChunk(data.begin(), data.end());
+    return set(records);
+}
+
+Status
+RecordLog::set(const std::map<std::string, DataChunk> &records)
+{
+    if (records.empty())
+        return Status();
+
+    DataChunk buffer;
+    std::map<std::string, Record> pending;
+    for (const auto &i: records)
+    {
+        Record record{i.second, nextStamp(), false, true};
+        encodeRecord(buffer, i.first, record.data, record.stamp, false);
+        pending[i.first] = record;
+    }
+    ABC_CHECK(append(buffer));
+
+    for (auto &i: pending)
+        insert(i.first, i.second);
+
+    ABC_CHECK(autoCompact());
+
+    return Status();
+}
+
+Status
+RecordLog::erase(const std::string &key)
+{
+    auto i = records_.find(key);
+    if (records_.end() == i || i->second.erased)
+        return Status();
+
+    Record record{DataChunk(), nextStamp(), true, true};
+    DataChunk buffer;
+    encodeRecord(buffer, key, DataChunk(), record.stamp, true);
+    ABC_CHECK(append(buffer));
+    insert(key, record);
+
+    return Status();
+}
+
+void
+RecordLog::begin()
+{
+    batching_ = true;
+}
+
+Status
+RecordLog::commit()
+{
+    if (!batching_)
+        return Status();
+    batching_ = false;
+
+    DataChunk batch;
+    batch.swap(batch_);
+    if (!batch.empty())
+        ABC_CHECK(append(batch));
+    ABC_CHECK(autoCompact());
+
+    return Status();
+}
+
+void
+RecordLog::seal()
+{
+    if (segmentSize_)
+    {
+        ++segment_;
+        segmentSize_ = 0;
+    }
+}
+
+Status
+RecordLog::compact()
+{
+    AutoFileLock lock(gFileMutex);
+
+    // Gather the records we still own, splitting them into segments.
+    // In a shared log, deletions need to stay, since other writers
+    // may still have older versions of those keys:
+    std::list<DataChunk> buffers(1);
+    for (auto i = records_.begin(); records_.end() != i; )
+    {
+        if (!shared_ && i->second.erased)
+        {
+            i = records_.erase(i);
+            continue;
+        }
+        if (!i->second.own)
+        {
+            ++i;
+            continue;
+        }
+        if (maxSegmentSize < buffers.back().size())
+            buffers.emplace_back();
+        encodeRecord(buffers.back(), i->first, i->second.data,
+                     i->second.stamp, i->second.erased);
+        ++i;
+    }
+    if (buffers.back().empty())
+        buffers.pop_back();
+
+    // Write the new segments, each one atomically:
+    std::list<unsigned> segments;
+    unsigned segment = segment_;
+    size_t total = 0;
+    for (const auto &buffer: buffers)
+    {
+        ++segment;
+        std::string name = segmentName(segment);
+        std::string temp = name + tempExtension;
+        ABC_CHECK(appendFile(buffer, temp, "wb"));
+        if (rename(temp.c_str(), name.c_str()))
+            return ABC_ERROR(ABC_CC_FileWriteError, "Cannot rename " + temp);
+        segments.push_back(segment);
+        total += buffer.size();
+    }
+
+    // The new segments have everything, so the old ones can go:
+    for (auto old: segments_)
+        ABC_CHECK_OLD(ABC_FileIODeleteFile(segmentName(old).c_str(), &error));
+
+    segments_ = segments;
+    segment_ = segments.empty() ? segment + 1 : segment;
+    segmentSize_ = buffers.empty() ? 0 : buffers.back().size();
+    ownSize_ = total;
+    liveSize_ = total;
+
+    return Status();
+}
+
+std::string
+RecordLog::segmentName(unsigned segment) const
+{
+    char number[16];
+    snprintf(number, sizeof(number), "%08u", segment);
+    return dir_ + "/" + writer_ + "-" + number + segmentExtension;
+}
+
+uint64_t
+RecordLog::nextStamp()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    uint64_t now = static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+
+    stamp_ = stamp_ < now ? now : stamp_ + 1;
+    return stamp_;
+}
+
+bool
+RecordLog::insert(const std::string &key, Record &record)
+{
+    auto i = records_.find(key);
+    if (records_.end() != i)
+    {
+        // Later records win ties, since they were loaded or written later:
+        if (record.stamp < i->second.stamp)
+            return false;
+        if (i->second.own && (shared_ || !i->second.erased))
+            liveSize_ -= recordSize(key, i->second.data.size());
+        i->second = std::move(record);
+    }
+    else
+    {
+        i = records_.emplace(key, std::move(record)).first;
+    }
+
+    if (i->second.own && (shared_ || !i->second.erased))
+        liveSize_ += recordSize(key, i->second.data.size());
+    return true;
+}
+
+Status
+RecordLog::append(DataSlice data)
+{
+    if (batching_)
+    {
+        batch_.insert(batch_.end(), data.begin(), data.end());
+        return Status();
+    }
+
+    if (segmentSize_ && maxSegmentSize < segmentSize_ + data.size())
+    {
+        ++segment_;
+        segmentSize_ = 0;
+    }
+
+    ABC_CHECK(appendFile(data, segmentName(segment_), "ab"));
+    if (segments_.empty() || segments_.back() != segment_)
+        segments_.push_back(segment_);
+    segmentSize_ += data.size();
+    ownSize_ += data.size();
+
+    return Status();
+}
+
+Status
+RecordLog::autoCompact()
+{
+    if (batching_)
+        return Status();
+
+    // Sealing leaves lots of small segments behind,
+    // so merge them once there are many more than the data needs:
+    bool stale = maxSegmentSize < ownSize_ && 2 * liveSize_ < ownSize_;
+    bool scattered = maxSegmentCount + liveSize_ / maxSegmentSize <
+                     segments_.size();
+    if (stale || scattered)
+        ABC_CHECK(compact());
+    return Status();
+}
+
+} // namespace abcd
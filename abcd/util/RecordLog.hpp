@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Append-only keyed record storage.
+ */
+
+#ifndef ABCD_UTIL_RECORD_LOG_HPP
+#define ABCD_UTIL_RECORD_LOG_HPP
+
+#include "Data.hpp"
+#include "Status.hpp"
+#include <list>
+#include <map>
+
+namespace abcd {
+
+/**
+ * An append-only log of keyed records, split across numbered segment files.
+ *
+ * Writing a key appends a new record to the end of the active segment,
+ * replacing any earlier record with that key, so loading the whole log
+ * is a single sequential read per segment. Old records are dropped by
+ * periodically compacting the segments.
+ *
+ * Each writer only ever touches its own segments, which are named after it.
+ * This allows the log to live in a synced directory, since two devices
+ * never modify the same file. When several writers change the same key,
+ * the record with the newest timestamp wins. Segments are kept small,
+ * and sealing the active one before each sync means a sync commit
+ * only picks up new files, never a rewrite of an old one.
+ *
+ * A log that only one writer ever touches, outside any synced directory,
+ * can be marked private. Compacting a private log drops deletions
+ * along with the records they replaced, since nobody else can be holding
+ * an older version of those keys.
+ *
+ * The payloads are opaque to the log, so callers are expected to
+ * encrypt anything sensitive before handing it over.
+ */
+class RecordLog
+{
+public:
+    /**
+     * @param dir the directory holding the segment files.
+     * @param writer a name unique to this device.
+     * @param shared false if this writer is the only one that will ever
+     * touch the directory, which lets compaction forget deleted keys.
+     */
+    RecordLog(const std::string &dir, const std::string &writer,
+              bool shared=true);
+
+    /**
+     * Returns true if the log directory exists on disk.
+     */
+    bool
+    exists() const;
+
+    /**
+     * Reads all the segments in the log directory,
+     * replacing whatever is currently in memory.
+     * Creates the directory if it doesn't exist.
+     */
+    Status
+    load();
+
+    /**
+     * Looks up the current contents of a key.
+     * @return false if the key doesn't exist.
+     */
+    bool
+    get(DataChunk &result, const std::string &key) const;
+
+    /**
+     * Returns when a key was last written or erased,
+     * in microseconds since the epoch.
+     * @return 0 if the log has never seen the key.
+     */
+    uint64_t
+    stamp(const std::string &key) const;
+
+    /**
+     * Returns all the live keys starting with the given prefix.
+     */
+    std::list<std::string>
+    keys(const std::string &prefix="") const;
+
+    /**
+     * Appends a record to the log, making it the current value for its key.
+     */
+    Status
+    set(const std::string &key, DataSlice data);
+
+    /**
+     * Appends several records to the log in a single write.
+     */
+    Status
+    set(const std::map<std::string, DataChunk> &records);
+
+    /**
+     * Marks a key as removed.
+     */
+    Status
+    erase(const std::string &key);
+
+    /**
+     * Starts a group commit. Until the matching commit() call,
+     * writes update the in-memory table right away,
+     * but only reach the disk as a single append at the end.
+     */
+    void
+    begin();
+
+    /**
+     * Writes out everything since begin().
+     * If this fails, memory is ahead of the disk until the next load().
+     */
+    Status
+    commit();
+
+    /**
+     * Closes the active segment, so the next write starts a new one.
+     * Call this before syncing the log directory,
+     * so files that have already been synced never change again.
+     */
+    void
+    seal();
+
+    /**
+     * Rewrites this writer's segments, keeping only the current records.
+     * This happens automatically once enough stale records build up.
+     */
+    Status
+    compact();
+
+private:
+    struct Record
+    {
+        DataChunk data;
+        uint64_t stamp;
+        bool erased;
+        bool own;       // Did this writer create the record?
+    };
+
+    std::string dir_;
+    std::string writer_;
+    bool shared_;
+    std::map<std::string, Record> records_;
+
+    // Write state:
+    std::list<unsigned> segments_;  // Our segment numbers, oldest first
+    unsigned segment_;      // Our active segment number
+    size_t segmentSize_;    // Bytes in our active segment
+    size_t ownSize_;        // Bytes in all our segments
+    size_t liveSize_;       // Bytes our current records would need
+    uint64_t stamp_;        // Latest timestamp seen
+    bool batching_;         // Inside begin() / commit()?
+    DataChunk batch_;       // Records waiting for commit()
+
+    std::string
+    segmentName(unsigned segment) const;
+
+    uint64_t
+    nextStamp();
+
+    /**
+     * Adds a record to the in-memory table,
+     * returning false if a newer record already exists.
+     */
+    bool
+    insert(const std::string &key, Record &record);
+
+    /**
+     * Appends pre-encoded records to the active segment,
+     * starting a new segment if the active one is full.
+     */
+    Status
+    append(DataSlice data);
+
+    /**
+     * Compacts the log if stale records take up most of the space.
+     */
+    Status
+    autoCompact();
+};
+
+} // namespace abcd
+
+#endif
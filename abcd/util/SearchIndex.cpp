@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "SearchIndex.hpp"
+#include <ctype.h>
+#include <algorithm>
+#include <set>
+
+namespace abcd {
+
+constexpr size_t gramSize = 3;
+
+static std::string
+lowerCase(const std::string &s)
+{
+    std::string out(s);
+    for (auto &c: out)
+        c = tolower(static_cast<unsigned char>(c));
+    return out;
+}
+
+/**
+ * Lists the unique trigrams in a piece of text,
+ * skipping any that straddle a field separator.
+ */
+static std::set<uint32_t>
+trigrams(const std::string &text)
+{
+    std::set<uint32_t> out;
+    for (size_t i = 0; i + gramSize <= text.size(); ++i)
+    {
+        const auto *p = reinterpret_cast<const uint8_t *>(text.data() + i);
+        if (p[0] && p[1] && p[2])
+            out.insert(p[0] << 16 | p[1] << 8 | p[2]);
+    }
+    return out;
+}
+
+void
+SearchIndex::insert(const std::string &id, const std::list<std::string> &fields)
+{
+    erase(id);
+
+    Document document{id, std::string()};
+    for (const auto &field: fields)
+    {
+        document.text += lowerCase(field);
+        document.text.push_back(0);
+    }
+
+    uint32_t number;
+    if (free_.empty())
+    {
+        number = documents_.size();
+        documents_.push_back(document);
+    }
+    else
+    {
+        number = free_.back();
+        free_.pop_back();
+        documents_[number] = document;
+    }
+    ids_[id] = number;
+
+    // Posting lists stay sorted, which keeps intersections cheap:
+    for (auto gram: trigrams(document.text))
+    {
+        auto &posting = postings_[gram];
+        posting.insert(std::lower_bound(posting.begin(), posting.end(), number),
+                       number);
+    }
+}
+
+void
+SearchIndex::erase(const std::string &id)
+{
+    auto i = ids_.find(id);
+    if (ids_.end() == i)
+        return;
+
+    uint32_t number = i->second;
+    Document &document = documents_[number];
+    for (auto gram: trigrams(document.text))
+    {
+        auto &posting = postings_[gram];
+        auto j = std::lower_bound(posting.begin(), posting.end(), number);
+        if (posting.end() != j && number == *j)
+            posting.erase(j);
+        if (posting.empty())
+            postings_.erase(gram);
+    }
+
+    document = Document();
+    free_.push_back(number);
+    ids_.erase(i);
+}
+
+std::list<std::string>
+SearchIndex::search(const std::string &query) const
+{
+    std::list<std::string> out;
+    if (query.empty())
+        return out;
+    const std::string needle = lowerCase(query);
+
+    // Gather candidates, starting from the shortest posting list:
+    std::vector<uint32_t> candidates;
+    if (gramSize <= needle.size())
+    {
+        std::vector<const std::vector<uint32_t> *> lists;
+        for (auto gram: trigrams(needle))
+        {
+            auto i = postings_.find(gram);
+            if (postings_.end() == i)
+                return out;
+            lists.push_back(&i->second);
+        }
+        std::sort(lists.begin(), lists.end(),
+            [](const std::vector<uint32_t> *a, const std::vector<uint32_t> *b)
+            {
+                return a->size() < b->size();
+            });
+
+        candidates = *lists.front();
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+        {
+            std::vector<uint32_t> both;
+            std::set_intersection(candidates.begin(), candidates.end(),
+                                  lists[i]->begin(), lists[i]->end(),
+                                  std::back_inserter(both));
+            candidates.swap(both);
+        }
+    }
+    else
+    {
+        for (const auto &i: ids_)
+            candidates.push_back(i.second);
+    }
+
+    // Trigrams can match out of order, so check the actual text:
+    for (auto number: candidates)
+    {
+        const Document &document = documents_[number];
+        if (std::string::npos != document.text.find(needle))
+            out.push_back(document.id);
+    }
+    return out;
+}
+
+} // namespace abcd
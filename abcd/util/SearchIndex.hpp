@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * In-memory substring search index.
+ */
+
+#ifndef ABCD_UTIL_SEARCH_INDEX_HPP
+#define ABCD_UTIL_SEARCH_INDEX_HPP
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace abcd {
+
+/**
+ * Finds documents containing a case-insensitive substring.
+ *
+ * Each document is a list of text fields.
+ * The index keeps a posting list for every three-character sequence
+ * appearing in the fields, so a search only has to look at the documents
+ * containing all of the query's trigrams, rather than every document.
+ * Shorter queries fall back to scanning the stored text,
+ * which is still far cheaper than loading the documents themselves.
+ */
+class SearchIndex
+{
+public:
+    /**
+     * Adds a document to the index, replacing any earlier version.
+     */
+    void
+    insert(const std::string &id, const std::list<std::string> &fields);
+
+    /**
+     * Removes a document from the index.
+     */
+    void
+    erase(const std::string &id);
+
+    /**
+     * Returns the ids of the documents with a field containing the query.
+     */
+    std::list<std::string>
+    search(const std::string &query) const;
+
+private:
+    typedef uint32_t Gram;
+
+    struct Document
+    {
+        std::string id;
+        std::string text;   // Lower-cased fields, separated by nulls
+    };
+
+    std::vector<Document> documents_;
+    std::vector<uint32_t> free_;        // Unused document numbers
+    std::map<std::string, uint32_t> ids_;
+    std::unordered_map<Gram, std::vector<uint32_t>> postings_;
+};
+
+} // namespace abcd
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "SecureData.hpp"
+#include "Util.hpp"
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace abcd {
+
+/**
+ * Rounds a size up to whole pages, so no two blocks share a page
+ * and unlocking one can never unlock another.
+ */
+static size_t
+securePages(size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+void *
+secureAlloc(size_t size)
+{
+    if (!size)
+        size = 1;
+    size = securePages(size);
+
+    void *memory;
+    if (posix_memalign(&memory, sysconf(_SC_PAGESIZE), size))
+        return nullptr;
+    mlock(memory, size);
+    return memory;
+}
+
+void
+secureFree(void *p, size_t size)
+{
+    if (!p)
+        return;
+    if (!size)
+        size = 1;
+    size = securePages(size);
+
+    ABC_UtilGuaranteedMemset(p, 0, size);
+    munlock(p, size);
+    free(p);
+}
+
+} // namespace abcd
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Storage for secrets that need to stay in memory for a while.
+ */
+
+#ifndef ABCD_UTIL_SECURE_DATA_HPP
+#define ABCD_UTIL_SECURE_DATA_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <vector>
+
+namespace abcd {
+
+/**
+ * Allocates page-aligned memory and tries to lock it out of swap.
+ * Locking is best-effort, since the process may be over its mlock limit.
+ * @return nullptr if there is no memory at all.
+ */
+void *
+secureAlloc(size_t size);
+
+/**
+ * Wipes, unlocks, and frees a block from secureAlloc.
+ * The size must match the one passed to secureAlloc.
+ */
+void
+secureFree(void *p, size_t size);
+
+/**
+ * An STL allocator built on secureAlloc and secureFree.
+ * Every buffer a container gives back is wiped on the way out,
+ * including the old ones left behind when it grows.
+ */
+template<typename T>
+struct SecureAllocator
+{
+    typedef T value_type;
+
+    SecureAllocator() {}
+    template<typename U> SecureAllocator(const SecureAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        void *p = secureAlloc(n * sizeof(T));
+        if (!p)
+            throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        secureFree(p, n * sizeof(T));
+    }
+};
+
+template<typename T, typename U> bool
+operator==(const SecureAllocator<T> &, const SecureAllocator<U> &)
+{
+    return true;
+}
+
+template<typename T, typename U> bool
+operator!=(const SecureAllocator<T> &, const SecureAllocator<U> &)
+{
+    return false;
+}
+
+/**
+ * A DataChunk for plaintext and keys that stick around.
+ */
+typedef std::vector<uint8_t, SecureAllocator<uint8_t>> SecureChunk;
+
+} // namespace abcd
+
+#endif
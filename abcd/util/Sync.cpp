@@ -9,6 +9,7 @@
 #include "Util.hpp"
 #include "Mutex.hpp"
 #include "../General.hpp"
+#include "../crypto/Crypto.hpp"
 #include "../util/Data.hpp"
 #include "../../minilibs/git-sync/sync.h"
 #include <stdlib.h>
@@ -154,6 +155,7 @@ tABC_CC ABC_SyncRepo(const char *szRepoPath,
     {
         AutoCoreLock lock(gCoreMutex);
         e = sync_master(repo, &dirty, &need_push);
+        cryptoFileCacheInvalidate(szRepoPath);
     }
     ABC_CHECK_ASSERT(0 <= e, ABC_CC_SysError, "sync_master failed");
 
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "TimeIndex.hpp"
+
+namespace abcd {
+
+TimeRange
+timeIndexRange(const TimeIndex &index, int64_t startTime, int64_t endTime)
+{
+    auto begin = index.lower_bound(TimeKey(startTime, std::string()));
+    if (endTime <= startTime)
+        return TimeRange(begin, begin);
+
+    auto end = index.lower_bound(TimeKey(endTime, std::string()));
+    return TimeRange(begin, end);
+}
+
+TimeRange
+timeIndexAfter(const TimeIndex &index, TimeRange range,
+               const TimeKey &cursor, bool bNewestFirst)
+{
+    if (range.first == range.second)
+        return range;
+
+    if (bNewestFirst)
+    {
+        // Keep what comes before the cursor:
+        if (!(*range.first < cursor))
+            range.second = range.first;
+        else if (range.second == index.end() || cursor < *range.second)
+            range.second = index.lower_bound(cursor);
+    }
+    else
+    {
+        // Keep what comes after the cursor:
+        if (range.second != index.end() && !(cursor < *range.second))
+            range.first = range.second;
+        else if (!(cursor < *range.first))
+            range.first = index.upper_bound(cursor);
+    }
+    return range;
+}
+
+} // namespace abcd
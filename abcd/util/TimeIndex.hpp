@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Time-ordered index of record ids.
+ */
+
+#ifndef ABCD_UTIL_TIME_INDEX_HPP
+#define ABCD_UTIL_TIME_INDEX_HPP
+
+#include <stdint.h>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace abcd {
+
+/**
+ * A (time, id) pair. The id breaks ties between records
+ * created at the same time.
+ */
+typedef std::pair<int64_t, std::string> TimeKey;
+
+/**
+ * Record ids, sorted by time.
+ */
+typedef std::set<TimeKey> TimeIndex;
+
+/**
+ * A run of index entries, from `first` up to but not including `second`.
+ * The functions below never hand out a range that ends before it starts.
+ */
+typedef std::pair<TimeIndex::const_iterator, TimeIndex::const_iterator>
+    TimeRange;
+
+/**
+ * Finds the entries with startTime <= time < endTime.
+ * An inverted range comes back empty.
+ */
+TimeRange
+timeIndexRange(const TimeIndex &index, int64_t startTime, int64_t endTime);
+
+/**
+ * Narrows a range down to the entries past a paging cursor.
+ * Walking oldest-first, these are the entries after the cursor,
+ * and walking newest-first, the entries before it.
+ * A cursor outside the range leaves either all of it or none of it.
+ */
+TimeRange
+timeIndexAfter(const TimeIndex &index, TimeRange range,
+               const TimeKey &cursor, bool bNewestFirst);
+
+} // namespace abcd
+
+#endif
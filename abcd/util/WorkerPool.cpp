@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "WorkerPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace abcd {
+
+struct WorkerBatch
+{
+    const std::function<void (size_t)> &task;
+    size_t count;
+    std::atomic<size_t> next;
+
+    // Protected by the pool mutex:
+    size_t done;        // Calls that have finished
+    size_t active;      // Workers still holding a reference
+
+    WorkerBatch(const std::function<void (size_t)> &task, size_t count):
+        task(task), count(count), next(0), done(0), active(0)
+    {}
+};
+
+struct WorkerPool
+{
+    std::mutex mutex;
+    std::condition_variable work;   // Workers wait on this
+    std::condition_variable done;   // Callers wait on this
+    std::list<WorkerBatch *> queue; // Batches with unclaimed calls
+    size_t threads = 0;
+};
+
+/**
+ * The workers outlive everything else in the process,
+ * so the pool is never destroyed out from under them.
+ */
+static WorkerPool &
+workerPool()
+{
+    static WorkerPool *pool = new WorkerPool();
+    return *pool;
+}
+
+/**
+ * Makes calls from a batch until none are left unclaimed.
+ * @return the number of calls made.
+ */
+static size_t
+workerPoolDrain(WorkerBatch &batch)
+{
+    size_t made = 0;
+    for (size_t i = batch.next++; i < batch.count; i = batch.next++)
+    {
+        batch.task(i);
+        ++made;
+    }
+    return made;
+}
+
+static void
+workerPoolLoop()
+{
+    WorkerPool &pool = workerPool();
+    std::unique_lock<std::mutex> lock(pool.mutex);
+
+    while (true)
+    {
+        pool.work.wait(lock, [&pool]{ return !pool.queue.empty(); });
+
+        WorkerBatch *batch = pool.queue.front();
+        if (batch->count <= batch->next)
+        {
+            // Everything is claimed, so nobody else needs to find this:
+            pool.queue.pop_front();
+            continue;
+        }
+
+        ++batch->active;
+        lock.unlock();
+        size_t made = workerPoolDrain(*batch);
+        lock.lock();
+        batch->done += made;
+        --batch->active;
+        pool.done.notify_all();
+    }
+}
+
+void
+workerPoolRun(size_t count, const std::function<void (size_t)> &task)
+{
+    WorkerPool &pool = workerPool();
+    WorkerBatch batch(task, count);
+
+    if (count < 2)
+    {
+        workerPoolDrain(batch);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+
+        // The calling thread does its share, so one fewer worker will do:
+        size_t wanted = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        while (pool.threads < wanted)
+        {
+            try
+            {
+                std::thread(workerPoolLoop).detach();
+                ++pool.threads;
+            }
+            catch (const std::system_error &)
+            {
+                break;
+            }
+        }
+
+        pool.queue.push_back(&batch);
+        pool.work.notify_all();
+    }
+
+    size_t made = workerPoolDrain(batch);
+
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    batch.done += made;
+    pool.queue.remove(&batch);
+    pool.done.wait(lock, [&batch]
+    {
+        return batch.count <= batch.done && !batch.active;
+    });
+}
+
+} // namespace abcd
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Shared background threads for parallel work.
+ */
+
+#ifndef ABCD_UTIL_WORKER_POOL_HPP
+#define ABCD_UTIL_WORKER_POOL_HPP
+
+#include <stddef.h>
+#include <functional>
+
+namespace abcd {
+
+/**
+ * Calls `task(0)` through `task(count - 1)`, spread across a shared
+ * set of worker threads as well as the calling thread,
+ * and returns once every call has finished.
+ *
+ * The workers start on first use and then wait around for later batches,
+ * so a short batch doesn't pay for creating threads. Each thread grabs
+ * the next unclaimed index as it goes, so one slow call doesn't hold up
+ * the rest. Tasks must not throw. A task may start a batch of its own,
+ * which the calling thread can always finish alone if the workers are busy.
+ */
+void
+workerPoolRun(size_t count, const std::function<void (size_t)> &task);
+
+} // namespace abcd
+
+#endif
@@ -7,18 +7,23 @@
 
 #include "Commands.hpp"
 #include "../src/LoginShim.hpp"
+#include "../abcd/Tx.hpp"
 #include "../abcd/Wallet.hpp"
 #include "../abcd/account/Account.hpp"
+#include "../abcd/bitcoin/HdChain.hpp"
 #include "../abcd/bitcoin/WatcherBridge.hpp"
 #include "../abcd/crypto/Crypto.hpp"
 #include "../abcd/crypto/Encoding.hpp"
+#include "../abcd/crypto/Scrypt.hpp"
 #include "../abcd/exchange/Exchange.hpp"
 #include "../abcd/json/JsonFile.hpp"
 #include "../abcd/login/Login.hpp"
 #include "../abcd/util/FileIO.hpp"
 #include "../abcd/util/Util.hpp"
 #include <wallet/wallet.hpp>
+#include <chrono>
 #include <iostream>
+#include <sstream>
 
 using namespace abcd;
 
@@ -83,6 +88,20 @@ Status addCategory(int argc, char *argv[])
     return Status();
 }
 
+Status calibrateScrypt(int argc, char *argv[])
+{
+    if (argc != 0)
+        return ABC_ERROR(ABC_CC_Error, "usage: ... calibrate-scrypt");
+
+    auto before = scryptCalibration();
+    ABC_CHECK(scryptCalibrate());
+    auto after = scryptCalibration();
+
+    printf("saved: %u us (N=%u r=%u)\n", before.time, before.N, before.r);
+    printf("measured: %u us (N=%u r=%u)\n", after.time, after.N, after.r);
+    return Status();
+}
+
 Status changePassword(int argc, char *argv[])
 {
     if (argc != 4)
@@ -178,15 +197,12 @@ Status generateAddresses(int argc, char *argv[])
     tABC_U08Buf data; // Do not free
     ABC_CHECK_OLD(ABC_WalletGetBitcoinPrivateSeed(ABC_WalletID(*login, argv[2]), &data, &error));
 
-    libbitcoin::data_chunk seed(data.p, data.end);
-    libwallet::hd_private_key m(seed);
-    libwallet::hd_private_key m0 = m.generate_private_key(0);
-    libwallet::hd_private_key m00 = m0.generate_private_key(0);
+    HdChain chain(data);
     long max = strtol(argv[3], 0, 10);
-    for (int i = 0; i < max; ++i)
+    for (const auto &address: chain.pubAddresses(0, max < 0 ? 0 : max))
     {
-        libwallet::hd_private_key m00n = m00.generate_private_key(i);
-        std::cout << "watch " << m00n.address().encoded() << std::endl;
+        if (!address.empty())
+            std::cout << "watch " << address << std::endl;
     }
 
     return Status();
@@ -430,37 +446,54 @@ Status removeCategory(int argc, char *argv[])
 Status searchBitcoinSeed(int argc, char *argv[])
 {
     if (argc != 6)
-        return ABC_ERROR(ABC_CC_Error, "usage: ... search-bitcoin-seed <user> <pass> <wallet-name> <addr> <start> <end>");
+        return ABC_ERROR(ABC_CC_Error, "usage: ... search-bitcoin-seed <user> <pass> <wallet-name> <addr>[,<addr>...] <start> <end>");
+
+    // Compare hash160s, rather than encoding every candidate address:
+    ShortHashSet targets;
+    std::map<bc::short_hash, std::string> names;
+    std::stringstream list(argv[3]);
+    std::string name;
+    while (std::getline(list, name, ','))
+    {
+        bc::payment_address address;
+        if (!address.set_encoded(name))
+            return ABC_ERROR(ABC_CC_ParseError, "Bad address " + name);
+        targets.insert(address.hash());
+        names[address.hash()] = name;
+    }
 
-    long start = strtol(argv[4], 0, 10);
-    long end = strtol(argv[5], 0, 10);
-    char *szMatchAddr = argv[3];
+    char *szEnd;
+    unsigned long start = strtoul(argv[4], &szEnd, 10);
+    if (*szEnd || UINT32_MAX < start)
+        return ABC_ERROR(ABC_CC_ParseError, "Bad start index");
+    unsigned long end = strtoul(argv[5], &szEnd, 10);
+    if (*szEnd || UINT32_MAX < end || end < start)
+        return ABC_ERROR(ABC_CC_ParseError, "Bad end index");
 
     std::shared_ptr<Login> login;
     ABC_CHECK(cacheLoginPassword(login, argv[0], argv[1]));
 
     tABC_U08Buf data; // Do not free
     ABC_CHECK_OLD(ABC_WalletGetBitcoinPrivateSeed(ABC_WalletID(*login, argv[2]), &data, &error));
+    HdChain chain(data);
 
-    libbitcoin::data_chunk seed(data.p, data.end);
-    libwallet::hd_private_key m(seed);
-    libwallet::hd_private_key m0 = m.generate_private_key(0);
-    libwallet::hd_private_key m00 = m0.generate_private_key(0);
-
-    for (long i = start, c = 0; i <= end; i++, ++c)
+    const uint64_t total = end - start + 1;
+    const auto began = std::chrono::steady_clock::now();
+    auto progress = [&](uint64_t checked)
     {
-        libwallet::hd_private_key m00n = m00.generate_private_key(i);
-        if (m00n.address().encoded() == szMatchAddr)
-        {
-            printf("Found %s at %ld\n", szMatchAddr, i);
-            break;
-        }
-        if (c == 100000)
-        {
-            printf("%ld\n", i);
-            c = 0;
-        }
-    }
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - began;
+        double rate = elapsed.count() ? checked / elapsed.count() : 0;
+        printf("checked %llu of %llu (%.0f keys/s)\n",
+            static_cast<unsigned long long>(checked),
+            static_cast<unsigned long long>(total), rate);
+    };
+
+    auto found = chain.search(targets, start, end, progress);
+    for (const auto &i: found)
+        printf("Found %s at %u\n", names[i.second].c_str(), i.first);
+    if (found.size() < targets.size())
+        printf("Found %zu of %zu addresses\n", found.size(), targets.size());
 
     return Status();
 }
@@ -598,6 +631,19 @@ Status walletGetAddress(int argc, char *argv[])
     return Status();
 }
 
+Status walletMigrateLog(int argc, char *argv[])
+{
+    if (argc != 3)
+        return ABC_ERROR(ABC_CC_Error, "usage: ... wallet-migrate-log <user> <pass> <wallet-name>");
+
+    std::shared_ptr<Login> login;
+    ABC_CHECK(cacheLoginPassword(login, argv[0], argv[1]));
+
+    ABC_CHECK_OLD(ABC_TxMigrateToLog(ABC_WalletID(*login, argv[2]), &error));
+
+    return Status();
+}
+
 Status walletOrder(int argc, char *argv[])
 {
     if (argc < 3)
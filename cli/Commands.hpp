@@ -15,6 +15,7 @@ abcd::Status accountAvailable(int argc, char *argv[]);
 abcd::Status accountDecrypt(int argc, char *argv[]);
 abcd::Status accountEncrypt(int argc, char *argv[]);
 abcd::Status addCategory(int argc, char *argv[]);
+abcd::Status calibrateScrypt(int argc, char *argv[]);
 abcd::Status changePassword(int argc, char *argv[]);
 abcd::Status checkPassword(int argc, char *argv[]);
 abcd::Status checkRecoveryAnswers(int argc, char *argv[]);
@@ -43,6 +44,7 @@ abcd::Status walletArchive(int argc, char *argv[]);
 abcd::Status walletDecrypt(int argc, char *argv[]);
 abcd::Status walletEncrypt(int argc, char *argv[]);
 abcd::Status walletGetAddress(int argc, char *argv[]);
+abcd::Status walletMigrateLog(int argc, char *argv[]);
 abcd::Status walletOrder(int argc, char *argv[]);
 
 // Implemented in its own file:
@@ -47,6 +47,7 @@ static Status run(int argc, char *argv[])
         command == "account-decrypt"    ? accountDecrypt(argc-3, argv+3) :
         command == "account-encrypt"    ? accountEncrypt(argc-3, argv+3) :
         command == "add-category"       ? addCategory(argc-3, argv+3) :
+        command == "calibrate-scrypt"   ? calibrateScrypt(argc-3, argv+3) :
         command == "change-password"    ? changePassword(argc-3, argv+3) :
         command == "check-password"     ? checkPassword(argc-3, argv+3) :
         command == "check-recovery-answers" ? checkRecoveryAnswers(argc-3, argv+3) :
@@ -75,6 +76,7 @@ static Status run(int argc, char *argv[])
         command == "wallet-decrypt"     ? walletDecrypt(argc-3, argv+3) :
         command == "wallet-encrypt"     ? walletEncrypt(argc-3, argv+3) :
         command == "wallet-get-address" ? walletGetAddress(argc-3, argv+3) :
+        command == "wallet-migrate-log" ? walletMigrateLog(argc-3, argv+3) :
         command == "wallet-order"       ? walletOrder(argc-3, argv+3) :
         // Otp.cpp:
         command == "otp-key-get"        ? otpKeyGet(argc-3, argv+3) :
@@ -28,6 +28,7 @@
  */
 
 #include "crypto_scrypt.h"
+#include "crypto_scrypt_sse2.h"
 #include "sysendian.h"
 #include <openssl/evp.h>
 #include <errno.h>
@@ -42,6 +43,17 @@ static void salsa20_8(uint8_t[64]);
 static void blockmix_salsa8(uint8_t *, uint8_t *, size_t);
 static uint64_t integerify(uint8_t *, size_t);
 static void smix(uint8_t *, size_t, uint64_t, uint8_t *, uint8_t *);
+static int sse2_supported(void);
+#if CRYPTO_SCRYPT_SSE2
+static int sse2_selected(void);
+#endif
+
+/*
+ * -1 until the first call to crypto_scrypt or crypto_scrypt_use_sse2.
+ * Several threads can be in crypto_scrypt at once, so this is only ever
+ * touched with atomic operations.
+ */
+static int use_sse2 = -1;
 
 static void
 blkcpy(uint8_t * dest, uint8_t * src, size_t len)
@@ -201,12 +213,69 @@ smix(uint8_t * B, size_t r, uint64_t N, uint8_t * V, uint8_t * XY)
 	blkcpy(B, X, 128 * r);
 }
 
+/**
+ * sse2_supported():
+ * Return non-zero if this build has the SSE2 SMix and the CPU can run it.
+ */
+static int
+sse2_supported(void)
+{
+#if CRYPTO_SCRYPT_SSE2
+	__builtin_cpu_init();
+	return (__builtin_cpu_supports("sse2"));
+#else
+	return (0);
+#endif
+}
+
+#if CRYPTO_SCRYPT_SSE2
+/**
+ * sse2_selected():
+ * Return non-zero if crypto_scrypt should use the SSE2 SMix, deciding on
+ * the first call.  Safe to call from several threads at once.
+ */
+static int
+sse2_selected(void)
+{
+	int selected = __atomic_load_n(&use_sse2, __ATOMIC_ACQUIRE);
+	int expected = -1;
+
+	if (selected < 0) {
+		selected = sse2_supported();
+
+		/* Don't clobber a choice crypto_scrypt_use_sse2 made meanwhile. */
+		if (!__atomic_compare_exchange_n(&use_sse2, &expected, selected,
+		    0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			selected = expected;
+	}
+	return (selected);
+}
+#endif
+
+/**
+ * crypto_scrypt_use_sse2(enable):
+ * Choose between the SSE2 and portable versions of SMix.  By default,
+ * crypto_scrypt uses SSE2 whenever the CPU supports it.  This exists so the
+ * two can be tested and timed against each other.
+ *
+ * Return 0 on success; or -1 if SSE2 was requested but is not available.
+ */
+int
+crypto_scrypt_use_sse2(int enable)
+{
+
+	if (enable && !sse2_supported())
+		return (-1);
+	__atomic_store_n(&use_sse2, enable ? 1 : 0, __ATOMIC_RELEASE);
+	return (0);
+}
+
 /**
  * crypto_scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen):
  * Compute scrypt(passwd[0 .. passwdlen - 1], salt[0 .. saltlen - 1], N, r,
  * p, buflen) and write the result into buf.  The parameters r, p, and buflen
  * must satisfy r * p < 2^30 and buflen <= (2^32 - 1) * 32.  The parameter N
- * must be a power of 2.
+ * must be a power of 2 greater than 1.
  *
  * Return 0 on success; or -1 on error.
  */
@@ -216,9 +285,12 @@ crypto_scrypt(const uint8_t * passwd, size_t passwdlen,
     uint8_t * buf, size_t buflen)
 {
 	uint8_t * B;
-	uint8_t * V;
-	uint8_t * XY;
+	void * V;
+	void * XY;
 	uint32_t i;
+#if CRYPTO_SCRYPT_SSE2
+	int sse2;
+#endif
 
 	/* Sanity-check parameters. */
 #if SIZE_MAX > UINT32_MAX
@@ -231,7 +303,7 @@ crypto_scrypt(const uint8_t * passwd, size_t passwdlen,
 		errno = EFBIG;
 		goto err0;
 	}
-	if (((N & (N - 1)) != 0) || (N == 0)) {
+	if (((N & (N - 1)) != 0) || (N < 2)) {
 		errno = EINVAL;
 		goto err0;
 	}
@@ -244,29 +316,40 @@ crypto_scrypt(const uint8_t * passwd, size_t passwdlen,
 		goto err0;
 	}
 
-	/* Allocate memory. */
+#if CRYPTO_SCRYPT_SSE2
+	/* Pick an SMix. */
+	sse2 = sse2_selected();
+#endif
+
+	/* Allocate memory, aligned for the SSE2 SMix. */
 	if ((B = malloc(128 * r * p)) == NULL)
 		goto err0;
-	if ((XY = malloc(256 * r)) == NULL)
+	if ((errno = posix_memalign(&XY, 64, 256 * r + 64)) != 0)
 		goto err1;
-	if ((V = malloc((unsigned long)((uint64_t) 128 * r * (uint64_t) N))) == NULL)
+	if ((errno = posix_memalign(&V, 64,
+	    (size_t)((uint64_t) 128 * r * (uint64_t) N))) != 0)
 		goto err2;
 
 	/* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
 	if (!PKCS5_PBKDF2_HMAC((char *)passwd, passwdlen, salt, saltlen,
 		1, EVP_sha256(), p * 128 * r, B))
-		goto err2;
+		goto err3;
 
 	/* 2: for i = 0 to p - 1 do */
 	for (i = 0; i < p; i++) {
 		/* 3: B_i <-- MF(B_i, N) */
-		smix(&B[i * 128 * r], r, N, V, XY);
+#if CRYPTO_SCRYPT_SSE2
+		if (sse2)
+			crypto_scrypt_smix_sse2(&B[i * 128 * r], r, N, V, XY);
+		else
+#endif
+			smix(&B[i * 128 * r], r, N, V, XY);
 	}
 
 	/* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
 	if (!PKCS5_PBKDF2_HMAC((char *)passwd, passwdlen, B, p * 128 * r,
 		1, EVP_sha256(), buflen, buf))
-		goto err2;
+		goto err3;
 
 	/* Free memory. */
 	free(V);
@@ -276,6 +359,8 @@ crypto_scrypt(const uint8_t * passwd, size_t passwdlen,
 	/* Success! */
 	return (0);
 
+err3:
+	free(V);
 err2:
 	free(XY);
 err1:
@@ -48,6 +48,15 @@ extern "C" {
 int crypto_scrypt(const uint8_t *, size_t, const uint8_t *, size_t, uint64_t,
     uint32_t, uint32_t, uint8_t *, size_t);
 
+/**
+ * crypto_scrypt_use_sse2(enable):
+ * Choose between the SSE2 and portable versions of SMix.  By default,
+ * crypto_scrypt uses SSE2 whenever the CPU supports it.
+ *
+ * Return 0 on success; or -1 if SSE2 was requested but is not available.
+ */
+int crypto_scrypt_use_sse2(int);
+
 #ifdef __cplusplus
 }
 #endif
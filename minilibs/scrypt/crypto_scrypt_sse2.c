@@ -0,0 +1,261 @@
+/*-
+ * Copyright 2009 Colin Percival
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file was originally written by Colin Percival as part of the Tarsnap
+ * online backup system.
+ */
+#include "crypto_scrypt_sse2.h"
+
+#if CRYPTO_SCRYPT_SSE2
+
+#include "sysendian.h"
+#include <emmintrin.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * These functions are built for SSE2 even when the rest of the library
+ * isn't, so crypto_scrypt must check the CPU before calling in here.
+ */
+#define SSE2 __attribute__((target("sse2")))
+
+/*
+ * Blocks are kept in a shuffled order while in this file, so each of the
+ * four vectors holds one diagonal of the salsa20 state:  word i of the
+ * stored block is word (i * 5 % 16) of the real one.  Only the rounds
+ * themselves and integerify care about the difference.
+ */
+
+SSE2 static void
+blkcpy(__m128i * dest, const __m128i * src, size_t len)
+{
+	size_t L = len / 16;
+	size_t i;
+
+	for (i = 0; i < L; i++)
+		dest[i] = src[i];
+}
+
+SSE2 static void
+blkxor(__m128i * dest, const __m128i * src, size_t len)
+{
+	size_t L = len / 16;
+	size_t i;
+
+	for (i = 0; i < L; i++)
+		dest[i] = _mm_xor_si128(dest[i], src[i]);
+}
+
+/**
+ * salsa20_8(B):
+ * Apply the salsa20/8 core to the provided (shuffled) block.
+ */
+SSE2 static void
+salsa20_8(__m128i B[4])
+{
+	__m128i X0, X1, X2, X3;
+	__m128i T;
+	size_t i;
+
+	X0 = B[0];
+	X1 = B[1];
+	X2 = B[2];
+	X3 = B[3];
+
+	for (i = 0; i < 8; i += 2) {
+#define R(x, t, b) \
+	x = _mm_xor_si128(x, _mm_slli_epi32(t, b)); \
+	x = _mm_xor_si128(x, _mm_srli_epi32(t, 32 - (b)))
+		/* Operate on "columns". */
+		T = _mm_add_epi32(X0, X3);
+		R(X1, T, 7);
+		T = _mm_add_epi32(X1, X0);
+		R(X2, T, 9);
+		T = _mm_add_epi32(X2, X1);
+		R(X3, T, 13);
+		T = _mm_add_epi32(X3, X2);
+		R(X0, T, 18);
+
+		/* Rearrange data. */
+		X1 = _mm_shuffle_epi32(X1, 0x93);
+		X2 = _mm_shuffle_epi32(X2, 0x4E);
+		X3 = _mm_shuffle_epi32(X3, 0x39);
+
+		/* Operate on "rows". */
+		T = _mm_add_epi32(X0, X1);
+		R(X3, T, 7);
+		T = _mm_add_epi32(X3, X0);
+		R(X2, T, 9);
+		T = _mm_add_epi32(X2, X3);
+		R(X1, T, 13);
+		T = _mm_add_epi32(X1, X2);
+		R(X0, T, 18);
+
+		/* Rearrange data. */
+		X1 = _mm_shuffle_epi32(X1, 0x39);
+		X2 = _mm_shuffle_epi32(X2, 0x4E);
+		X3 = _mm_shuffle_epi32(X3, 0x93);
+#undef R
+	}
+
+	B[0] = _mm_add_epi32(B[0], X0);
+	B[1] = _mm_add_epi32(B[1], X1);
+	B[2] = _mm_add_epi32(B[2], X2);
+	B[3] = _mm_add_epi32(B[3], X3);
+}
+
+/**
+ * blockmix_salsa8(Bin, Bout, X, r):
+ * Compute Bout = BlockMix_{salsa20/8, r}(Bin).  The input Bin must be 128r
+ * bytes in length; the output Bout must also be the same size.  The
+ * temporary space X must be 64 bytes.
+ */
+SSE2 static void
+blockmix_salsa8(const __m128i * Bin, __m128i * Bout, __m128i * X, size_t r)
+{
+	size_t i;
+
+	/* 1: X <-- B_{2r - 1} */
+	blkcpy(X, &Bin[8 * r - 4], 64);
+
+	/* 3: X <-- H(X \xor B_i) */
+	blkxor(X, Bin, 64);
+	salsa20_8(X);
+
+	/* 4: Y_i <-- X */
+	/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+	blkcpy(Bout, X, 64);
+
+	/* 2: for i = 0 to 2r - 1 do */
+	for (i = 0; i < r - 1; i++) {
+		/* 3: X <-- H(X \xor B_i) */
+		blkxor(X, &Bin[8 * i + 4], 64);
+		salsa20_8(X);
+
+		/* 4: Y_i <-- X */
+		/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+		blkcpy(&Bout[(r + i) * 4], X, 64);
+
+		/* 3: X <-- H(X \xor B_i) */
+		blkxor(X, &Bin[8 * i + 8], 64);
+		salsa20_8(X);
+
+		/* 4: Y_i <-- X */
+		/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+		blkcpy(&Bout[(i + 1) * 4], X, 64);
+	}
+
+	/* 3: X <-- H(X \xor B_i) */
+	blkxor(X, &Bin[8 * i + 4], 64);
+	salsa20_8(X);
+
+	/* 4: Y_i <-- X */
+	/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+	blkcpy(&Bout[(r + i) * 4], X, 64);
+}
+
+/**
+ * integerify(B, r):
+ * Return the result of parsing B_{2r-1} as a little-endian integer.
+ * Words 0 and 1 of the real block sit at 0 and 13 in the shuffled one.
+ */
+static uint64_t
+integerify(const void * B, size_t r)
+{
+	const uint32_t * X = (const uint32_t *)((uintptr_t)(B) + (2 * r - 1) * 64);
+
+	return (((uint64_t)(X[13]) << 32) + X[0]);
+}
+
+/**
+ * crypto_scrypt_smix_sse2(B, r, N, V, XY):
+ * Compute B = SMix_r(B, N).  The input B must be 128r bytes in length; the
+ * temporary storage V must be 128rN bytes in length; the temporary storage
+ * XY must be 256r + 64 bytes in length.  The value N must be a power of 2
+ * greater than 1.  The arrays V and XY must be aligned to a multiple of 64
+ * bytes.
+ */
+SSE2 void
+crypto_scrypt_smix_sse2(uint8_t * B, size_t r, uint64_t N, void * V,
+    void * XY)
+{
+	__m128i * X = XY;
+	__m128i * Y = (__m128i *)((uintptr_t)(XY) + 128 * r);
+	__m128i * Z = (__m128i *)((uintptr_t)(XY) + 256 * r);
+	uint32_t * X32 = XY;
+	uint64_t i, j;
+	size_t k;
+
+	/* 1: X <-- B */
+	for (k = 0; k < 2 * r; k++) {
+		for (i = 0; i < 16; i++) {
+			X32[k * 16 + i] =
+			    le32dec(&B[(k * 16 + (i * 5 % 16)) * 4]);
+		}
+	}
+
+	/* 2: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		/* 3: V_i <-- X */
+		blkcpy((__m128i *)((uintptr_t)(V) + i * 128 * r), X, 128 * r);
+
+		/* 4: X <-- H(X) */
+		blockmix_salsa8(X, Y, Z, r);
+
+		/* 3: V_i <-- X */
+		blkcpy((__m128i *)((uintptr_t)(V) + (i + 1) * 128 * r),
+		    Y, 128 * r);
+
+		/* 4: X <-- H(X) */
+		blockmix_salsa8(Y, X, Z, r);
+	}
+
+	/* 6: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		/* 7: j <-- Integerify(X) mod N */
+		j = integerify(X, r) & (N - 1);
+
+		/* 8: X <-- H(X \xor V_j) */
+		blkxor(X, (__m128i *)((uintptr_t)(V) + j * 128 * r), 128 * r);
+		blockmix_salsa8(X, Y, Z, r);
+
+		/* 7: j <-- Integerify(X) mod N */
+		j = integerify(Y, r) & (N - 1);
+
+		/* 8: X <-- H(X \xor V_j) */
+		blkxor(Y, (__m128i *)((uintptr_t)(V) + j * 128 * r), 128 * r);
+		blockmix_salsa8(Y, X, Z, r);
+	}
+
+	/* 10: B' <-- X */
+	for (k = 0; k < 2 * r; k++) {
+		for (i = 0; i < 16; i++) {
+			le32enc(&B[(k * 16 + (i * 5 % 16)) * 4],
+			    X32[k * 16 + i]);
+		}
+	}
+}
+
+#endif /* CRYPTO_SCRYPT_SSE2 */
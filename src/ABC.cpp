@@ -42,8 +42,11 @@
 #include "../abcd/bitcoin/Testnet.hpp"
 #include "../abcd/bitcoin/Text.hpp"
 #include "../abcd/bitcoin/WatcherBridge.hpp"
+#include "../abcd/crypto/Crypto.hpp"
 #include "../abcd/crypto/Encoding.hpp"
 #include "../abcd/crypto/Random.hpp"
+#include "../abcd/crypto/Scrypt.hpp"
+#include "../abcd/crypto/ScryptCache.hpp"
 #include "../abcd/exchange/Exchange.hpp"
 #include "../abcd/login/Lobby.hpp"
 #include "../abcd/login/Login.hpp"
@@ -155,9 +158,12 @@ void ABC_Terminate()
     if (gbInitialized == true)
     {
         ABC_ClearKeyCache(NULL);
+        scryptCacheEnable(0);
 
         ABC_URLTerminate();
 
+        watcherBridgeFlush();
+
         ABC_SyncTerminate();
 
         ABC_DebugTerminate();
@@ -650,6 +656,91 @@ tABC_CC ABC_ClearKeyCache(tABC_Error *pError)
 
     cacheLogout();
     ABC_WalletClearCache();
+    scryptCacheClear();
+    cryptoFileCacheInvalidate();
+
+exit:
+    return cc;
+}
+
+/**
+ * Remember derived password keys for a while.
+ *
+ * Checking the same password, PIN, or recovery answers again
+ * within the lifetime skips the expensive scrypt step.
+ * The keys stay in locked memory until they expire,
+ * or until ABC_ClearKeyCache wipes them.
+ *
+ * @param seconds   How long to keep each key, or 0 to turn the cache off
+ * @param pError    A pointer to the location to store the error if there is one
+ */
+tABC_CC ABC_EnableScryptCache(unsigned int seconds, tABC_Error *pError)
+{
+    ABC_DebugLog("%s called", __FUNCTION__);
+
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    ABC_CHECK_ASSERT(true == gbInitialized, ABC_CC_NotInitialized, "The core library has not been initalized");
+    ABC_CHECK_NEW(scryptCacheEnable(seconds), pError);
+
+exit:
+    return cc;
+}
+
+/**
+ * Reports how expensive scrypt is on this device,
+ * along with the client parameters chosen to match.
+ *
+ * @param pTime     Receives the microseconds taken by a default-parameter run
+ * @param pN        Receives the client N parameter
+ * @param pR        Receives the client r parameter
+ * @param pError    A pointer to the location to store the error if there is one
+ */
+tABC_CC ABC_ScryptCalibration(unsigned int *pTime,
+                              unsigned int *pN,
+                              unsigned int *pR,
+                              tABC_Error *pError)
+{
+    ABC_DebugLog("%s called", __FUNCTION__);
+
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    ABC_CHECK_ASSERT(true == gbInitialized, ABC_CC_NotInitialized, "The core library has not been initalized");
+    ABC_CHECK_NULL(pTime);
+    ABC_CHECK_NULL(pN);
+    ABC_CHECK_NULL(pR);
+
+    {
+        ScryptCalibration calibration = scryptCalibration();
+        *pTime = calibration.time;
+        *pN = calibration.N;
+        *pR = calibration.r;
+    }
+
+exit:
+    return cc;
+}
+
+/**
+ * Benchmarks scrypt again and saves the new client parameters.
+ *
+ * The library only does this on its own when the hardware changes,
+ * so call this if the saved numbers look wrong for the device.
+ * New accounts and password changes pick up the new parameters.
+ *
+ * @param pError    A pointer to the location to store the error if there is one
+ */
+tABC_CC ABC_ScryptCalibrate(tABC_Error *pError)
+{
+    ABC_DebugLog("%s called", __FUNCTION__);
+
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    ABC_CHECK_ASSERT(true == gbInitialized, ABC_CC_NotInitialized, "The core library has not been initalized");
+    ABC_CHECK_NEW(scryptCalibrate(), pError);
 
 exit:
     return cc;
@@ -2129,6 +2220,58 @@ exit:
     return cc;
 }
 
+/**
+ * Gets one page of the transactions associated with the given wallet.
+ * Only the transactions on the requested page are copied out,
+ * so listing a large wallet does not cost more than listing a small one.
+ *
+ * @param szUserName        UserName for the account associated with the transactions
+ * @param szPassword        Password for the account associated with the transactions
+ * @param szWalletUUID      UUID of the wallet associated with the transactions
+ * @param startTime         Return transactions after this time
+ * @param endTime           Return transactions before this time,
+ *                          or ABC_GET_TX_ALL_TIMES for no time limits
+ * @param szCursor          Cursor returned by the previous page,
+ *                          or NULL to start from the beginning
+ * @param limit             Maximum number of transactions to return
+ * @param order             Direction to walk through the transactions
+ * @param paTransactions    Pointer to store array of transactions info pointers
+ * @param pCount            Pointer to store number of transactions
+ * @param pszNextCursor     Pointer to store the cursor for the next page,
+ *                          or NULL if this is the last page (caller must free)
+ * @param pError            A pointer to the location to store the error if there is one
+ */
+tABC_CC ABC_GetTransactionsPage(const char *szUserName,
+                                const char *szPassword,
+                                const char *szWalletUUID,
+                                int64_t startTime,
+                                int64_t endTime,
+                                const char *szCursor,
+                                unsigned int limit,
+                                tABC_TxOrder order,
+                                tABC_TxInfo ***paTransactions,
+                                unsigned int *pCount,
+                                char **pszNextCursor,
+                                tABC_Error *pError)
+{
+    ABC_DebugLog("%s called", __FUNCTION__);
+
+    tABC_CC cc = ABC_CC_Ok;
+    ABC_SET_ERR_CODE(pError, ABC_CC_Ok);
+
+    std::shared_ptr<Login> login;
+
+    ABC_CHECK_ASSERT(true == gbInitialized, ABC_CC_NotInitialized, "The core library has not been initalized");
+
+    ABC_CHECK_NEW(cacheLogin(login, szUserName), pError);
+    ABC_CHECK_RET(ABC_TxGetTransactionsPage(ABC_WalletID(*login, szWalletUUID),
+        startTime, endTime, szCursor, limit, order == ABC_TxOrder_NewestFirst,
+        paTransactions, pCount, pszNextCursor, pError));
+
+exit:
+    return cc;
+}
+
 /**
  * Searches the transactions associated with the given wallet.
  *
@@ -375,6 +375,18 @@ typedef struct sABC_TxOutput
     int64_t  index;
 } tABC_TxOutput;
 
+/**
+ * AirBitz Transaction Listing Order
+ *
+ * Controls the direction of ABC_GetTransactionsPage.
+ *
+ */
+typedef enum eABC_TxOrder
+{
+    ABC_TxOrder_OldestFirst,
+    ABC_TxOrder_NewestFirst
+} tABC_TxOrder;
+
 /**
  * AirBitz Transaction Info
  *
@@ -585,6 +597,15 @@ tABC_CC ABC_IsTestNet(bool *pResult, tABC_Error *pError);
 /* === All data at once: === */
 tABC_CC ABC_ClearKeyCache(tABC_Error *pError);
 
+tABC_CC ABC_EnableScryptCache(unsigned int seconds, tABC_Error *pError);
+
+tABC_CC ABC_ScryptCalibration(unsigned int *pTime,
+                              unsigned int *pN,
+                              unsigned int *pR,
+                              tABC_Error *pError);
+
+tABC_CC ABC_ScryptCalibrate(tABC_Error *pError);
+
 tABC_CC ABC_DataSyncAll(const char *szUserName,
                         const char *szPassword,
                         tABC_BitCoin_Event_Callback fAsyncBitCoinEventCallback,
@@ -1076,6 +1097,19 @@ tABC_CC ABC_GetTransactions(const char *szUserName,
                             unsigned int *pCount,
                             tABC_Error *pError);
 
+tABC_CC ABC_GetTransactionsPage(const char *szUserName,
+                                const char *szPassword,
+                                const char *szWalletUUID,
+                                int64_t startTime,
+                                int64_t endTime,
+                                const char *szCursor,
+                                unsigned int limit,
+                                tABC_TxOrder order,
+                                tABC_TxInfo ***paTransactions,
+                                unsigned int *pCount,
+                                char **pszNextCursor,
+                                tABC_Error *pError);
+
 tABC_CC ABC_SearchTransactions(const char *szUserName,
                                const char *szPassword,
                                const char *szWalletUUID,
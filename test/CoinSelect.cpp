@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/bitcoin/CoinSelect.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include <chrono>
+#include <sstream>
+
+static const uint64_t dust = 5430;
+
+// 10 satoshis per byte:
+static uint64_t
+linearFees(size_t size)
+{
+    return 10 * size;
+}
+
+static uint64_t
+selectedTotal(const abcd::CoinSelection &selection,
+              const std::vector<uint64_t> &values)
+{
+    uint64_t total = 0;
+    for (auto i: selection.inputs)
+        total += values[i];
+    return total;
+}
+
+TEST_CASE("Coin selection without change", "[bitcoin][coinselect]")
+{
+    // Two inputs exactly cover the payment plus their fee:
+    const uint64_t fee = linearFees(abcd::coinSelectSize(2, 1));
+    std::vector<uint64_t> values = {90000, 30000, 50000 + fee, 1000000};
+
+    abcd::CoinSelection selection;
+    REQUIRE(abcd::coinSelect(selection, values, 80000, 1, linearFees, dust));
+    CHECK(0 == selection.change);
+    CHECK(fee == selection.fee);
+    CHECK(2 == selection.inputs.size());
+    CHECK(selectedTotal(selection, values) == 80000 + fee);
+}
+
+TEST_CASE("Coin selection with change", "[bitcoin][coinselect]")
+{
+    std::vector<uint64_t> values = {500000, 300000, 200000};
+
+    abcd::CoinSelection selection;
+    REQUIRE(abcd::coinSelect(selection, values, 250000, 1, linearFees, dust));
+
+    // The smallest single output that covers everything:
+    REQUIRE(1 == selection.inputs.size());
+    CHECK(1 == selection.inputs[0]);
+    CHECK(linearFees(abcd::coinSelectSize(1, 2)) == selection.fee);
+    CHECK(selection.change == 300000 - 250000 - selection.fee);
+
+    // Everything adds up, whichever way the selection went:
+    for (uint64_t target: {1000, 450000, 700000, 990000})
+    {
+        REQUIRE(abcd::coinSelect(selection, values, target, 2, linearFees, dust));
+        CHECK(selectedTotal(selection, values) ==
+            target + selection.fee + selection.change);
+        CHECK((!selection.change || dust <= selection.change));
+        CHECK(linearFees(abcd::coinSelectSize(selection.inputs.size(),
+            selection.change ? 3 : 2)) <= selection.fee);
+    }
+}
+
+TEST_CASE("Coin selection failures", "[bitcoin][coinselect]")
+{
+    abcd::CoinSelection selection;
+    CHECK_FALSE(abcd::coinSelect(selection, {}, 1000, 1, linearFees, dust));
+
+    // The funds cover the payment, but not the fee:
+    std::vector<uint64_t> values = {60000, 40000};
+    CHECK_FALSE(abcd::coinSelect(selection, values, 100000, 1, linearFees, dust));
+    CHECK(linearFees(abcd::coinSelectSize(2, 1)) == selection.fee);
+}
+
+// Hidden, since it is slow. Run with `abc-test "[bench]"`.
+TEST_CASE("Coin selection benchmark", "[bitcoin][coinselect][bench][.]")
+{
+    for (size_t count: {10, 100, 1000, 10000, 100000})
+    {
+        // Mostly small outputs, with the odd large one:
+        std::vector<uint64_t> values;
+        uint64_t seed = 12345, total = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            seed = seed * 6364136223846793005 + 1442695040888963407;
+            uint64_t value = 10000 + (seed >> 33) % 1000000;
+            if (!(seed >> 20 & 31))
+                value *= 50;
+            values.push_back(value);
+            total += value;
+        }
+
+        const int runs = 100000 / count + 1;
+        unsigned changeless = 0;
+        abcd::CoinSelection selection;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+        {
+            uint64_t target = total / (2 + i % 7);
+            REQUIRE(abcd::coinSelect(selection, values, target, 2,
+                linearFees, dust));
+            if (!selection.change)
+                ++changeless;
+        }
+        std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+
+        std::stringstream message;
+        message << count << " outputs: " << time.count() * 1000000 / runs <<
+            " us per selection, " << changeless << " of " << runs <<
+            " without change";
+        WARN(message.str());
+    }
+}
@@ -9,6 +9,10 @@
 #include "../abcd/crypto/Encoding.hpp"
 #include "../abcd/json/JsonFile.hpp"
 #include "../minilibs/catch/catch.hpp"
+#include "TempDir.hpp"
+#include <stdio.h>
+#include <chrono>
+#include <sstream>
 
 // sha256("Satoshi"):
 static const char keyHex[] =
@@ -56,16 +60,235 @@ TEST_CASE("Encryption round-trip", "[crypto][encryption]")
     abcd::base16Decode(key, keyHex);
     const std::string payload("payload");
 
+    for (auto type: {abcd::ABC_CryptoType_AES256, abcd::ABC_CryptoType_AES256_GCM})
+    {
+        json_t *json = nullptr;
+        CHECK(ABC_CC_Ok == ABC_CryptoEncryptJSONObject(
+            abcd::toU08Buf(payload), abcd::toU08Buf(key),
+            type, &json, &error));
+
+        abcd::AutoU08Buf data;
+        CHECK(ABC_CC_Ok == ABC_CryptoDecryptJSONObject(
+            json, abcd::toU08Buf(key), &data, &error));
+        CHECK(abcd::toString(abcd::U08Buf(data)) == payload);
+
+        if (json)
+            json_decref(json);
+    }
+}
+
+TEST_CASE("Authenticated encryption", "[crypto][encryption]")
+{
+    tABC_Error error;
+    abcd::DataChunk key;
+    abcd::base16Decode(key, keyHex);
+    const std::string payload("payload");
+
     json_t *json = nullptr;
-    CHECK(ABC_CC_Ok == ABC_CryptoEncryptJSONObject(
+    REQUIRE(ABC_CC_Ok == ABC_CryptoEncryptJSONObject(
         abcd::toU08Buf(payload), abcd::toU08Buf(key),
-        abcd::ABC_CryptoType_AES256, &json, &error));
+        abcd::ABC_CryptoType_AES256_GCM, &json, &error));
+    abcd::JsonFile package(json);
 
-    abcd::AutoU08Buf data;
-    CHECK(ABC_CC_Ok == ABC_CryptoDecryptJSONObject(
-        json, abcd::toU08Buf(key), &data, &error));
-    CHECK(abcd::toString(abcd::U08Buf(data)) == payload);
+    // No padding, just the tag:
+    abcd::DataChunk data;
+    REQUIRE(abcd::base64Decode(data, json_string_value(
+        json_object_get(package.root(), "data_base64"))));
+    CHECK(data.size() == payload.size() + 16);
+
+    SECTION("wrong key")
+    {
+        key[0] ^= 1;
+        abcd::AutoU08Buf out;
+        CHECK(ABC_CC_DecryptFailure == ABC_CryptoDecryptJSONObject(
+            package.root(), abcd::toU08Buf(key), &out, &error));
+    }
+    SECTION("tampered data")
+    {
+        data[0] ^= 1;
+        json_object_set_new(package.root(), "data_base64",
+            json_string(abcd::base64Encode(data).c_str()));
+        abcd::AutoU08Buf out;
+        CHECK(ABC_CC_DecryptFailure == ABC_CryptoDecryptJSONObject(
+            package.root(), abcd::toU08Buf(key), &out, &error));
+    }
+}
+
+TEST_CASE("Decrypted file cache", "[crypto][encryption]")
+{
+    tABC_Error error;
+    abcd::DataChunk key;
+    abcd::base16Decode(key, keyHex);
+    TempDir tmp;
+    const std::string path = tmp.path("file.json");
+    const std::string other = tmp.path("other.json");
+
+    auto save = [&](const std::string &filename, const std::string &payload)
+    {
+        REQUIRE(ABC_CC_Ok == ABC_CryptoEncryptJSONFile(
+            abcd::toU08Buf(payload), abcd::toU08Buf(key),
+            abcd::ABC_CryptoType_AES256, filename.c_str(), &error));
+    };
+    auto load = [&](const abcd::DataChunk &key) -> std::string
+    {
+        abcd::AutoU08Buf data;
+        if (ABC_CC_Ok != ABC_CryptoDecryptJSONFile(
+            path.c_str(), abcd::toU08Buf(key), &data, &error))
+            return "<error>";
+        return abcd::toString(abcd::U08Buf(data));
+    };
+
+    save(path, "one");
+    CHECK(load(key) == "one");
+    CHECK(load(key) == "one");
+
+    SECTION("local write")
+    {
+        save(path, "two");
+        CHECK(load(key) == "two");
+    }
+    SECTION("outside write")
+    {
+        save(other, "three");
+        REQUIRE(0 == rename(other.c_str(), path.c_str()));
+        CHECK(load(key) == "three");
+    }
+    SECTION("wrong key")
+    {
+        abcd::DataChunk wrong = key;
+        wrong[0] ^= 1;
+        CHECK(load(wrong) == "<error>");
+    }
+    SECTION("deleted file")
+    {
+        REQUIRE(0 == remove(path.c_str()));
+        CHECK(load(key) == "<error>");
+    }
+
+    abcd::cryptoFileCacheInvalidate(tmp.path());
+}
+
+TEST_CASE("Batch decryption", "[crypto][encryption]")
+{
+    tABC_Error error;
+    abcd::DataChunk key;
+    abcd::base16Decode(key, keyHex);
+    TempDir tmp;
+
+    std::vector<abcd::DecryptJob> jobs;
+    for (int i = 0; i < 20; ++i)
+    {
+        const std::string payload = "{\"n\": " + std::to_string(i) + "}";
+        const std::string path = tmp.path(std::to_string(i) + ".json");
+        REQUIRE(ABC_CC_Ok == ABC_CryptoEncryptJSONFile(
+            abcd::toU08Buf(payload), abcd::toU08Buf(key),
+            abcd::ABC_CryptoType_AES256, path.c_str(), &error));
+
+        // Every third job comes from memory rather than a file:
+        std::string encrypted;
+        if (0 == i % 3)
+        {
+            abcd::JsonFile file;
+            REQUIRE(file.load(path));
+            REQUIRE(file.encode(encrypted));
+        }
+        jobs.push_back(abcd::DecryptJob{path, encrypted, abcd::toU08Buf(key), nullptr});
+    }
+
+    SECTION("in order")
+    {
+        REQUIRE(ABC_CC_Ok == ABC_CryptoDecryptJSONBatch(jobs, &error));
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            REQUIRE(jobs[i].result);
+            CHECK(json_integer_value(json_object_get(jobs[i].result, "n")) == static_cast<json_int_t>(i));
+            json_decref(jobs[i].result);
+        }
+    }
+    SECTION("missing file")
+    {
+        jobs[7].filename += ".missing";
+        CHECK(ABC_CC_Ok != ABC_CryptoDecryptJSONBatch(jobs, &error));
+        for (const auto &job: jobs)
+            CHECK(!job.result);
+    }
+
+    abcd::cryptoFileCacheInvalidate(tmp.path());
+}
+
+TEST_CASE("Decrypt into buffer", "[crypto][encryption]")
+{
+    tABC_Error error;
+    abcd::DataChunk key;
+    abcd::base16Decode(key, keyHex);
+    const std::string payload("payload");
+
+    abcd::DataChunk data;
+    for (auto type: {abcd::ABC_CryptoType_AES256, abcd::ABC_CryptoType_AES256_GCM})
+    {
+        json_t *json = nullptr;
+        REQUIRE(ABC_CC_Ok == ABC_CryptoEncryptJSONObject(
+            abcd::toU08Buf(payload), abcd::toU08Buf(key),
+            type, &json, &error));
+        abcd::JsonFile package(json);
+
+        // The buffer gets reused, so stale contents must not leak through:
+        data.assign(1000, 'x');
+        CHECK(ABC_CC_Ok == ABC_CryptoDecryptJSONObject(
+            package.root(), abcd::DataSlice(key), data, &error));
+        CHECK(abcd::toString(data) == payload);
+
+        key[0] ^= 1;
+        CHECK(ABC_CC_DecryptFailure == ABC_CryptoDecryptJSONObject(
+            package.root(), abcd::DataSlice(key), data, &error));
+        CHECK(data.empty());
+        key[0] ^= 1;
+    }
+}
+
+// Hidden, since it is slow. Run with `abc-test "[bench]"`.
+TEST_CASE("Encryption benchmark", "[crypto][encryption][bench][.]")
+{
+    tABC_Error error;
+    abcd::DataChunk key;
+    abcd::base16Decode(key, keyHex);
+    const int runs = 2000;
+
+    // Typical wallet records run from one to four kilobytes:
+    for (size_t size: {1024, 4096})
+    {
+        const std::string payload(size, 'x');
+        for (auto type: {abcd::ABC_CryptoType_AES256, abcd::ABC_CryptoType_AES256_GCM})
+        {
+            json_t *json = nullptr;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < runs; ++i)
+            {
+                if (json)
+                    json_decref(json);
+                REQUIRE(ABC_CC_Ok == ABC_CryptoEncryptJSONObject(
+                    abcd::toU08Buf(payload), abcd::toU08Buf(key),
+                    type, &json, &error));
+            }
+            std::chrono::duration<double> encryptTime =
+                std::chrono::steady_clock::now() - start;
+            abcd::JsonFile package(json);
+
+            abcd::DataChunk data;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < runs; ++i)
+                REQUIRE(ABC_CC_Ok == ABC_CryptoDecryptJSONObject(
+                    package.root(), abcd::DataSlice(key), data, &error));
+            std::chrono::duration<double> decryptTime =
+                std::chrono::steady_clock::now() - start;
 
-    if (json)
-        json_decref(json);
+            const double megabytes = double(size) * runs / (1024 * 1024);
+            std::stringstream message;
+            message << size << " bytes, " <<
+                (abcd::ABC_CryptoType_AES256 == type ? "AES256-CBC" : "AES256-GCM") <<
+                ": encrypt " << megabytes / encryptTime.count() << " MB/s" <<
+                ", decrypt " << megabytes / decryptTime.count() << " MB/s";
+            WARN(message.str());
+        }
+    }
 }
@@ -7,6 +7,8 @@
 
 #include "../abcd/crypto/Encoding.hpp"
 #include "../minilibs/catch/catch.hpp"
+#include <chrono>
+#include <sstream>
 
 TEST_CASE("RFC 4648 base16 test vectors", "[crypto][base16]")
 {
@@ -151,3 +153,76 @@ TEST_CASE("Bad base64 strings", "[crypto][base64]")
     REQUIRE_FALSE(abcd::base64Decode(result, "AAAA===="));
     REQUIRE_FALSE(abcd::base64Decode(result, "A==="));
 }
+
+TEST_CASE("Long encoding round trips", "[crypto][encoding]")
+{
+    // Every length through several whole chunks, plus each tail size:
+    for (size_t size = 0; size < 100; ++size)
+    {
+        abcd::DataChunk data(size);
+        for (size_t i = 0; i < size; ++i)
+            data[i] = 37 * i + size;
+
+        abcd::DataChunk result;
+        REQUIRE(abcd::base16Decode(result, abcd::base16Encode(data)));
+        REQUIRE(result == data);
+        REQUIRE(abcd::base32Decode(result, abcd::base32Encode(data)));
+        REQUIRE(result == data);
+        REQUIRE(abcd::base64Decode(result, abcd::base64Encode(data)));
+        REQUIRE(result == data);
+    }
+
+    abcd::DataChunk result;
+    REQUIRE(abcd::base16Decode(result, "00FFaBcD"));
+    CHECK(abcd::base16Encode(result) == "00ffabcd");
+}
+
+TEST_CASE("Bad characters inside long strings", "[crypto][encoding]")
+{
+    abcd::DataChunk result;
+    REQUIRE_FALSE(abcd::base16Decode(result, "00g0000000"));
+    REQUIRE_FALSE(abcd::base16Decode(result, "00==000000"));
+    REQUIRE_FALSE(abcd::base32Decode(result, "AAAA1AAAAAAAAAAA"));
+    REQUIRE_FALSE(abcd::base64Decode(result, "AA-AAAAA"));
+    REQUIRE_FALSE(abcd::base64Decode(result, "AA==AAAA"));
+    REQUIRE_FALSE(abcd::base64Decode(result, std::string("AA\xff" "AAAAA")));
+}
+
+// Hidden, since it is slow. Run with `abc-test "[bench]"`.
+TEST_CASE("Encoding benchmark", "[crypto][encoding][bench][.]")
+{
+    // About the size of an encrypted wallet record:
+    abcd::DataChunk data(4096);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = 37 * i;
+    const int runs = 5000;
+
+    auto measure = [&](const char *name,
+        std::string (*encode)(abcd::DataSlice),
+        abcd::Status (*decode)(abcd::DataChunk &, const std::string &))
+    {
+        std::string text;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+            text = encode(data);
+        std::chrono::duration<double> encodeTime =
+            std::chrono::steady_clock::now() - start;
+
+        abcd::DataChunk result;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+            REQUIRE(decode(result, text));
+        std::chrono::duration<double> decodeTime =
+            std::chrono::steady_clock::now() - start;
+
+        const double megabytes = double(data.size()) * runs / (1024 * 1024);
+        std::stringstream message;
+        message << name << ": encode " << megabytes / encodeTime.count() <<
+            " MB/s, decode " << megabytes / decodeTime.count() << " MB/s";
+        WARN(message.str());
+    };
+
+    measure("base16", abcd::base16Encode, abcd::base16Decode);
+    measure("base32", abcd::base32Encode, abcd::base32Decode);
+    measure("base64", abcd::base64Encode, abcd::base64Decode);
+}
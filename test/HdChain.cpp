@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/bitcoin/HdChain.hpp"
+#include "../abcd/crypto/Encoding.hpp"
+#include "../minilibs/catch/catch.hpp"
+
+// sha256("Satoshi"):
+static const char seedHex[] =
+    "002688cc350a5333a87fa622eacec626c3d1c0ebf9f3793de3885fa254d7e393";
+
+TEST_CASE("HdChain derivation", "[bitcoin][hd]")
+{
+    abcd::DataChunk seed;
+    REQUIRE(abcd::base16Decode(seed, seedHex));
+    abcd::HdChain chain(seed);
+
+    // Walk the full path by hand for comparison:
+    libwallet::hd_private_key m(bc::data_chunk(seed.begin(), seed.end()));
+    libwallet::hd_private_key m00 =
+        m.generate_private_key(0).generate_private_key(0);
+
+    SECTION("single keys")
+    {
+        std::string address, key;
+        REQUIRE(chain.pubAddress(address, 7));
+        REQUIRE(chain.privateKey(key, 7));
+        CHECK(address == m00.generate_private_key(7).address().encoded());
+        CHECK(key == bc::encode_hex(m00.generate_private_key(7).private_key()));
+    }
+    SECTION("ranges")
+    {
+        // Large enough to use several threads:
+        auto addresses = chain.pubAddresses(10, 100);
+        REQUIRE(100 == addresses.size());
+        for (uint32_t i = 0; i < addresses.size(); ++i)
+            CHECK(addresses[i] == m00.generate_private_key(10 + i).address().encoded());
+
+        CHECK(chain.pubAddresses(0, 0).empty());
+    }
+    SECTION("search")
+    {
+        abcd::ShortHashSet targets;
+        targets.insert(m00.generate_private_key(5).address().hash());
+        targets.insert(m00.generate_private_key(2500).address().hash());
+
+        uint64_t checked = 0;
+        auto found = chain.search(targets, 0, 4000,
+            [&](uint64_t n) { checked = n; });
+        REQUIRE(2 == found.size());
+        CHECK(found.count(5));
+        CHECK(found.count(2500));
+        CHECK(0 < checked);
+
+        // Out-of-range targets stay missing, and the whole range gets checked:
+        found = chain.search(targets, 10, 20,
+            [&](uint64_t n) { checked = n; });
+        CHECK(found.empty());
+        CHECK(11 == checked);
+    }
+}
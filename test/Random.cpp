@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/crypto/Random.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include <openssl/rand.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <sstream>
+
+TEST_CASE("Random data", "[crypto][random]")
+{
+    abcd::DataChunk a, b;
+    REQUIRE(abcd::randomData(a, 32));
+    REQUIRE(abcd::randomData(b, 32));
+    CHECK(32 == a.size());
+    CHECK(a != b);
+
+    // Bigger than the buffer:
+    REQUIRE(abcd::randomData(a, 100000));
+    CHECK(100000 == a.size());
+
+    REQUIRE(abcd::randomData(a, 0));
+    CHECK(a.empty());
+
+    std::string uuid;
+    REQUIRE(abcd::randomUuid(uuid));
+    CHECK(36 == uuid.size());
+    CHECK('4' == uuid[14]);
+}
+
+TEST_CASE("Random data after fork", "[crypto][random]")
+{
+    // Leave some bytes sitting in the buffer:
+    abcd::DataChunk parent, child;
+    REQUIRE(abcd::randomData(parent, 1));
+
+    int fds[2];
+    REQUIRE(0 == pipe(fds));
+    pid_t pid = fork();
+    REQUIRE(0 <= pid);
+    if (!pid)
+    {
+        abcd::randomData(child, 16);
+        ssize_t written = write(fds[1], child.data(), child.size());
+        _exit(16 == written ? 0 : 1);
+    }
+
+    REQUIRE(abcd::randomData(parent, 16));
+    child.resize(16);
+    CHECK(16 == read(fds[0], child.data(), child.size()));
+    int status;
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    CHECK(parent != child);
+}
+
+// Hidden, since it is slow. Run with `abc-test "[bench]"`.
+TEST_CASE("Random data benchmark", "[crypto][random][bench][.]")
+{
+    // The requests made to write one encrypted file:
+    const std::initializer_list<size_t> sizes = {16, 2, 256};
+    const int runs = 100000;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
+    {
+        for (auto size: sizes)
+        {
+            abcd::DataChunk data(size);
+            REQUIRE(RAND_bytes(data.data(), data.size()));
+        }
+    }
+    std::chrono::duration<double, std::micro> direct =
+        std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
+    {
+        for (auto size: sizes)
+        {
+            abcd::DataChunk data;
+            REQUIRE(abcd::randomData(data, size));
+        }
+    }
+    std::chrono::duration<double, std::micro> pooled =
+        std::chrono::steady_clock::now() - start;
+
+    std::stringstream message;
+    message << "Per file write: RAND_bytes " << direct.count() / runs << " us" <<
+        ", randomData " << pooled.count() / runs << " us" <<
+        " (" << direct.count() / pooled.count() << "x)";
+    WARN(message.str());
+}
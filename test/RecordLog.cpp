@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/util/FileIO.hpp"
+#include "../abcd/util/RecordLog.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include "TempDir.hpp"
+#include <time.h>
+
+static std::string
+get(const abcd::RecordLog &log, const std::string &key)
+{
+    abcd::DataChunk data;
+    if (!log.get(data, key))
+        return "<none>";
+    return abcd::toString(data);
+}
+
+TEST_CASE("RecordLog round trip", "[util][log]")
+{
+    TempDir tmp;
+    const std::string dir = tmp.path("log");
+    {
+        abcd::RecordLog log(dir, "a");
+        REQUIRE(log.load());
+        REQUIRE(log.set("Transactions/1", std::string("one")));
+        REQUIRE(log.set("Transactions/2", std::string("two")));
+        REQUIRE(log.set("Addresses/1", std::string("addr")));
+        REQUIRE(log.set("Transactions/1", std::string("uno")));
+        REQUIRE(log.erase("Transactions/2"));
+    }
+
+    abcd::RecordLog log(dir, "a");
+    REQUIRE(log.load());
+    CHECK(get(log, "Transactions/1") == "uno");
+    CHECK(get(log, "Transactions/2") == "<none>");
+    CHECK(get(log, "Addresses/1") == "addr");
+
+    auto keys = log.keys("Transactions/");
+    REQUIRE(1 == keys.size());
+    CHECK(keys.front() == "Transactions/1");
+
+    SECTION("compaction")
+    {
+        REQUIRE(log.compact());
+        abcd::RecordLog reloaded(dir, "a");
+        REQUIRE(reloaded.load());
+        CHECK(get(reloaded, "Transactions/1") == "uno");
+        CHECK(get(reloaded, "Transactions/2") == "<none>");
+        CHECK(get(reloaded, "Addresses/1") == "addr");
+    }
+}
+
+TEST_CASE("RecordLog multiple writers", "[util][log]")
+{
+    TempDir tmp;
+    const std::string dir = tmp.path("log");
+    abcd::RecordLog a(dir, "a");
+    abcd::RecordLog b(dir, "b");
+    REQUIRE(a.load());
+    REQUIRE(a.set("x", std::string("from a")));
+    REQUIRE(b.load());
+    REQUIRE(b.set("x", std::string("from b")));
+    REQUIRE(b.set("y", std::string("only b")));
+
+    // The newer write wins, regardless of which writer made it:
+    REQUIRE(a.load());
+    CHECK(get(a, "x") == "from b");
+    CHECK(get(a, "y") == "only b");
+
+    // Compacting one writer leaves the other's records alone:
+    REQUIRE(a.compact());
+    REQUIRE(a.load());
+    CHECK(get(a, "x") == "from b");
+}
+
+TEST_CASE("RecordLog stamps", "[util][log]")
+{
+    TempDir tmp;
+    const std::string dir = tmp.path("log");
+    abcd::RecordLog log(dir, "a");
+    REQUIRE(log.load());
+    CHECK(0 == log.stamp("x"));
+
+    const uint64_t before = time(nullptr) * UINT64_C(1000000);
+    REQUIRE(log.set("x", std::string("one")));
+    const uint64_t written = log.stamp("x");
+    CHECK(before <= written);
+
+    // Erasing a key still records when that happened:
+    REQUIRE(log.erase("x"));
+    CHECK(written < log.stamp("x"));
+
+    // The stamps survive a reload:
+    const uint64_t erased = log.stamp("x");
+    abcd::RecordLog reloaded(dir, "a");
+    REQUIRE(reloaded.load());
+    CHECK(erased == reloaded.stamp("x"));
+}
+
+TEST_CASE("RecordLog deletions", "[util][log]")
+{
+    TempDir tmp;
+
+    for (bool shared: {true, false})
+    {
+        const std::string dir = tmp.path(shared ? "shared" : "private");
+        abcd::RecordLog log(dir, "a", shared);
+        REQUIRE(log.load());
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(log.set("key" + std::to_string(i), std::string("data")));
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(log.erase("key" + std::to_string(i)));
+        REQUIRE(log.compact());
+        CHECK(log.keys().empty());
+
+        // Only a shared log has to remember its deletions:
+        abcd::RecordLog reloaded(dir, "a", shared);
+        REQUIRE(reloaded.load());
+        CHECK(reloaded.keys().empty());
+        CHECK(shared == (0 != reloaded.stamp("key7")));
+    }
+}
+
+TEST_CASE("RecordLog torn write", "[util][log]")
+{
+    TempDir tmp;
+    const std::string dir = tmp.path("log");
+    {
+        abcd::RecordLog log(dir, "a");
+        REQUIRE(log.load());
+        REQUIRE(log.set("good", std::string("data")));
+    }
+
+    // Simulate a crash partway through appending a record:
+    const std::string segment = dir + "/a-00000000.log";
+    abcd::DataChunk data;
+    REQUIRE(abcd::fileLoad(data, segment));
+    data.insert(data.end(), {0x12, 0x34, 0x56});
+    REQUIRE(abcd::fileSave(data, segment));
+
+    abcd::RecordLog log(dir, "a");
+    REQUIRE(log.load());
+    CHECK(get(log, "good") == "data");
+
+    // New writes must survive the damaged tail:
+    REQUIRE(log.set("later", std::string("more")));
+    abcd::RecordLog reloaded(dir, "a");
+    REQUIRE(reloaded.load());
+    CHECK(get(reloaded, "good") == "data");
+    CHECK(get(reloaded, "later") == "more");
+}
+
+TEST_CASE("RecordLog sealing", "[util][log]")
+{
+    TempDir tmp;
+    const std::string dir = tmp.path("log");
+    const std::string first = dir + "/a-00000000.log";
+    abcd::DataChunk synced;
+    {
+        abcd::RecordLog log(dir, "a");
+        REQUIRE(log.load());
+        REQUIRE(log.set("x", std::string("one")));
+        log.seal();
+        REQUIRE(abcd::fileLoad(synced, first));
+
+        // Writes after a seal leave the old segment alone:
+        REQUIRE(log.set("y", std::string("two")));
+        abcd::DataChunk data;
+        REQUIRE(abcd::fileLoad(data, first));
+        CHECK(data == synced);
+    }
+
+    // So do writes from a later session:
+    abcd::RecordLog log(dir, "a");
+    REQUIRE(log.load());
+    REQUIRE(log.set("z", std::string("three")));
+    abcd::DataChunk data;
+    REQUIRE(abcd::fileLoad(data, first));
+    CHECK(data == synced);
+
+    abcd::RecordLog reloaded(dir, "a");
+    REQUIRE(reloaded.load());
+    CHECK(get(reloaded, "x") == "one");
+    CHECK(get(reloaded, "y") == "two");
+    CHECK(get(reloaded, "z") == "three");
+}
+
+TEST_CASE("RecordLog group commit", "[util][log]")
+{
+    TempDir tmp;
+    const std::string dir = tmp.path("log");
+    abcd::RecordLog log(dir, "a");
+    REQUIRE(log.load());
+
+    log.begin();
+    REQUIRE(log.set("x", std::string("one")));
+    REQUIRE(log.set("y", std::string("two")));
+    REQUIRE(log.erase("x"));
+
+    // Reads see the batch right away, but the disk doesn't:
+    CHECK(get(log, "x") == "<none>");
+    CHECK(get(log, "y") == "two");
+    abcd::RecordLog before(dir, "a");
+    REQUIRE(before.load());
+    CHECK(get(before, "y") == "<none>");
+
+    REQUIRE(log.commit());
+    abcd::RecordLog after(dir, "a");
+    REQUIRE(after.load());
+    CHECK(get(after, "x") == "<none>");
+    CHECK(get(after, "y") == "two");
+}
@@ -7,7 +7,15 @@
 
 #include "../abcd/crypto/Scrypt.hpp"
 #include "../abcd/crypto/Encoding.hpp"
+#include "../abcd/crypto/ScryptCache.hpp"
+#include "../abcd/json/JsonObject.hpp"
+#include "../abcd/util/FileIO.hpp"
 #include "../minilibs/catch/catch.hpp"
+#include "../minilibs/scrypt/crypto_scrypt.h"
+#include "TempDir.hpp"
+#include <chrono>
+#include <sstream>
+#include <thread>
 
 TEST_CASE("Scrypt RFC test vectors", "[crypto][scrypt]")
 {
@@ -63,15 +71,189 @@ TEST_CASE("Scrypt RFC test vectors", "[crypto][scrypt]")
 #endif
     };
 
-    for (auto &test: cases)
+    auto check = [&]()
     {
-        abcd::AutoU08Buf out;
-        tABC_Error error;
+        for (auto &test: cases)
+        {
+            abcd::AutoU08Buf out;
+            tABC_Error error;
+
+            CHECK(ABC_CC_Ok == abcd::ABC_CryptoScrypt(
+                abcd::toU08Buf(test.password), abcd::toU08Buf(test.salt),
+                test.N, test.r, test.p, test.dklen, &out, &error));
+
+            CHECK(abcd::base16Encode(abcd::U08Buf(out)) == test.result);
+        }
+    };
+
+    SECTION("portable")
+    {
+        REQUIRE(0 == crypto_scrypt_use_sse2(0));
+        check();
+    }
+    SECTION("sse2")
+    {
+        if (0 == crypto_scrypt_use_sse2(1))
+            check();
+    }
+
+    // Back to the default:
+    crypto_scrypt_use_sse2(1);
+}
+
+TEST_CASE("Scrypt batch", "[crypto][scrypt]")
+{
+    const std::string password = "password";
+    const std::string salt1 = "salt1";
+    const std::string salt2 = "salt2";
+    abcd::tABC_CryptoSNRP snrp1 = {abcd::toU08Buf(salt1), 16, 1, 1};
+    abcd::tABC_CryptoSNRP snrp2 = {abcd::toU08Buf(salt2), 16, 2, 1};
+    tABC_Error error;
+
+    abcd::AutoU08Buf one, two;
+    REQUIRE(ABC_CC_Ok == abcd::ABC_CryptoScryptSNRPs({
+        {abcd::toU08Buf(password), &snrp1, &one},
+        {abcd::toU08Buf(password), &snrp2, &two}}, &error));
+
+    // The results should match a serial run:
+    abcd::AutoU08Buf expected1, expected2;
+    REQUIRE(ABC_CC_Ok == abcd::ABC_CryptoScryptSNRP(
+        abcd::toU08Buf(password), &snrp1, &expected1, &error));
+    REQUIRE(ABC_CC_Ok == abcd::ABC_CryptoScryptSNRP(
+        abcd::toU08Buf(password), &snrp2, &expected2, &error));
+    CHECK(abcd::base16Encode(abcd::U08Buf(one)) ==
+          abcd::base16Encode(abcd::U08Buf(expected1)));
+    CHECK(abcd::base16Encode(abcd::U08Buf(two)) ==
+          abcd::base16Encode(abcd::U08Buf(expected2)));
+
+    // Failures come back out:
+    CHECK(ABC_CC_Ok != abcd::ABC_CryptoScryptSNRPs({
+        {abcd::toU08Buf(password), &snrp1, nullptr}}, &error));
+}
+
+TEST_CASE("Scrypt calibration", "[crypto][scrypt]")
+{
+    TempDir tmp;
+    const std::string oldRoot = abcd::getRootDir();
+    abcd::setRootDir(tmp.path());
+    const std::string path = abcd::getRootDir() + "Scrypt.json";
+    tABC_Error error;
 
-        CHECK(ABC_CC_Ok == abcd::ABC_CryptoScrypt(
-            abcd::toU08Buf(test.password), abcd::toU08Buf(test.salt),
-            test.N, test.r, test.p, test.dklen, &out, &error));
+    // Benchmarks and saves:
+    REQUIRE(ABC_CC_Ok == abcd::ABC_InitializeCrypto(&error));
+    auto measured = abcd::scryptCalibration();
+    CHECK(0 < measured.time);
+    CHECK(16384 <= measured.N);
+    CHECK(1 <= measured.r);
+
+    // Uses the saved results from then on:
+    abcd::JsonObject json;
+    REQUIRE(json.load(path));
+    REQUIRE(json.setValue("n", json_integer(32768)));
+    REQUIRE(json.setValue("r", json_integer(2)));
+    REQUIRE(json.save(path));
+    REQUIRE(ABC_CC_Ok == abcd::ABC_InitializeCrypto(&error));
+    CHECK(32768 == abcd::scryptCalibration().N);
+    CHECK(2 == abcd::scryptCalibration().r);
+
+    // Results from other hardware don't count:
+    REQUIRE(json.setValue("hardware", json_string("abacus")));
+    REQUIRE(json.save(path));
+    REQUIRE(ABC_CC_Ok == abcd::ABC_InitializeCrypto(&error));
+    REQUIRE(json.load(path));
+    CHECK(std::string("abacus") != json.getString("hardware", ""));
+
+    abcd::setRootDir(oldRoot);
+}
+
+TEST_CASE("Scrypt cache", "[crypto][scrypt]")
+{
+    const std::string password = "password";
+    const std::string salt = "salt";
+    abcd::tABC_CryptoSNRP snrp = {abcd::toU08Buf(salt), 16, 1, 1};
+    abcd::DataArray<32> cached;
+    tABC_Error error;
 
-        CHECK(abcd::base16Encode(abcd::U08Buf(out)) == test.result);
+    auto lookup = [&](const std::string &data) -> bool
+    {
+        return abcd::scryptCacheGet(cached.data(), cached.size(),
+            data, salt, snrp.N, snrp.r, snrp.p);
+    };
+
+    // Off by default:
+    abcd::AutoU08Buf first;
+    REQUIRE(ABC_CC_Ok == abcd::ABC_CryptoScryptSNRP(
+        abcd::toU08Buf(password), &snrp, &first, &error));
+    CHECK(!lookup(password));
+
+    REQUIRE(abcd::scryptCacheEnable(1));
+    abcd::AutoU08Buf second;
+    REQUIRE(ABC_CC_Ok == abcd::ABC_CryptoScryptSNRP(
+        abcd::toU08Buf(password), &snrp, &second, &error));
+    REQUIRE(lookup(password));
+    CHECK(abcd::base16Encode(cached) == abcd::base16Encode(abcd::U08Buf(first)));
+    CHECK(!lookup("other"));
+
+    SECTION("hit")
+    {
+        abcd::AutoU08Buf third;
+        REQUIRE(ABC_CC_Ok == abcd::ABC_CryptoScryptSNRP(
+            abcd::toU08Buf(password), &snrp, &third, &error));
+        CHECK(abcd::base16Encode(abcd::U08Buf(third)) ==
+              abcd::base16Encode(abcd::U08Buf(first)));
+    }
+    SECTION("clear")
+    {
+        abcd::scryptCacheClear();
+        CHECK(!lookup(password));
+    }
+    SECTION("expiry")
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        CHECK(!lookup(password));
+    }
+
+    REQUIRE(abcd::scryptCacheEnable(0));
+    CHECK(!lookup(password));
+}
+
+// Hidden, since it is slow. Run with `abc-test "[bench]"`.
+TEST_CASE("Scrypt benchmark", "[crypto][scrypt][bench][.]")
+{
+    auto time = [](unsigned long r) -> double
+    {
+        const std::string password = "password";
+        const std::string salt = "salt";
+        const int runs = 5;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+        {
+            abcd::AutoU08Buf out;
+            tABC_Error error;
+            REQUIRE(ABC_CC_Ok == abcd::ABC_CryptoScrypt(
+                abcd::toU08Buf(password), abcd::toU08Buf(salt),
+                16384, r, 1, 32, &out, &error));
+        }
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / runs;
+    };
+
+    // The login parameters, and a heavier client-side setting:
+    for (unsigned long r: {1, 8})
+    {
+        REQUIRE(0 == crypto_scrypt_use_sse2(0));
+        double portable = time(r);
+
+        std::stringstream message;
+        message << "N=16384 r=" << r << ": portable " << portable << " ms";
+        if (0 == crypto_scrypt_use_sse2(1))
+        {
+            double sse2 = time(r);
+            message << ", sse2 " << sse2 << " ms"
+                << " (" << portable / sse2 << "x)";
+        }
+        WARN(message.str());
     }
 }
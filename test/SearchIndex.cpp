@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/util/SearchIndex.hpp"
+#include "../minilibs/catch/catch.hpp"
+
+static std::list<std::string>
+sorted(std::list<std::string> ids)
+{
+    ids.sort();
+    return ids;
+}
+
+TEST_CASE("SearchIndex matching", "[util][search]")
+{
+    abcd::SearchIndex index;
+    index.insert("a", {"Coffee Shop", "Food", "latte"});
+    index.insert("b", {"Gas Station", "Transportation", ""});
+    index.insert("c", {"Bitcoin Coffee", "", "12345"});
+
+    SECTION("long queries")
+    {
+        CHECK(sorted(index.search("coffee")) == std::list<std::string>({"a", "c"}));
+        CHECK(index.search("STATION") == std::list<std::string>({"b"}));
+        CHECK(index.search("234") == std::list<std::string>({"c"}));
+    }
+    SECTION("short queries")
+    {
+        CHECK(sorted(index.search("Ga")) == std::list<std::string>({"b"}));
+        CHECK(sorted(index.search("o")).size() == 3);
+    }
+    SECTION("no match")
+    {
+        CHECK(index.search("").empty());
+        CHECK(index.search("tea").empty());
+        // The trigrams all exist, but not in this order:
+        CHECK(index.search("eeffoc").empty());
+        // Matches should not span fields:
+        CHECK(index.search("shopfood").empty());
+    }
+}
+
+TEST_CASE("SearchIndex updates", "[util][search]")
+{
+    abcd::SearchIndex index;
+    index.insert("a", {"Coffee Shop"});
+    index.insert("b", {"Gas Station"});
+
+    index.insert("a", {"Tea House"});
+    CHECK(index.search("coffee").empty());
+    CHECK(index.search("tea") == std::list<std::string>({"a"}));
+
+    index.erase("b");
+    CHECK(index.search("gas").empty());
+
+    // Reuses the erased slot:
+    index.insert("c", {"Gas Pump"});
+    CHECK(index.search("gas") == std::list<std::string>({"c"}));
+    CHECK(index.search("station").empty());
+}
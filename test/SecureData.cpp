@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/util/SecureData.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include <stdint.h>
+#include <unistd.h>
+
+TEST_CASE("SecureChunk behaves like a DataChunk", "[util][secure]")
+{
+    abcd::SecureChunk data;
+    for (int i = 0; i < 10000; ++i)
+        data.push_back(i);
+    REQUIRE(10000u == data.size());
+    for (size_t i = 0; i < data.size(); ++i)
+        REQUIRE(static_cast<uint8_t>(i) == data[i]);
+
+    abcd::SecureChunk copy = data;
+    CHECK(copy == data);
+    data.clear();
+    data.shrink_to_fit();
+    CHECK(10000u == copy.size());
+}
+
+TEST_CASE("secureAlloc gives whole pages", "[util][secure]")
+{
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    for (size_t size: {0, 1, 100, 4096, 5000})
+    {
+        void *p = abcd::secureAlloc(size);
+        REQUIRE(nullptr != p);
+        CHECK(0u == reinterpret_cast<uintptr_t>(p) % page);
+        abcd::secureFree(p, size);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/bitcoin/Spendable.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+/**
+ * The old way of finding the maximum, one satoshi at a time.
+ */
+static uint64_t
+linearSearch(uint64_t estimate, abcd::SpendTest test)
+{
+    uint64_t amount = estimate;
+    while (!test(amount) && 0 < amount)
+        --amount;
+    return amount;
+}
+
+TEST_CASE("Spendable search", "[bitcoin][spendable]")
+{
+    for (uint64_t limit: {0, 1, 2, 3, 500, 999, 1000, 5429, 5430})
+    {
+        auto test = [limit](uint64_t amount) { return amount <= limit; };
+        for (uint64_t estimate: {0, 1, 2, 7, 1000, 5430, 100000})
+            REQUIRE(linearSearch(estimate, test) ==
+                abcd::spendableSearch(estimate, test));
+    }
+
+    // Nothing passes:
+    auto never = [](uint64_t) { return false; };
+    CHECK(0 == abcd::spendableSearch(12345, never));
+
+    // The estimate passes, so there is no need to look further:
+    unsigned calls = 0;
+    auto always = [&calls](uint64_t) { ++calls; return true; };
+    CHECK(12345 == abcd::spendableSearch(12345, always));
+    CHECK(1 == calls);
+}
+
+// Hidden, since it is slow. Run with `abc-test "[bench]"`.
+TEST_CASE("Spendable benchmark", "[bitcoin][spendable][bench][.]")
+{
+    // Each test stands in for building a transaction, which means sorting
+    // the wallet's outputs and checking that something isn't dust:
+    const uint64_t dust = 5430;
+    const uint64_t fee = 1000;
+    std::vector<uint64_t> utxos;
+    for (unsigned i = 0; i < 200; ++i)
+        utxos.push_back(37 * i % 101);
+
+    unsigned builds = 0;
+    auto build = [&](uint64_t amount, uint64_t balance)
+    {
+        ++builds;
+        auto sorted = utxos;
+        std::sort(sorted.begin(), sorted.end());
+        if (balance < amount + fee || sorted.empty())
+            return false;
+        uint64_t change = balance - amount - fee;
+        return dust <= amount || dust <= change;
+    };
+
+    // Balances that leave less than a dust output after fees,
+    // which is where the old loop had to step all the way down:
+    unsigned slowBuilds = 0, fastBuilds = 0;
+    std::chrono::duration<double> slowTime(0), fastTime(0);
+    for (uint64_t balance = fee; balance < fee + dust; balance += 97)
+    {
+        uint64_t estimate = balance - fee;
+        auto test = [&](uint64_t amount) { return build(amount, balance); };
+
+        builds = 0;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t slow = linearSearch(estimate, test);
+        slowTime += std::chrono::steady_clock::now() - start;
+        slowBuilds += builds;
+
+        builds = 0;
+        start = std::chrono::steady_clock::now();
+        uint64_t fast = abcd::spendableSearch(estimate, test);
+        fastTime += std::chrono::steady_clock::now() - start;
+        fastBuilds += builds;
+
+        REQUIRE(slow == fast);
+    }
+
+    std::stringstream message;
+    message << "one satoshi at a time: " << slowBuilds << " builds, " <<
+        slowTime.count() * 1000 << " ms; search: " << fastBuilds <<
+        " builds, " << fastTime.count() * 1000 << " ms (" <<
+        slowTime.count() / fastTime.count() << "x faster)";
+    WARN(message.str());
+}
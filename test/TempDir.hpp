@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+/**
+ * @file
+ * Scratch directories for tests that touch the filesystem.
+ */
+
+#ifndef TEST_TEMP_DIR_HPP
+#define TEST_TEMP_DIR_HPP
+
+#include "../minilibs/catch/catch.hpp"
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+/**
+ * A fresh directory under /tmp, which is removed along with everything
+ * in it when the test is done.
+ */
+class TempDir
+{
+public:
+    TempDir()
+    {
+        char dir[] = "/tmp/abc-test-XXXXXX";
+        REQUIRE(mkdtemp(dir));
+        path_ = dir;
+    }
+
+    ~TempDir()
+    {
+        nftw(path_.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    TempDir(const TempDir &) = delete;
+    TempDir &operator=(const TempDir &) = delete;
+
+    const std::string &path() const { return path_; }
+
+    /**
+     * Returns the path to a file within the directory.
+     */
+    std::string path(const std::string &name) const
+    {
+        return path_ + "/" + name;
+    }
+
+private:
+    std::string path_;
+
+    static int
+    removeEntry(const char *path, const struct stat *, int, struct FTW *)
+    {
+        return remove(path);
+    }
+};
+
+#endif
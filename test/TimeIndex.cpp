@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/util/TimeIndex.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+static std::vector<std::string>
+ids(abcd::TimeRange range)
+{
+    std::vector<std::string> out;
+    for (auto i = range.first; i != range.second; ++i)
+        out.push_back(i->second);
+    return out;
+}
+
+TEST_CASE("TimeIndex ranges", "[util][time]")
+{
+    abcd::TimeIndex index;
+    index.insert(abcd::TimeKey(100, "a"));
+    index.insert(abcd::TimeKey(200, "b"));
+    index.insert(abcd::TimeKey(200, "c"));
+    index.insert(abcd::TimeKey(300, "d"));
+
+    SECTION("normal ranges")
+    {
+        CHECK(ids(abcd::timeIndexRange(index, 0, 1000)) ==
+            std::vector<std::string>({"a", "b", "c", "d"}));
+        CHECK(ids(abcd::timeIndexRange(index, 200, 300)) ==
+            std::vector<std::string>({"b", "c"}));
+        CHECK(ids(abcd::timeIndexRange(index, 150, 250)) ==
+            std::vector<std::string>({"b", "c"}));
+        CHECK(ids(abcd::timeIndexRange(index, 400, 500)).empty());
+    }
+
+    SECTION("inverted ranges")
+    {
+        CHECK(ids(abcd::timeIndexRange(index, 300, 100)).empty());
+        CHECK(ids(abcd::timeIndexRange(index, 1000, 0)).empty());
+        CHECK(ids(abcd::timeIndexRange(index, 200, 200)).empty());
+
+        auto range = abcd::timeIndexRange(index, 250, 150);
+        CHECK(0 == std::distance(range.first, range.second));
+    }
+}
+
+TEST_CASE("TimeIndex cursors", "[util][time]")
+{
+    abcd::TimeIndex index;
+    for (int i = 1; i <= 5; ++i)
+        index.insert(abcd::TimeKey(100 * i, std::string(1, 'a' + i - 1)));
+    auto window = abcd::timeIndexRange(index, 200, 500); // b, c, d
+
+    SECTION("cursors inside the window")
+    {
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(200, "b"), false)) ==
+            std::vector<std::string>({"c", "d"}));
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(400, "d"), true)) ==
+            std::vector<std::string>({"b", "c"}));
+    }
+
+    SECTION("stale cursors")
+    {
+        // The transaction the cursor points at has gone away:
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(250, "x"), false)) ==
+            std::vector<std::string>({"c", "d"}));
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(250, "x"), true)) ==
+            std::vector<std::string>({"b"}));
+
+        // Cursors past either end of the window:
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(500, "e"), false)).empty());
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(100, "a"), true)).empty());
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(100, "a"), false)) ==
+            std::vector<std::string>({"b", "c", "d"}));
+        CHECK(ids(abcd::timeIndexAfter(index, window,
+            abcd::TimeKey(900, "z"), true)) ==
+            std::vector<std::string>({"b", "c", "d"}));
+    }
+
+    SECTION("inverted ranges")
+    {
+        auto empty = abcd::timeIndexRange(index, 400, 200);
+        for (bool newestFirst: {false, true})
+        {
+            for (auto cursor: {abcd::TimeKey(0, ""), abcd::TimeKey(300, "c"),
+                               abcd::TimeKey(900, "z")})
+            {
+                auto range = abcd::timeIndexAfter(index, empty, cursor,
+                    newestFirst);
+                CHECK(range.first == range.second);
+            }
+        }
+    }
+
+    SECTION("paging visits everything once")
+    {
+        for (bool newestFirst: {false, true})
+        {
+            std::vector<std::string> seen;
+            auto range = abcd::timeIndexRange(index, 0, 1000);
+            while (range.first != range.second)
+            {
+                auto i = newestFirst ? std::prev(range.second) : range.first;
+                seen.push_back(i->second);
+                range = abcd::timeIndexAfter(index,
+                    abcd::timeIndexRange(index, 0, 1000), *i, newestFirst);
+            }
+            if (newestFirst)
+                std::reverse(seen.begin(), seen.end());
+            CHECK(seen == std::vector<std::string>({"a", "b", "c", "d", "e"}));
+        }
+    }
+}
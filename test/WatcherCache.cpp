@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/bitcoin/WatcherCache.hpp"
+#include "../abcd/util/FileIO.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include "TempDir.hpp"
+
+TEST_CASE("Watcher cache round trip", "[bitcoin][watcher]")
+{
+    TempDir tmp;
+    const std::string filename = tmp.path("watcher.ser");
+    abcd::DataChunk db;
+    for (unsigned i = 0; i < 5000; ++i)
+        db.push_back(i * 7);
+
+    REQUIRE(abcd::fileSave(abcd::watcherCacheEncode(db), filename));
+    abcd::DataChunk result;
+    REQUIRE(abcd::watcherCacheLoad(result, filename));
+    CHECK(result == db);
+}
+
+TEST_CASE("Watcher cache without a header", "[bitcoin][watcher]")
+{
+    TempDir tmp;
+    const std::string filename = tmp.path("watcher.ser");
+    const std::string db = "old-style database";
+
+    REQUIRE(abcd::fileSave(db, filename));
+    abcd::DataChunk result;
+    REQUIRE(abcd::watcherCacheLoad(result, filename));
+    CHECK(abcd::toString(result) == db);
+}
+
+TEST_CASE("Damaged watcher cache", "[bitcoin][watcher]")
+{
+    TempDir tmp;
+    const std::string filename = tmp.path("watcher.ser");
+    abcd::DataChunk file = abcd::watcherCacheEncode(std::string("database"));
+    abcd::DataChunk result;
+
+    SECTION("flipped bit")
+    {
+        file.back() ^= 1;
+        REQUIRE(abcd::fileSave(file, filename));
+        CHECK_FALSE(abcd::watcherCacheLoad(result, filename));
+    }
+
+    SECTION("truncated")
+    {
+        file.pop_back();
+        REQUIRE(abcd::fileSave(file, filename));
+        CHECK_FALSE(abcd::watcherCacheLoad(result, filename));
+    }
+
+    SECTION("newer version")
+    {
+        file[7] += 1;
+        REQUIRE(abcd::fileSave(file, filename));
+        CHECK_FALSE(abcd::watcherCacheLoad(result, filename));
+    }
+
+    SECTION("missing")
+    {
+        CHECK_FALSE(abcd::watcherCacheLoad(result, filename));
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2015, AirBitz, Inc.
+ * All rights reserved.
+ *
+ * See the LICENSE file for more information.
+ */
+
+#include "../abcd/util/WorkerPool.hpp"
+#include "../minilibs/catch/catch.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("WorkerPool runs every task once", "[util][pool]")
+{
+    for (size_t count: {0, 1, 2, 7, 1000})
+    {
+        std::vector<std::atomic<unsigned>> calls(count);
+        for (auto &c: calls)
+            c = 0;
+
+        abcd::workerPoolRun(count, [&](size_t i) { ++calls[i]; });
+        for (auto &c: calls)
+            REQUIRE(1u == c.load());
+    }
+}
+
+TEST_CASE("WorkerPool nested and concurrent batches", "[util][pool]")
+{
+    std::atomic<unsigned> total(0);
+
+    // Tasks that start batches of their own:
+    abcd::workerPoolRun(8, [&](size_t)
+    {
+        abcd::workerPoolRun(8, [&](size_t) { ++total; });
+    });
+    CHECK(64u == total.load());
+
+    // Several threads sharing the pool at once:
+    total = 0;
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; ++i)
+        callers.emplace_back([&]()
+        {
+            for (int j = 0; j < 50; ++j)
+                abcd::workerPoolRun(10, [&](size_t) { ++total; });
+        });
+    for (auto &caller: callers)
+        caller.join();
+    CHECK(2000u == total.load());
+}